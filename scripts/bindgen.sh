@@ -0,0 +1,5 @@
+#!/bin/sh
+# Regenerates binding_qjs.h and binding_types.d.ts from binding_types.hpp;
+# same as bindgen.bat
+cd "$(dirname "$0")/.." || exit 1
+npx breeze-bindgen@latest -i src/shell/script/binding_types.hpp --nameFilter mb_shell::js -o src/shell/script --extTypesPath scripts/additional-types.txt --tsModuleName mshell
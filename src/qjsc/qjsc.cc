@@ -0,0 +1,107 @@
+// Build-time compiler for the embedded breeze-script.js runtime.
+//
+//   breeze-qjsc <input.js> <output.h> <module name> <symbol>
+//
+// Compiles <input.js> as an ES module with the same QuickJS sources the
+// shell links against, and writes its bytecode as
+//   static const char <symbol>_qjs_build_id[] = "...";
+//   static const unsigned char <symbol>[] = {...};
+// so the shell only has to JS_ReadObject it instead of parsing ~130 KB of
+// JavaScript in every new runtime.
+
+#include <cstdio>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+
+#include "quickjs.h"
+#include "shell/script/qjs_build_id.h"
+
+// Imports are resolved against the real modules when the bytecode is
+// loaded, so an empty native module is enough to compile against
+static JSModuleDef *stub_module_loader(JSContext *ctx, const char *name,
+                                       void *) {
+    return JS_NewCModule(ctx, name, nullptr);
+}
+
+static void print_exception(JSContext *ctx) {
+    auto exception = JS_GetException(ctx);
+    auto message = JS_ToCString(ctx, exception);
+    std::cerr << (message ? message : "unknown error") << std::endl;
+    JS_FreeCString(ctx, message);
+
+    auto stack = JS_GetPropertyStr(ctx, exception, "stack");
+    if (auto str = JS_ToCString(ctx, stack)) {
+        std::cerr << str << std::endl;
+        JS_FreeCString(ctx, str);
+    }
+    JS_FreeValue(ctx, stack);
+    JS_FreeValue(ctx, exception);
+}
+
+int main(int argc, char **argv) {
+    if (argc != 5) {
+        std::cerr << "usage: breeze-qjsc <input.js> <output.h> <module name> "
+                     "<symbol>"
+                  << std::endl;
+        return 1;
+    }
+
+    std::ifstream input(argv[1], std::ios::binary);
+    if (!input) {
+        std::cerr << "Failed to open " << argv[1] << std::endl;
+        return 1;
+    }
+    std::string source((std::istreambuf_iterator<char>(input)),
+                       std::istreambuf_iterator<char>());
+
+    auto rt = JS_NewRuntime();
+    JS_SetModuleLoaderFunc(rt, nullptr, stub_module_loader, nullptr);
+    auto ctx = JS_NewContext(rt);
+
+    int res = 1;
+    auto func = JS_Eval(ctx, source.c_str(), source.size(), argv[3],
+                        JS_EVAL_TYPE_MODULE | JS_EVAL_FLAG_COMPILE_ONLY);
+    if (JS_IsException(func)) {
+        std::cerr << "Failed to compile " << argv[1] << ": ";
+        print_exception(ctx);
+    } else {
+        // Without the source text the bytecode is about the size of the
+        // minified script; debug info is kept for line numbers in stacks
+        size_t size = 0;
+        auto bytecode =
+            JS_WriteObject(ctx, &size, func,
+                           JS_WRITE_OBJ_BYTECODE | JS_WRITE_OBJ_STRIP_SOURCE);
+        if (!bytecode) {
+            std::cerr << "Failed to serialize " << argv[1] << ": ";
+            print_exception(ctx);
+        } else {
+            std::string out = std::format(
+                "// Generated by breeze-qjsc from {}, do not edit\n"
+                "static const char {}_qjs_build_id[] = \"{}\";\n"
+                "static const unsigned char {}[] = {{",
+                argv[1], argv[4], mb_shell::qjs_build_id(), argv[4]);
+            for (size_t i = 0; i < size; i++) {
+                out += std::format("{}0x{:02x},", i % 16 ? " " : "\n    ",
+                                   bytecode[i]);
+            }
+            out += "\n};\n";
+            js_free(ctx, bytecode);
+            JS_FreeValue(ctx, func);
+
+            std::ofstream output(argv[2], std::ios::binary | std::ios::trunc);
+            output << out;
+            if (output) {
+                res = 0;
+            } else {
+                std::cerr << "Failed to write " << argv[2] << std::endl;
+            }
+        }
+    }
+
+    JS_FreeContext(ctx);
+    JS_FreeRuntime(rt);
+    return res;
+}
@@ -10,8 +10,12 @@
 #include "rfl/DefaultIfMissing.hpp"
 #include "rfl/json.hpp"
 
+#include "file_reloader.h"
 #include "utils.h"
+#include "versioned_snapshot.h"
 #include "i18n_manager.h"
+#include "trace.h"
+#include "script/js_profiler.h"
 #include "windows.h"
 
 namespace rfl {
@@ -29,12 +33,18 @@ template <> struct Reflector<mb_shell::paint_color> {
 } // namespace rfl
 
 namespace mb_shell {
-std::unique_ptr<config> config::current;
-config::animated_float_conf config::_default_animation{
+static versioned_snapshot<config> snapshot;
+
+std::shared_ptr<const config> config::current() { return snapshot.load(); }
+uint64_t config::generation() { return snapshot.generation(); }
+
+static const config::animated_float_conf builtin_default_animation{
     .duration = 150,
     .easing = ui::easing_type::ease_in_out,
     .delay_scale = 1,
 };
+config::animated_float_conf config::_default_animation =
+    builtin_default_animation;
 
 void config::write_config() {
     auto config_file = data_directory() / "config.json";
@@ -44,10 +54,12 @@ void config::write_config() {
         return;
     }
 
-    ofs << rfl::json::write(*config::current);
+    ofs << rfl::json::write(*config::current());
 }
 void config::read_config() {
+    trace::span span("config::read_config");
     auto config_file = data_directory() / "config.json";
+    std::unique_ptr<config> next;
 
 #ifdef __llvm__
     std::ifstream ifs(config_file);
@@ -66,27 +78,41 @@ void config::read_config() {
         std::cerr
             << "Config file could not be opened. Using default config instead."
             << std::endl;
-        config::current = std::make_unique<config>();
-        config::current->debug_console = true;
+        next = std::make_unique<config>();
+        next->debug_console = true;
     } else {
         std::string json_str;
         std::copy(std::istreambuf_iterator<char>(ifs),
                   std::istreambuf_iterator<char>(),
                   std::back_inserter(json_str));
 
-        if (auto json = rfl::json::read<config, rfl::NoExtraFields,
-                                        rfl::DefaultIfMissing>(json_str)) {
-            // parse twice for default value
-            _default_animation = json.value().default_animation;
-            json = rfl::json::read<config, rfl::NoExtraFields,
-                                   rfl::DefaultIfMissing>(json_str);
-            config::current = std::make_unique<config>(json.value());
+        // Parse the JSON once. default_animation is resolved from the DOM
+        // first, because it provides the defaults of every other animation
+        // field when the struct is materialized.
+        auto json = rfl::json::read<rfl::Generic>(json_str).and_then(
+            [](const rfl::Generic &dom) {
+                _default_animation = builtin_default_animation;
+                if (auto obj = dom.to_object()) {
+                    if (auto anim = obj->get("default_animation")) {
+                        if (auto conf = rfl::from_generic<animated_float_conf,
+                                                          rfl::DefaultIfMissing>(
+                                *anim)) {
+                            _default_animation = conf.value();
+                        }
+                    }
+                }
+                return rfl::from_generic<config, rfl::NoExtraFields,
+                                         rfl::DefaultIfMissing>(dom);
+            });
+
+        if (json) {
+            next = std::make_unique<config>(json.value());
             std::cout << "Config reloaded." << std::endl;
         } else {
             std::cerr << "Failed to read config file: " << json.error().what()
                       << "\nUsing default config instead." << std::endl;
-            config::current = std::make_unique<config>();
-            config::current->debug_console = true;
+            next = std::make_unique<config>();
+            next->debug_console = true;
         }
     }
 #else
@@ -94,25 +120,87 @@ void config::read_config() {
     "We don't support loading config file on MSVC because of a bug in MSVC."
     dbgout("We don't support loading config file when compiled with MSVC "
            "because of a bug in MSVC.");
-    config::current = std::make_unique<config>();
-    config::current->debug_console = true;
+    next = std::make_unique<config>();
+    next->debug_console = true;
 #endif
 
-    if (config::current->debug_console) {
-        ShowWindow(GetConsoleWindow(), SW_SHOW);
-    } else {
-        ShowWindow(GetConsoleWindow(), SW_HIDE);
+    // Readers still holding the previous snapshot keep it alive until they
+    // are done with it
+    std::shared_ptr<const config> loaded = std::move(next);
+    auto previous = snapshot.publish(loaded);
+
+    // Only follow the config when it changes, so tracing switched on from a
+    // script survives unrelated reloads
+    if (!previous || previous->debug_trace != loaded->debug_trace) {
+        trace::set_enabled(loaded->debug_trace);
+    }
+    if (!previous || previous->debug_profile != loaded->debug_profile) {
+        js_profiler::set_enabled(loaded->debug_profile);
+    }
+
+    // On first load everything counts as changed
+    auto changed = previous ? changes::between(*previous, *loaded)
+                            : changes{true, true, true, true, true, true};
+    if (previous && !changed.any()) {
+        dbgout("Config reloaded, nothing changed");
+        return;
+    }
+
+    if (changed.debug_console) {
+        if (loaded->debug_console) {
+            ShowWindow(GetConsoleWindow(), SW_SHOW);
+        } else {
+            ShowWindow(GetConsoleWindow(), SW_HIDE);
+        }
+    }
+
+    if (previous && (changed.fonts || changed.hooks)) {
+        dbgout("Font/hook changes take effect after restart");
     }
-    
+
     // Initialize/update i18n manager with config language preference
-    auto& i18n = i18n_manager::instance();
-    if (config::current->language) {
-        i18n.set_language(*config::current->language);
-    } else {
-        i18n.reload();
+    if (changed.language) {
+        auto &i18n = i18n_manager::instance();
+        if (loaded->language) {
+            i18n.set_language(*loaded->language);
+        } else {
+            i18n.reload();
+        }
     }
 }
 
+bool config::changes::any() const {
+    return theme || animation || fonts || hooks || language || debug_console;
+}
+
+config::changes config::changes::between(const config &from,
+                                         const config &to) {
+    auto same = [](const auto &a, const auto &b) {
+        return rfl::json::write(a) == rfl::json::write(b);
+    };
+
+    auto theme_without_animation = [](context_menu::theme theme) {
+        theme.animation = {};
+        return theme;
+    };
+
+    changes res;
+    res.theme = !same(theme_without_animation(from.context_menu.theme),
+                      theme_without_animation(to.context_menu.theme));
+    res.animation =
+        !same(from.default_animation, to.default_animation) ||
+        !same(from.context_menu.theme.animation,
+              to.context_menu.theme.animation) ||
+        !same(from.taskbar.theme.animation, to.taskbar.theme.animation);
+    res.fonts = from.font_path_main != to.font_path_main ||
+                from.font_path_fallback != to.font_path_fallback ||
+                from.font_path_monospace != to.font_path_monospace;
+    res.hooks = from.res_string_loader_use_hook != to.res_string_loader_use_hook;
+    res.language = from.language != to.language;
+    res.debug_console = from.debug_console != to.debug_console;
+    return res;
+}
+
 std::filesystem::path config::data_directory() {
     static std::optional<std::filesystem::path> path;
     static std::mutex mtx;
@@ -133,25 +221,26 @@ void config::run_config_loader() {
     auto config_path = config::data_directory() / "config.json";
     dbgout("config file: {}", config_path.string());
     config::read_config();
-    std::thread([config_path]() {
-        auto last_mod = std::filesystem::last_write_time(config_path);
-        while (true) {
-            if (std::filesystem::last_write_time(config_path) != last_mod) {
-                last_mod = std::filesystem::last_write_time(config_path);
-                config::read_config();
-            }
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
-        }
-    }).detach();
+
+    try {
+        static file_reloader reloader(config_path,
+                                      [] { config::read_config(); });
+        std::thread([] {
+            set_thread_name("breeze::config_loader");
+            reloader.run();
+        }).detach();
+    } catch (const std::exception &e) {
+        std::cerr << "Failed to watch config file: " << e.what() << std::endl;
+    }
 }
 void config::animated_float_conf::apply_to(ui::sp_anim_float &anim,
-                                           float delay) {
+                                           float delay) const {
     anim->set_duration(duration);
     anim->set_easing(easing);
     anim->set_delay(delay * delay_scale);
 }
 void config::animated_float_conf::operator()(ui::sp_anim_float &anim,
-                                             float delay) {
+                                             float delay) const {
     apply_to(anim, delay);
 }
 
@@ -162,12 +251,14 @@ std::filesystem::path config::default_main_font() {
 std::filesystem::path config::default_fallback_font() {
     return std::filesystem::path(env("WINDIR").value()) / "Fonts" / "msyh.ttc";
 }
-std::string config::dump_config() { return rfl::json::write(*config::current); }
+std::string config::dump_config() {
+    return rfl::json::write(*config::current());
+}
 std::filesystem::path config::default_mono_font() {
     return std::filesystem::path(env("WINDIR").value()) / "Fonts" /
            "consola.ttf";
 }
-void config::apply_fonts_to_nvg(NVGcontext *nvg) {
+void config::apply_fonts_to_nvg(NVGcontext *nvg) const {
     nvgCreateFont(nvg, "main", font_path_main.string().c_str());
     nvgCreateFont(nvg, "fallback", font_path_fallback.string().c_str());
     nvgCreateFont(nvg, "monospace", font_path_monospace.string().c_str());
@@ -175,7 +266,7 @@ void config::apply_fonts_to_nvg(NVGcontext *nvg) {
     nvgAddFallbackFont(nvg, "monospace", "main");
 }
 void config::animated_float_conf::apply_to(ui::animated_color &anim,
-                                           float delay) {
+                                           float delay) const {
     apply_to(anim.r, delay);
     apply_to(anim.g, delay);
     apply_to(anim.b, delay);
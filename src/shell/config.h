@@ -4,6 +4,7 @@
 #include "breeze_ui/nanovg_wrapper.h"
 #include "nanovg.h"
 #include "utils.h"
+#include <cstdint>
 #include <filesystem>
 #include <memory>
 #include <numbers>
@@ -23,9 +24,9 @@ struct config {
         ui::easing_type easing = _default_animation.easing;
         float delay_scale = _default_animation.delay_scale;
 
-        void apply_to(ui::sp_anim_float &anim, float delay = 0);
-        void apply_to(ui::animated_color &anim, float delay = 0);
-        void operator()(ui::sp_anim_float &anim, float delay = 0);
+        void apply_to(ui::sp_anim_float &anim, float delay = 0) const;
+        void apply_to(ui::animated_color &anim, float delay = 0) const;
+        void operator()(ui::sp_anim_float &anim, float delay = 0) const;
     } default_animation;
 
     static animated_float_conf _default_animation;
@@ -95,6 +96,13 @@ struct config {
         bool experimental_ownerdraw_support = false;
         bool hotkeys = true;
         bool show_settings_button = true;
+        // Time each menu listener may take before the menu is shown, 0 for
+        // no limit. Off by default, since listeners that are aborted or
+        // deferred may leave a menu without the items they would add.
+        int listener_budget_ms = 0;
+        // Run listeners of plugins that went over budget after the menu is
+        // shown instead
+        bool defer_slow_listeners = false;
 
         // debug purpose only
         bool search_large_dwItemData_range = false;
@@ -115,6 +123,10 @@ struct config {
     } taskbar;
 
     bool debug_console = false;
+    // Record trace spans, exported with breeze.export_trace()
+    bool debug_trace = false;
+    // Sample JS stacks per plugin, exported with breeze.export_profile()
+    bool debug_profile = false;
     // Restart to apply font/hook changes
     std::filesystem::path font_path_main = default_main_font();
     std::filesystem::path font_path_fallback = default_fallback_font();
@@ -122,18 +134,43 @@ struct config {
     bool res_string_loader_use_hook = false;
     bool avoid_resize_ui = false;
     std::vector<std::string> plugin_load_order = {};
+    // Threads shared by the *_async script APIs, in total and per plugin
+    int async_worker_threads = 8;
+    int async_worker_threads_per_plugin = 4;
     
     // Language preference override (uses system language if nullopt)
     std::optional<std::string> language;
 
     std::string $schema;
-    static std::unique_ptr<config> current;
+
+    // Sections that differ between two configs, so a reload only triggers
+    // the reactions (i18n reload, console toggle...) it actually needs
+    struct changes {
+        // context_menu.theme, excluding animations
+        bool theme = false;
+        // default_animation and every animation section
+        bool animation = false;
+        bool fonts = false;
+        bool hooks = false;
+        bool language = false;
+        bool debug_console = false;
+
+        bool any() const;
+        static changes between(const config &from, const config &to);
+    };
+
+    // The config is never mutated after loading: a reload publishes a new
+    // immutable snapshot atomically. Readers hold the returned pointer for
+    // the whole frame/operation instead of calling current() per field.
+    static std::shared_ptr<const config> current();
+    // Incremented every time a new snapshot is published
+    static uint64_t generation();
     static void read_config();
     static void write_config();
     static void run_config_loader();
     static std::string dump_config();
 
     static std::filesystem::path data_directory();
-    void apply_fonts_to_nvg(NVGcontext *nvg);
+    void apply_fonts_to_nvg(NVGcontext *nvg) const;
 };
 } // namespace mb_shell
\ No newline at end of file
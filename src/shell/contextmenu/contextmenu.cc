@@ -12,6 +12,7 @@
 #include "shell/res_string_loader.h"
 
 #include "shell/logger.h"
+#include "shell/trace.h"
 
 #include "shell/entry.h"
 
@@ -135,6 +136,7 @@ std::vector<std::string> extract_hotkeys(const std::string &name) {
 menu menu::construct_with_hmenu(
     HMENU hMenu, HWND hWnd, bool is_top,
     std::function<void(int, WPARAM, LPARAM)> HandleMenuMsg) {
+    trace::span span("menu::construct_with_hmenu");
     menu m;
 
     if (!HandleMenuMsg)
@@ -159,7 +161,7 @@ menu menu::construct_with_hmenu(
         }
 
         if ((info.fType & MFT_OWNERDRAW) &&
-            config::current->context_menu.experimental_ownerdraw_support) {
+            config::current()->context_menu.experimental_ownerdraw_support) {
             auto od = getBitmapFromOwnerDraw(&info, hWnd);
             if (od.width && od.height) {
                 item.owner_draw = od;
@@ -205,7 +207,7 @@ menu menu::construct_with_hmenu(
         } else {
             item.name = wstring_to_utf8(strip_extra_infos(buffer));
             item.origin_name = wstring_to_utf8(buffer);
-            if (config::current->context_menu.hotkeys) {
+            if (config::current()->context_menu.hotkeys) {
                 auto hotkeys = extract_hotkeys(item.origin_name.value());
                 if (!hotkeys.empty()) {
                     item.hotkey =
@@ -236,7 +238,8 @@ menu menu::construct_with_hmenu(
 
             if (!IS_INTRESOURCE(info.dwItemData)) {
                 auto offsets =
-                    config::current->context_menu.search_large_dwItemData_range
+                    config::current()
+                            ->context_menu.search_large_dwItemData_range
                         ? ([]() -> std::vector<int> {
                               std::vector<int> offsets;
                               for (int i = 0; i <= 0xfff; i++) {
@@ -271,7 +274,7 @@ menu menu::construct_with_hmenu(
                                 bitmap.bmBits != nullptr &&
                                 bitmap.bmBits != (void *)-1) {
                                 item.icon_bitmap = (size_t)result;
-                                if (config::current->context_menu
+                                if (config::current()->context_menu
                                         .search_large_dwItemData_range) {
                                     dbgout("Found icon at offset: {}", offset);
                                 }
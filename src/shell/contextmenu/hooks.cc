@@ -6,6 +6,7 @@
 #include "shell/config.h"
 #include "shell/entry.h"
 #include "shell/script/quickjspp.hpp"
+#include "shell/trace.h"
 
 #include "blook/blook.h"
 #include <atlcomcli.h>
@@ -30,6 +31,7 @@ mb_shell::track_popup_menu(mb_shell::menu menu, int x, int y,
         try {
             set_thread_name("breeze::context_menu_renderer");
             perf_counter perf("mb_shell::track_popup_menu");
+            trace::span span("track_popup_menu");
 
             bool shift_pressed = (GetKeyState(VK_SHIFT) & 0x8000) != 0;
 
@@ -74,7 +76,11 @@ mb_shell::track_popup_menu(mb_shell::menu menu, int x, int y,
             return std::optional<int>{};
         }
     });
-    qjs::wait_with_msgloop([&]() { selected_menu_future.wait(); });
+    // The renderer thread runs tasks in order, so this runs once the menu
+    // task above has finished and its future is ready
+    qjs::msgloop_waiter waiter;
+    renderer_thread.add_task([&]() { waiter.notify(); });
+    waiter.wait();
 
     auto selected_menu = selected_menu_future.get();
 
@@ -93,7 +99,7 @@ void mb_shell::context_menu_hooks::install_NtUserTrackPopupMenuEx_hook() {
     NtUserTrackHook->install(+[](HMENU hMenu, int64_t uFlags, int64_t x,
                                  int64_t y, HWND hWnd, int64_t lptpm) {
         if (GetPropW(hWnd, L"COwnerDrawPopupMenu_This") &&
-            config::current->context_menu.ignore_owner_draw) {
+            config::current()->context_menu.ignore_owner_draw) {
             return NtUserTrackHook->call_trampoline<int32_t>(hMenu, uFlags, x,
                                                              y, hWnd, lptpm);
         }
@@ -9,12 +9,15 @@
 #include "shell/entry.h"
 #include "shell/logger.h"
 #include "shell/script/binding_types.hpp"
+#include "shell/trace.h"
 #include <mutex>
 #include <thread>
 
 namespace mb_shell {
 std::optional<menu_render *> menu_render::current{};
 menu_render menu_render::create(int x, int y, menu menu, bool run_js) {
+    trace::span span("menu_render::create");
+    trace::counter("menu_items", menu.items.size());
     if (auto res = ui::render_target::init_global(); !res) {
         MessageBoxW(NULL, L"Failed to initialize global render target",
                     L"Error", MB_ICONERROR);
@@ -29,9 +32,9 @@ menu_render menu_render::create(int x, int y, menu menu, bool run_js) {
         rt->capture_all_input = true;
         rt->decorated = false;
         rt->topmost = true;
-        rt->vsync = config::current->context_menu.vsync;
+        rt->vsync = config::current()->context_menu.vsync;
 
-        if (config::current->avoid_resize_ui) {
+        if (config::current()->avoid_resize_ui) {
             rt->width = 3840;
             rt->height = 2159;
         }
@@ -53,7 +56,7 @@ menu_render menu_render::create(int x, int y, menu menu, bool run_js) {
             return std::nullopt;
         });
 
-        config::current->apply_fonts_to_nvg(rt->nvg);
+        config::current()->apply_fonts_to_nvg(rt->nvg);
         return rt;
     }();
     auto render = menu_render(rt, std::nullopt);
@@ -74,13 +77,13 @@ menu_render menu_render::create(int x, int y, menu menu, bool run_js) {
 
     rt->set_position(monitor_info.rcMonitor.left + 1,
                      monitor_info.rcMonitor.top + 1);
-    if (!config::current->avoid_resize_ui)
+    if (!config::current()->avoid_resize_ui)
         rt->resize(
             monitor_info.rcMonitor.right - monitor_info.rcMonitor.left - 2,
             monitor_info.rcMonitor.bottom - monitor_info.rcMonitor.top - 2);
 
     glfwMakeContextCurrent(rt->window);
-    glfwSwapInterval(config::current->context_menu.vsync ? 1 : 0);
+    glfwSwapInterval(config::current()->context_menu.vsync ? 1 : 0);
 
     rt->show();
     auto menu_wid = std::make_shared<mouse_menu_widget_main>(
@@ -106,7 +109,16 @@ menu_render menu_render::create(int x, int y, menu menu, bool run_js) {
     if (run_js) {
         dbgout("[perf] JS plugins start");
         auto before_js = rt->clock.now();
-        for (auto &listener : menu_callbacks_js) {
+        trace::span js_span("js::on_menu");
+        // Each listener waits for the JS thread, which may unload plugins
+        // meanwhile
+        decltype(menu_callbacks_js) listeners;
+        {
+            std::lock_guard lock(menu_callbacks_js_mutex);
+            listeners = menu_callbacks_js;
+        }
+        for (auto &listener : listeners) {
+            trace::span listener_span("js::on_menu listener");
             listener->operator()(menu_info);
         }
         dbgout("[perf] JS plugins costed {}ms",
@@ -9,6 +9,7 @@
 #include "menu_render.h"
 #include "nanovg.h"
 #include "shell/config.h"
+#include "shell/resolved_theme.h"
 #include "shell/utils.h"
 #include <algorithm>
 #include <iostream>
@@ -25,9 +26,13 @@ right_icon | right_icon_padding |
 void mb_shell::menu_item_normal_widget::render(ui::nanovg_context ctx) {
     super::render(ctx);
 
-    auto icon_width = config::current->context_menu.theme.font_size + 2;
+    // Pin the config snapshot for the whole frame
+    auto resolved = resolved_theme::current();
+    auto &theme = resolved->source->context_menu.theme;
+
+    auto icon_width = resolved->icon_width;
     auto has_icon = has_icon_padding || icon_img;
-    auto c = mb_shell::is_light_mode() ? 0 : 1;
+    auto c = resolved->foreground;
 
     if (item.type == menu_item::type::spacer) {
         ctx.fillColor(nvgRGBAf(c, c, c, 0.1 * *opacity / 255.f));
@@ -37,8 +42,7 @@ void mb_shell::menu_item_normal_widget::render(ui::nanovg_context ctx) {
 
     // Draw background
     ctx.fillColor(nvgRGBAf(c, c, c, *bg_opacity / 255.f));
-    float roundcorner = std::min(
-        height->dest() / 2, config::current->context_menu.theme.item_radius);
+    float roundcorner = std::min(height->dest() / 2, theme.item_radius);
     ctx.fillRoundedRect(*x + margin, *y, *width - margin * 2, *height,
                         roundcorner);
 
@@ -71,9 +75,7 @@ void mb_shell::menu_item_normal_widget::render(ui::nanovg_context ctx) {
     // Draw text
     ctx.fillColor(nvgRGBAf(c, c, c, *opacity / 255.f));
     ctx.fontFace("main");
-    auto font_size = config::current->context_menu.theme.font_size;
-    auto hotkey_padding = config::current->context_menu.theme.hotkey_padding;
-    ctx.fontSize(font_size);
+    ctx.fontSize(resolved->font_size);
     ctx.textAlign(NVG_ALIGN_LEFT | NVG_ALIGN_MIDDLE);
     if (item.name) {
         ctx.text(round(*x + padding +
@@ -116,7 +118,7 @@ void mb_shell::menu_item_normal_widget::render(ui::nanovg_context ctx) {
     if (item.hotkey && !item.hotkey->empty()) {
         auto t = ctx.transaction();
         ctx.fillColor(nvgRGBAf(c, c, c, *opacity / 255.f * 0.7));
-        ctx.fontSize(font_size * 0.9);
+        ctx.fontSize(resolved->hotkey_font_size);
         ctx.textAlign(NVG_ALIGN_RIGHT | NVG_ALIGN_MIDDLE);
         ctx.fontFace("monospace");
         auto hotkey_x = right_x - hotkey_padding;
@@ -131,7 +133,9 @@ float mb_shell::menu_item_normal_widget::measure_width(
         return 1;
     }
 
-    auto font_size = config::current->context_menu.theme.font_size;
+    // Pin the config snapshot for the whole frame
+    auto resolved = resolved_theme::current();
+
     float width = 0;
 
     // Left padding
@@ -139,10 +143,10 @@ float mb_shell::menu_item_normal_widget::measure_width(
 
     // Left icon
     if (has_icon_padding || icon_img)
-        width += icon_padding * 2 + font_size + 2;
+        width += icon_padding * 2 + resolved->icon_width;
 
     // Text
-    ctx.vg.fontSize(font_size);
+    ctx.vg.fontSize(resolved->font_size);
     if (item.name)
         width +=
             ctx.vg.measureText(item.name->c_str()).first + text_padding * 2;
@@ -150,9 +154,7 @@ float mb_shell::menu_item_normal_widget::measure_width(
     // Hotkey
     if (item.hotkey && !item.hotkey->empty()) {
         auto t = ctx.vg.transaction();
-        ctx.vg.fontSize(font_size * 0.9);
-        auto hotkey_padding =
-            config::current->context_menu.theme.hotkey_padding;
+        ctx.vg.fontSize(resolved->hotkey_font_size);
         ctx.vg.fontFace("monospace");
         width +=
             ctx.vg.measureText(item.hotkey->c_str()).first + hotkey_padding * 2;
@@ -160,7 +162,7 @@ float mb_shell::menu_item_normal_widget::measure_width(
 
     // Right icon space (always reserve if any item in menu has submenu)
     if (has_submenu_padding) {
-        width += font_size + 2 + right_icon_padding;
+        width += resolved->icon_width + right_icon_padding;
     }
 
     // Right padding
@@ -180,7 +182,7 @@ void mb_shell::menu_item_normal_widget::update(ui::update_context &ctx) {
     if (item.type == menu_item::type::spacer) {
         height->reset_to(1);
     } else {
-        height->reset_to(config::current->context_menu.theme.item_height);
+        height->reset_to(item_height);
     }
 
     if (item.disabled) {
@@ -242,17 +244,22 @@ void mb_shell::menu_item_normal_widget::update(ui::update_context &ctx) {
 }
 
 mb_shell::menu_widget::menu_widget() : super() {
-    gap = config::current->context_menu.theme.item_gap;
+    auto conf = config::current();
+    auto &theme = conf->context_menu.theme;
+    gap = theme.item_gap;
     width->set_easing(ui::easing_type::mutation);
     height->set_easing(ui::easing_type::mutation);
-    config::current->context_menu.theme.animation.main.y(y);
+    theme.animation.main.y(y);
     enable_scrolling = true;
     int c = mb_shell::is_light_mode() ? 0 : 1;
     scroll_bar_color = nvgRGBAf(c, c, c, 0.3);
-    scroll_bar_width = config::current->context_menu.theme.scrollbar_width;
-    scroll_bar_radius = config::current->context_menu.theme.scrollbar_radius;
+    scroll_bar_width = theme.scrollbar_width;
+    scroll_bar_radius = theme.scrollbar_radius;
 }
 void mb_shell::menu_widget::update(ui::update_context &ctx) {
+    // Pin the config snapshot for the whole frame
+    auto conf = config::current();
+
     if (dying_time) {
         if (dying_time.changed()) {
             y->animate_to(*y - 10);
@@ -287,7 +294,7 @@ void mb_shell::menu_widget::update(ui::update_context &ctx) {
 
         bg_submenu->dying_time = std::nullopt;
         bg_submenu->opacity->animate_to(
-            config::current->context_menu.theme.background_opacity * 255.f);
+            conf->context_menu.theme.background_opacity * 255.f);
         bg_submenu->x->animate_to(current_submenu->x->dest());
         bg_submenu->y->animate_to(current_submenu->y->dest() -
                                   bg_padding_vertical);
@@ -308,7 +315,7 @@ void mb_shell::menu_widget::update(ui::update_context &ctx) {
 
     reverse = (direction == popup_direction::top_left ||
                direction == popup_direction::top_right) &&
-              config::current->context_menu.reverse_if_open_to_up;
+              conf->context_menu.reverse_if_open_to_up;
 
     auto forkctx_1 = ctx.with_offset(*x, *y);
     update_children(forkctx_1, rendering_submenus);
@@ -558,9 +565,10 @@ void mb_shell::menu_item_normal_widget::reset_appear_animation(float delay) {
     opacity->reset_to(0);
     this->x->reset_to(-20);
 
-    config::current->context_menu.theme.animation.item.opacity(opacity, delay);
-    config::current->context_menu.theme.animation.item.x(x, delay);
-    config::current->context_menu.theme.animation.item.width(width);
+    auto conf = config::current();
+    conf->context_menu.theme.animation.item.opacity(opacity, delay);
+    conf->context_menu.theme.animation.item.x(x, delay);
+    conf->context_menu.theme.animation.item.width(width);
 
     opacity->animate_to(255);
     this->y->progress = 1;
@@ -642,7 +650,7 @@ void mb_shell::menu_widget::reset_animation(bool reverse) {
     // the show duration for the menu should be within 200ms
     float delay = std::min(200.f / children.size(), 30.f);
 
-    if (config::current->context_menu.reverse_if_open_to_up && reverse)
+    if (config::current()->context_menu.reverse_if_open_to_up && reverse)
         reverse = !reverse;
 
     for (size_t i = 0; i < children.size(); i++) {
@@ -677,12 +685,11 @@ std::pair<float, float> mb_shell::mouse_menu_widget_main::calculate_position(
         y = anchor_y;
     }
 
+    auto conf = config::current();
     auto padding_vertical =
-             config::current->context_menu.position.padding_horizontal *
-             ctx.rt.dpi_scale,
+             conf->context_menu.position.padding_horizontal * ctx.rt.dpi_scale,
          padding_horizontal =
-             config::current->context_menu.position.padding_vertical *
-             ctx.rt.dpi_scale;
+             conf->context_menu.position.padding_vertical * ctx.rt.dpi_scale;
 
     if (x < padding_vertical) {
         x = padding_vertical;
@@ -716,10 +723,9 @@ mb_shell::popup_direction mb_shell::mouse_menu_widget_main::calculate_direction(
     auto menu_width = menu_wid->measure_width(ctx);
     auto menu_height = menu_wid->measure_height(ctx);
 
-    auto padding_vertical =
-             config::current->context_menu.position.padding_horizontal,
-         padding_horizontal =
-             config::current->context_menu.position.padding_vertical;
+    auto conf = config::current();
+    auto padding_vertical = conf->context_menu.position.padding_horizontal,
+         padding_horizontal = conf->context_menu.position.padding_vertical;
 
     bool bottom_overflow = (anchor_y + menu_height * ctx.rt.dpi_scale >
                             ctx.screen.height - padding_vertical);
@@ -809,6 +815,15 @@ bool mb_shell::menu_item_normal_widget::check_hit(
 
 mb_shell::menu_item_normal_widget::menu_item_normal_widget(menu_item item)
     : super() {
+    auto metrics = resolved_theme::current()->item;
+    item_height = metrics.height;
+    text_padding = metrics.text_padding;
+    margin = metrics.margin;
+    padding = metrics.padding;
+    icon_padding = metrics.icon_padding;
+    right_icon_padding = metrics.right_icon_padding;
+    hotkey_padding = metrics.hotkey_padding;
+
     opacity->reset_to(0);
     this->item = item;
 }
@@ -865,7 +880,6 @@ void mb_shell::menu_item_normal_widget::reload_icon_img(
     else if (item.icon_svg) {
         std::string copy = item.icon_svg.value();
         auto svg = nsvgParse(copy.data(), "px", 96);
-        auto icon_width = config::current->context_menu.theme.font_size + 2;
         icon_img = ctx.imageFromSVG(svg, ctx.rt->dpi_scale);
     } else {
         icon_img = std::nullopt;
@@ -900,10 +914,11 @@ void mb_shell::menu_item_widget::reset_appear_animation(float delay) {
     for (auto &child : get_children<menu_item_widget>())
         child->reset_appear_animation(delay);
 }
+mb_shell::menu_item_parent_widget::menu_item_parent_widget()
+    : gap(config::current()->context_menu.theme.multibutton_line_gap) {}
 void mb_shell::menu_item_parent_widget::update(ui::update_context &ctx) {
     super::update(ctx);
     float x = 0;
-    float gap = config::current->context_menu.theme.multibutton_line_gap;
     float max_height = 0;
     for (auto &item : children) {
         item->x->reset_to(x);
@@ -1056,7 +1071,7 @@ mb_shell::screenside_button_group_widget::button_widget::button_widget(
 
     width->reset_to(30);
     height->reset_to(30);
-    config::current->context_menu.theme.animation.item.opacity(bg_opacity, 0);
+    config::current()->context_menu.theme.animation.item.opacity(bg_opacity, 0);
 }
 void mb_shell::screenside_button_group_widget::button_widget::update(
     ui::update_context &ctx) {
@@ -37,6 +37,8 @@ struct menu_item_ownerdraw_widget : public menu_item_widget {
 
 struct menu_item_parent_widget : public menu_item_widget {
     using super = menu_item_widget;
+    float gap;
+    menu_item_parent_widget();
     void update(ui::update_context &ctx) override;
     void reset_appear_animation(float delay) override;
 };
@@ -44,14 +46,16 @@ struct menu_item_parent_widget : public menu_item_widget {
 struct menu_item_normal_widget : public menu_item_widget {
     using super = menu_item_widget;
     ui::sp_anim_float opacity = anim_float(0, 200);
-    float text_padding = config::current->context_menu.theme.text_padding;
-    float margin = config::current->context_menu.theme.margin;
+    // Theme metrics, taken from one resolved theme when the widget is built
+    float item_height;
+    float text_padding;
+    float margin;
+    float padding;
+    float icon_padding;
+    float right_icon_padding;
+    float hotkey_padding;
     bool has_icon_padding = false;
     bool has_submenu_padding = false;
-    float padding = config::current->context_menu.theme.padding;
-    float icon_padding = config::current->context_menu.theme.icon_padding;
-    float right_icon_padding =
-        config::current->context_menu.theme.right_icon_padding;
     menu_item_normal_widget(menu_item item);
     void reset_appear_animation(float delay) override;
 
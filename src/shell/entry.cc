@@ -183,7 +183,7 @@ void main() {
         std::thread([]() {
             script_ctx.is_js_ready.wait(false);
             std::println("Is js ready: {}", script_ctx.is_js_ready.load());
-            script_ctx.js->enqueueJob([]() {
+            script_ctx.context()->enqueueJob([]() {
                 script_ctx.js->eval("globalThis.showConfigPage()", "asan.js");
             });
         }).detach();
@@ -0,0 +1,83 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <compare>
+#include <cstddef>
+#include <optional>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "reflect.hpp"
+
+// Conversions between enums and the names used in config and the script
+// API. reflect::enum_name gives the C++ spelling, e.g. space_between; the
+// config and scripts may write space-between.
+namespace mb_shell {
+template <typename E> constexpr std::string string_from_enum(E e) {
+    return reflect::enum_name(e) |
+           std::views::transform([](char c) { return c == '_' ? '-' : c; }) |
+           std::ranges::to<std::string>();
+}
+
+template <typename E> constexpr size_t enum_name_count() {
+    constexpr auto min = reflect::enum_min(E{});
+    constexpr auto max = reflect::enum_max(E{});
+
+    size_t count = 0;
+    for (int i = min; i <= max; ++i) {
+        if (!reflect::enum_name(static_cast<E>(i)).empty())
+            count++;
+    }
+    return count;
+}
+
+// Named values of E, sorted by name so lookups can binary search
+template <typename E> constexpr auto create_enum_map() {
+    constexpr auto min = reflect::enum_min(E{});
+    constexpr auto max = reflect::enum_max(E{});
+
+    std::array<std::pair<std::string_view, E>, enum_name_count<E>()> map{};
+
+    size_t index = 0;
+    for (int i = min; i <= max; ++i) {
+        E value = static_cast<E>(i);
+        auto name = reflect::enum_name(value);
+        if (!name.empty()) {
+            map[index++] = {name, value};
+        }
+    }
+
+    std::ranges::sort(map, {}, &std::pair<std::string_view, E>::first);
+    return map;
+}
+
+template <typename E> inline constexpr auto enum_map = create_enum_map<E>();
+
+// Orders like name <=> str, reading every '-' in str as '_' so both word
+// separators are accepted without copying the input
+constexpr std::strong_ordering compare_enum_name(std::string_view name,
+                                                 std::string_view str) {
+    auto size = std::min(name.size(), str.size());
+    for (size_t i = 0; i < size; i++) {
+        auto c = static_cast<unsigned char>(str[i] == '-' ? '_' : str[i]);
+        auto n = static_cast<unsigned char>(name[i]);
+        if (n != c)
+            return n <=> c;
+    }
+    return name.size() <=> str.size();
+}
+
+template <typename E>
+constexpr std::optional<E> enum_from_string(std::string_view str) {
+    auto &map = enum_map<E>;
+    auto it = std::ranges::partition_point(map, [&](const auto &entry) {
+        return compare_enum_name(entry.first, str) < 0;
+    });
+    if (it != map.end() && compare_enum_name(it->first, str) == 0) {
+        return it->second;
+    }
+    return std::nullopt;
+}
+} // namespace mb_shell
@@ -10,6 +10,7 @@
 
 #include "build_info.h"
 #include "config.h"
+#include "logger.h"
 
 #include "cpptrace/basic.hpp"
 #include "utils.h"
@@ -117,6 +118,7 @@ std::string GetExceptionName(EXCEPTION_POINTERS *ExceptionInfo) {
 
 void mb_shell::install_error_handlers() {
     SetUnhandledExceptionFilter([](PEXCEPTION_POINTERS ex) -> LONG {
+        flush_debug_log();
         show_console();
 
         std::ofstream file(config::data_directory().string() +
@@ -166,6 +168,7 @@ void mb_shell::install_error_handlers() {
     });
 
     std::set_terminate([]() {
+        flush_debug_log();
         show_console();
 
         std::stringstream ss;
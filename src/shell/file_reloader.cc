@@ -0,0 +1,79 @@
+#include "file_reloader.h"
+#include <fstream>
+#include <string>
+
+#include "fnv1a_hash.h"
+#include "script/FileWatch.hpp"
+
+namespace mb_shell {
+namespace {
+std::optional<uint64_t> hash_file(const std::filesystem::path &path) {
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs)
+        return std::nullopt;
+    std::string content((std::istreambuf_iterator<char>(ifs)),
+                        std::istreambuf_iterator<char>());
+    return fnv1a_hash(content);
+}
+} // namespace
+
+file_reloader::file_reloader(std::filesystem::path path,
+                             std::function<void()> reload,
+                             std::chrono::milliseconds quiet_period)
+    : path(std::move(path)), reload(std::move(reload)),
+      quiet_period(quiet_period), last_hash(hash_file(this->path)) {
+    watch = std::make_shared<filewatch::FileWatch<std::string>>(
+        this->path.string(),
+        [this](const std::string &, const filewatch::Event) {
+            {
+                std::lock_guard lock(mutex);
+                changed = true;
+            }
+            cv.notify_one();
+        });
+}
+
+file_reloader::~file_reloader() {
+    stop();
+    // Joins the watcher threads before the members they use go away
+    watch.reset();
+}
+
+void file_reloader::run() {
+    while (true) {
+        {
+            std::unique_lock lock(mutex);
+            cv.wait(lock, [this] { return changed || stopping; });
+            wakeup_count++;
+            do {
+                changed = false;
+            } while (!stopping && cv.wait_for(lock, quiet_period, [this] {
+                return changed || stopping;
+            }));
+            if (stopping)
+                return;
+        }
+
+        // Mid-save or deleted: a later event will bring us back here
+        auto hash = hash_file(path);
+        if (!hash || hash == last_hash)
+            continue;
+
+        last_hash = hash;
+        reload();
+    }
+}
+
+void file_reloader::stop() {
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+    }
+    cv.notify_all();
+}
+
+uint64_t file_reloader::wakeups() const {
+    std::lock_guard lock(mutex);
+    return wakeup_count;
+}
+} // namespace mb_shell
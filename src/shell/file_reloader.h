@@ -0,0 +1,49 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+
+namespace mb_shell {
+// Calls `reload` when the content of a file changes.
+//
+// The file is watched with filewatch::FileWatch (ReadDirectoryChangesW on
+// Windows, inotify on Linux), and run() sleeps until the watcher reports a
+// change, so there are no wakeups while the file is left alone. Editors save
+// in bursts (truncate, write, rename, touch...), so a reload waits until
+// the file has been quiet for `quiet_period`, and is skipped when the
+// content hash didn't change.
+struct file_reloader {
+    // Throws when the file can't be watched
+    file_reloader(std::filesystem::path path, std::function<void()> reload,
+                  std::chrono::milliseconds quiet_period =
+                      std::chrono::milliseconds(100));
+    ~file_reloader();
+
+    // Reloads on changes until stop(); call it on a thread of its own
+    void run();
+    void stop();
+
+    // Times run() has woken up, for tests
+    uint64_t wakeups() const;
+
+private:
+    std::filesystem::path path;
+    std::function<void()> reload;
+    std::chrono::milliseconds quiet_period;
+    std::optional<uint64_t> last_hash;
+
+    mutable std::mutex mutex;
+    std::condition_variable cv;
+    bool changed = false;
+    bool stopping = false;
+    uint64_t wakeup_count = 0;
+
+    // Type-erased so FileWatch.hpp stays out of this header
+    std::shared_ptr<void> watch;
+};
+} // namespace mb_shell
@@ -0,0 +1,16 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+
+namespace mb_shell {
+// FNV-1a, 64 bit; stable across builds, unlike std::hash, so it can key
+// data written to disk
+constexpr uint64_t fnv1a_hash(std::string_view data) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (char c : data) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+} // namespace mb_shell
@@ -1,16 +1,25 @@
 #include "i18n_manager.h"
+#include "i18n_template.h"
 #include "config.h"
+#include "locale_cache.h"
+#include "translation_table.h"
 #include "utils.h"
 #include "logger.h"
+#include "trace.h"
+#include "script/FileWatch.hpp"
 
+#include <algorithm>
+#include <cstdint>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <regex>
 #include <set>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
 
-#include "rfl.hpp"
-#include "rfl/json.hpp"
 #include <cstring>
 
 #include "windows.h"
@@ -32,13 +41,25 @@ void ensure_file(const std::filesystem::path& path, const unsigned char* data, s
     if (write_size > 0 && data[write_size - 1] == '\0') {
         write_size--;
     }
+    std::string_view content(reinterpret_cast<const char*>(data), write_size);
+
+    // Only rewrite when the content differs, so the file's mtime (and with it
+    // the compiled locale image) stays valid across restarts
+    std::error_code ec;
+    if (std::filesystem::file_size(path, ec) == write_size && !ec) {
+        std::ifstream existing(path, std::ios::binary);
+        std::string existing_content((std::istreambuf_iterator<char>(existing)),
+                                     std::istreambuf_iterator<char>());
+        if (fnv1a_hash(existing_content) == fnv1a_hash(content)) {
+            return;
+        }
+    }
 
-    // Always overwrite embedded locale files to ensure updates propagate correctly
     try {
         std::filesystem::create_directories(path.parent_path());
         std::ofstream f(path, std::ios::binary | std::ios::trunc);
         if (f) {
-            f.write(reinterpret_cast<const char*>(data), write_size);
+            f.write(content.data(), content.size());
             dbgout("Extracted/updated locale: {} (size: {})", path.string(), write_size);
         }
     } catch (const std::exception& e) {
@@ -46,14 +67,33 @@ void ensure_file(const std::filesystem::path& path, const unsigned char* data, s
     }
 }
 
-struct LocaleMetadata {
-    std::optional<std::string> direction;
-};
+// Where locale_cache keeps the compiled images of the locale files
+std::filesystem::path locale_cache_directory() {
+    return config::data_directory() / "locales" / ".cache";
+}
 
-struct LocaleFile {
-    rfl::Rename<"$metadata", std::optional<LocaleMetadata>> metadata;
-    rfl::ExtraFields<std::string> translations;
-};
+// Runs fn(0..count-1) on up to hardware_concurrency threads, including the
+// calling one
+template <typename F> void parallel_for(size_t count, F&& fn) {
+    std::atomic<size_t> next{0};
+    auto worker = [&]() {
+        for (size_t i; (i = next.fetch_add(1)) < count;) {
+            try {
+                fn(i);
+            } catch (const std::exception& e) {
+                std::cerr << "Error in parallel_for worker: " << e.what() << std::endl;
+            }
+        }
+    };
+
+    auto thread_count = std::min<size_t>(
+        count, std::max(1u, std::thread::hardware_concurrency()));
+    std::vector<std::jthread> threads;
+    for (size_t i = 1; i < thread_count; i++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+}
 
 }
 
@@ -67,51 +107,84 @@ i18n_manager::i18n_manager() : current_lang_("en-US"), is_rtl_(false) {
     ensure_file(locales_dir / "en-US.json", g_en_US_json, sizeof(g_en_US_json));
     ensure_file(locales_dir / "zh-CN.json", g_zh_CN_json, sizeof(g_zh_CN_json));
     reload();
+
+    try {
+        locale_watch_ = std::make_unique<filewatch::FileWatch<std::string>>(
+            locales_dir.string(),
+            [this, locales_dir](const std::string& file, const filewatch::Event) {
+                std::filesystem::path relative(file);
+                auto depth = std::distance(relative.begin(), relative.end());
+                // Core locales/<lang>.json
+                if (depth == 1 && relative.extension() == ".json") {
+                    dbgout("Locale change detected: {}", file);
+                    reload_core_locale(locales_dir / relative);
+                    return;
+                }
+
+                // Otherwise only locales/plugins[/<plugin>[/<lang>.json]] is
+                // relevant
+                if (depth == 0 || depth > 3 || *relative.begin() != "plugins" ||
+                    (depth == 3 && relative.extension() != ".json")) {
+                    return;
+                }
+
+                dbgout("Plugin locale change detected: {}", file);
+                reload_plugin_locale(locales_dir / relative);
+            });
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to watch locales directory: " << e.what() << std::endl;
+    }
 }
 
+i18n_manager::~i18n_manager() = default;
+
 std::string i18n_manager::get(const std::string& key) {
-    std::shared_lock<std::shared_mutex> lock(mutex_);
-    
-    // Try current language first
-    auto lang_it = translations_.find(current_lang_);
-    if (lang_it != translations_.end()) {
-        auto key_it = lang_it->second.find(key);
-        if (key_it != lang_it->second.end()) {
-            return key_it->second;
-        }
-    }
-    
-    // Try plugin translations
-    auto plugin_lang_it = plugin_translations_.find(current_lang_);
-    if (plugin_lang_it != plugin_translations_.end()) {
-        auto key_it = plugin_lang_it->second.find(key);
-        if (key_it != plugin_lang_it->second.end()) {
-            return key_it->second;
-        }
-    }
-    
-    // Fallback to en-US if not current language
-    if (current_lang_ != "en-US") {
-        auto fallback_it = translations_.find("en-US");
-        if (fallback_it != translations_.end()) {
-            auto key_it = fallback_it->second.find(key);
-            if (key_it != fallback_it->second.end()) {
-                return key_it->second;
-            }
+    // No mutex_: the snapshot already has current lang > plugin > en-US
+    // resolved, and stays alive for as long as we hold it.
+    auto table = table_.load(std::memory_order_acquire);
+    if (table) {
+        if (auto entry = table->find(key)) {
+            return std::string(
+                table->str(entry->value_offset, entry->value_size));
         }
     }
-    
+
     // Return key itself as last resort
     return key;
 }
 
 std::string i18n_manager::get(const std::string& key, 
                                const std::map<std::string, std::string>& params) {
-    std::string result = get(key);
-    return interpolate(result, params);
+    std::vector<std::pair<std::string_view, std::string_view>> views(
+        params.begin(), params.end());
+    return get(key, views);
+}
+
+std::string i18n_manager::get(
+    std::string_view key,
+    std::span<const std::pair<std::string_view, std::string_view>> params) {
+    auto table = table_.load(std::memory_order_acquire);
+    if (table) {
+        if (auto entry = table->find(key)) {
+            auto value = table->str(entry->value_offset, entry->value_size);
+            if (params.empty() || !entry->segment_count) {
+                return std::string(value);
+            }
+            return i18n_template::interpolate(value, table->segments_of(*entry),
+                                              params);
+        }
+    }
+
+    // The key itself is returned as last resort, so it gets substituted too
+    std::vector<i18n_template::segment> segments;
+    if (params.empty() || !i18n_template::compile(key, segments)) {
+        return std::string(key);
+    }
+    return i18n_template::interpolate(key, segments, params);
 }
 
 void i18n_manager::set_language(const std::string& lang) {
+    trace::span span("i18n_manager::set_language");
     std::unique_lock<std::shared_mutex> lock(mutex_);
     
     if (lang == current_lang_) {
@@ -136,19 +209,21 @@ void i18n_manager::set_language(const std::string& lang) {
                 is_rtl_ = true;
             }
         }
+
+        publish();
     } else {
         std::cerr << "Failed to load locale " << lang << ", keeping " << current_lang_ << std::endl;
     }
 }
 
 std::string i18n_manager::current_language() const {
-    std::shared_lock<std::shared_mutex> lock(mutex_);
-    return current_lang_;
+    auto table = table_.load(std::memory_order_acquire);
+    return table ? table->lang : "en-US";
 }
 
 bool i18n_manager::is_rtl() const {
-    std::shared_lock<std::shared_mutex> lock(mutex_);
-    return is_rtl_;
+    auto table = table_.load(std::memory_order_acquire);
+    return table && table->rtl;
 }
 
 void i18n_manager::register_translations(const std::string& lang,
@@ -163,23 +238,70 @@ void i18n_manager::register_translations(const std::string& lang,
             continue;
         }
         
-        plugin_translations_[lang][key] = value;
+        registered_translations_[lang][key] = value;
+    }
+
+    rebuild_plugin_translations(lang);
+    if (lang == current_lang_) {
+        publish();
+    }
+}
+
+void i18n_manager::unregister_translations(const std::string& lang,
+                                            const std::map<std::string, std::string>& translations) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+
+    auto it = registered_translations_.find(lang);
+    if (it == registered_translations_.end()) {
+        return;
+    }
+    for (const auto& [key, value] : translations) {
+        if (auto entry = it->second.find(key);
+            entry != it->second.end() && entry->second == value) {
+            it->second.erase(entry);
+        }
+    }
+
+    rebuild_plugin_translations(lang);
+    if (lang == current_lang_) {
+        publish();
     }
 }
 
 void i18n_manager::reload() {
+    trace::span span("i18n_manager::reload");
+    auto locales_dir = config::data_directory() / "locales";
+    auto plugin_locales = list_plugin_locales(locales_dir / "plugins");
+
+    // Drop cached images of locale files that were deleted or renamed
+    auto sources = plugin_locales;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(locales_dir, ec)) {
+        if (entry.is_regular_file(ec) && entry.path().extension() == ".json") {
+            sources.push_back(entry.path());
+        }
+    }
+    locale_cache::prune(sources, locale_cache_directory());
+
+    // Reading plugin locales is the slow part, so it's done in parallel and
+    // before taking the lock
+    auto plugin_files = read_plugin_locales(plugin_locales);
+
     std::unique_lock<std::shared_mutex> lock(mutex_);
     
     translations_.clear();
     plugin_translations_.clear();
+    plugin_files_.clear();
+    registered_translations_.clear();
     core_keys_.clear();
     
     // Determine language priority: config > system > en-US
     std::string target_lang;
     
     // Check if config has language override
-    if (config::current && config::current->language) {
-        target_lang = *config::current->language;
+    auto current_config = config::current();
+    if (current_config && current_config->language) {
+        target_lang = *current_config->language;
     } else {
         target_lang = get_system_language();
     }
@@ -198,8 +320,15 @@ void i18n_manager::reload() {
     current_lang_ = target_lang;
     dbgout("Current language set to: {}", current_lang_);
     
-    // Load plugin locales
-    load_plugin_locales();
+    // Merge plugin locales
+    std::set<std::string> plugin_langs;
+    for (auto& [path, file] : plugin_files) {
+        plugin_langs.insert(file.lang);
+        add_plugin_locale(path, std::move(file));
+    }
+    for (const auto& lang : plugin_langs) {
+        rebuild_plugin_translations(lang);
+    }
     
     // Update RTL status
     is_rtl_ = false;
@@ -210,6 +339,30 @@ void i18n_manager::reload() {
             is_rtl_ = true;
         }
     }
+
+    publish();
+}
+
+void i18n_manager::publish() {
+    // Resolve the fallback chain once, lowest priority first:
+    // en-US core < current plugin < current core
+    std::unordered_map<std::string_view, std::string_view> resolved;
+    auto merge = [&](const auto& tables, const std::string& lang) {
+        if (auto it = tables.find(lang); it != tables.end()) {
+            for (const auto& [key, value] : it->second) {
+                resolved.insert_or_assign(key, value);
+            }
+        }
+    };
+
+    if (current_lang_ != "en-US") {
+        merge(translations_, "en-US");
+    }
+    merge(plugin_translations_, current_lang_);
+    merge(translations_, current_lang_);
+
+    table_.store(translation_table::build(current_lang_, is_rtl_, resolved),
+                 std::memory_order_release);
 }
 
 bool i18n_manager::load_locale(const std::string& lang) {
@@ -252,106 +405,194 @@ bool i18n_manager::load_locale(const std::string& lang) {
         return false;
     }
     
-    std::ifstream file(locale_path);
-    if (!file) {
-        std::cerr << "Failed to open locale file: " << locale_path << std::endl;
-        return false;
-    }
-    
-    std::string json_str((std::istreambuf_iterator<char>(file)),
-                          std::istreambuf_iterator<char>());
-    
-    // Use reflect-cpp for JSON parsing
-    auto result = rfl::json::read<LocaleFile>(json_str);
-    if (!result) {
-        std::cerr << "Failed to parse locale file: " << locale_path << " Error: " << result.error().what() << std::endl;
+    auto locale_data = locale_cache::load(locale_path, locale_cache_directory());
+    if (!locale_data) {
         return false;
     }
     
-    const auto& locale_data = result.value();
     auto& lang_translations = translations_[lang];
     
     // Copy translations
-    for (const auto& [key, val] : locale_data.translations) {
-        // Skip metadata keys just in case, though they should be handled by 'metadata' field
-        if (key.starts_with("$metadata")) continue;
-        
-        lang_translations[key] = val;
+    for (auto& [key, val] : locale_data->translations) {
         core_keys_.insert(key);
+        lang_translations[std::move(key)] = std::move(val);
     }
     
     // Handle metadata
-    if (locale_data.metadata.value()) {
-        if (locale_data.metadata.value()->direction) {
-             lang_translations["$metadata.direction"] = *locale_data.metadata.value()->direction;
-        }
+    if (locale_data->direction) {
+        lang_translations["$metadata.direction"] = *locale_data->direction;
     }
     
     dbgout("Loaded locale: {} ({} translations)", lang, lang_translations.size());
     return true;
 }
 
-void i18n_manager::load_plugin_locales() {
-    auto plugins_locale_dir = config::data_directory() / "locales" / "plugins";
-    
-    if (!std::filesystem::exists(plugins_locale_dir)) {
+void i18n_manager::reload_plugin_locale(const std::filesystem::path& path) {
+    bool is_file = path.extension() == ".json";
+    std::error_code ec;
+
+    std::vector<std::filesystem::path> files;
+    if (!is_file) {
+        files = list_plugin_locales(path);
+    } else if (std::filesystem::is_regular_file(path, ec)) {
+        files.push_back(path);
+    }
+    auto parsed = read_plugin_locales(files);
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+
+    // Drop what the path contributed before
+    std::set<std::string> langs;
+    std::erase_if(plugin_files_, [&](const auto& entry) {
+        const auto& [file, data] = entry;
+        bool affected = is_file ? file == path
+                                : file.parent_path() == path ||
+                                      file.parent_path().parent_path() == path;
+        if (!affected) {
+            return false;
+        }
+
+        // Still there but failed to parse (e.g. saved halfway): keep the old
+        // translations rather than dropping them
+        if (!parsed.contains(file) && std::filesystem::exists(file, ec)) {
+            return false;
+        }
+
+        langs.insert(data.lang);
+        return true;
+    });
+
+    for (auto& [file, data] : parsed) {
+        langs.insert(data.lang);
+        add_plugin_locale(file, std::move(data));
+    }
+
+    for (const auto& lang : langs) {
+        rebuild_plugin_translations(lang);
+    }
+
+    if (langs.contains(current_lang_)) {
+        publish();
+    }
+}
+
+void i18n_manager::reload_core_locale(const std::filesystem::path& path) {
+    auto lang = path.stem().string();
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+
+    // Only languages in use are loaded
+    auto it = translations_.find(lang);
+    if (it == translations_.end()) {
         return;
     }
-    
+    auto previous = std::move(it->second);
+    translations_.erase(it);
+    if (!load_locale(lang)) {
+        translations_[lang] = std::move(previous);
+        return;
+    }
+
+    if (lang == current_lang_) {
+        is_rtl_ = false;
+        auto meta_it = translations_[lang].find("$metadata.direction");
+        if (meta_it != translations_[lang].end() && meta_it->second == "rtl") {
+            is_rtl_ = true;
+        }
+    }
+    if (lang == current_lang_ || lang == "en-US") {
+        publish();
+    }
+}
+
+std::vector<std::filesystem::path>
+i18n_manager::list_plugin_locales(const std::filesystem::path& dir) {
+    auto plugins_locale_dir = config::data_directory() / "locales" / "plugins";
+    std::vector<std::filesystem::path> files;
+
     try {
-        for (const auto& plugin_entry : std::filesystem::directory_iterator(plugins_locale_dir)) {
-            if (!plugin_entry.is_directory()) {
+        if (!std::filesystem::exists(dir)) {
+            return files;
+        }
+
+        for (auto it = std::filesystem::recursive_directory_iterator(dir);
+             it != std::filesystem::recursive_directory_iterator(); ++it) {
+            const auto& entry_path = it->path();
+            if (it->is_directory()) {
+                // Only descend into plugins/<plugin>
+                if (entry_path.parent_path() != plugins_locale_dir) {
+                    it.disable_recursion_pending();
+                }
                 continue;
             }
-            
-            std::string plugin_name = plugin_entry.path().filename().string();
-            
-            // Load all language files for this plugin
-            for (const auto& lang_file : std::filesystem::directory_iterator(plugin_entry.path())) {
-                if (!lang_file.is_regular_file() || 
-                    lang_file.path().extension() != ".json") {
-                    continue;
-                }
-                
-                std::string lang = lang_file.path().stem().string();
-                
-                std::ifstream file(lang_file.path());
-                if (!file) {
-                    continue;
-                }
-                
-                std::string json_str((std::istreambuf_iterator<char>(file)),
-                                      std::istreambuf_iterator<char>());
-                
-                // Use reflect-cpp to parse into LocaleFile
-                // We reuse LocaleFile struct as it handles the structure we expect
-                auto result = rfl::json::read<LocaleFile>(json_str);
-                if (!result) {
-                    std::cerr << "Failed to parse plugin locale file: " << lang_file.path() << " Error: " << result.error().what() << std::endl;
-                    continue;
-                }
-                
-                const auto& locale_data = result.value();
-                
-                for (const auto& [key, val] : locale_data.translations) {
-                    // Skip metadata keys
-                    if (key.starts_with("$metadata")) {
-                        continue;
-                    }
-                    
-                    // Warn if attempting to override core key
-                    if (core_keys_.find(key) != core_keys_.end()) {
-                        std::cerr << "Warning: Plugin " << plugin_name 
-                                  << " attempted to override core key: " << key << std::endl;
-                        continue;
-                    }
-                    
-                    plugin_translations_[lang][key] = val;
-                }
+
+            if (it->is_regular_file() && entry_path.extension() == ".json" &&
+                entry_path.parent_path().parent_path() == plugins_locale_dir) {
+                files.push_back(entry_path);
             }
         }
     } catch (const std::exception& e) {
-        std::cerr << "Error loading plugin locales: " << e.what() << std::endl;
+        std::cerr << "Error listing plugin locales: " << e.what() << std::endl;
+    }
+
+    return files;
+}
+
+std::map<std::filesystem::path, i18n_manager::plugin_locale_file>
+i18n_manager::read_plugin_locales(const std::vector<std::filesystem::path>& files) {
+    std::vector<std::optional<locale_cache::locale_data>> results(files.size());
+    auto cache_dir = locale_cache_directory();
+    parallel_for(files.size(), [&](size_t i) {
+        results[i] = locale_cache::load(files[i], cache_dir);
+    });
+
+    std::map<std::filesystem::path, plugin_locale_file> parsed;
+    for (size_t i = 0; i < files.size(); i++) {
+        if (!results[i]) {
+            continue;
+        }
+
+        parsed.emplace(files[i], plugin_locale_file{
+            .plugin_name = files[i].parent_path().filename().string(),
+            .lang = files[i].stem().string(),
+            .translations = std::move(results[i]->translations),
+        });
+    }
+    return parsed;
+}
+
+void i18n_manager::add_plugin_locale(const std::filesystem::path& path,
+                                     plugin_locale_file file) {
+    std::erase_if(file.translations, [&](const auto& translation) {
+        // Warn if attempting to override core key
+        if (core_keys_.find(translation.first) != core_keys_.end()) {
+            std::cerr << "Warning: Plugin " << file.plugin_name 
+                      << " attempted to override core key: " << translation.first << std::endl;
+            return true;
+        }
+        return false;
+    });
+
+    plugin_files_.insert_or_assign(path, std::move(file));
+}
+
+void i18n_manager::rebuild_plugin_translations(const std::string& lang) {
+    auto& merged = plugin_translations_[lang];
+    merged.clear();
+
+    for (const auto& [path, file] : plugin_files_) {
+        if (file.lang != lang) {
+            continue;
+        }
+        for (const auto& [key, value] : file.translations) {
+            merged[key] = value;
+        }
+    }
+
+    if (auto it = registered_translations_.find(lang);
+        it != registered_translations_.end()) {
+        for (const auto& [key, value] : it->second) {
+            merged[key] = value;
+        }
     }
 }
 
@@ -374,44 +615,6 @@ std::string i18n_manager::get_system_language() {
     return "en-US";
 }
 
-std::string i18n_manager::interpolate(const std::string& str,
-                                       const std::map<std::string, std::string>& params) {
-    if (params.empty()) {
-        return str;
-    }
-    
-    std::string result = str;
-    // Support alphanumeric, dots, and hyphens in placeholders (e.g., {user.name}, {my-key})
-    std::regex placeholder_regex(R"(\{([\w.-]+)\})");
-    
-    std::smatch match;
-    std::string::const_iterator search_start(result.cbegin());
-    std::string output;
-    
-    while (std::regex_search(search_start, result.cend(), match, placeholder_regex)) {
-        // Append text before the match
-        output.append(search_start, match[0].first);
-        
-        std::string placeholder_name = match[1].str();
-        auto param_it = params.find(placeholder_name);
-        
-        if (param_it != params.end()) {
-            // Replace with parameter value
-            output.append(param_it->second);
-        } else {
-            // Keep placeholder intact if not found
-            output.append(match[0].str());
-        }
-        
-        search_start = match.suffix().first;
-    }
-    
-    // Append remaining text
-    output.append(search_start, result.cend());
-    
-    return output;
-}
-
 std::vector<std::string> i18n_manager::available_languages() const {
     std::shared_lock<std::shared_mutex> lock(mutex_);
     
@@ -1,15 +1,27 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <filesystem>
 #include <map>
+#include <memory>
 #include <shared_mutex>
 #include <optional>
 #include <set>
+#include <span>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
+namespace filewatch {
+template <class StringType> class FileWatch;
+}
+
 namespace mb_shell {
 
+struct translation_table;
+
 /**
  * @brief Internationalization manager for loading and querying translations.
  * 
@@ -20,6 +32,13 @@ namespace mb_shell {
  * - String interpolation with {placeholder} syntax
  * - Plugin namespace protection for custom translations
  * - RTL direction detection for right-to-left languages
+ *
+ * Lookups never wait for a writer: every mutation rebuilds an immutable
+ * translation_table with the fallback chain already resolved and publishes
+ * it through a std::atomic<std::shared_ptr>. That pointer is not lock-free
+ * on every standard library (MSVC guards it with an internal spinlock), but
+ * the spinlock is only held to copy or swap the pointer, never while a
+ * table is built.
  */
 class i18n_manager {
 public:
@@ -43,6 +62,16 @@ public:
      */
     std::string get(const std::string& key, const std::map<std::string, std::string>& params);
 
+    /**
+     * @brief Get a translated string with placeholder substitution, without
+     *        building a std::map.
+     * @param key The translation key
+     * @param params Placeholder name/value pairs; the first match wins
+     * @return The translated string with placeholders replaced
+     */
+    std::string get(std::string_view key,
+                    std::span<const std::pair<std::string_view, std::string_view>> params);
+
     /**
      * @brief Set the current language.
      * @param lang Language code (e.g., "en-US", "zh-CN")
@@ -71,11 +100,39 @@ public:
     void register_translations(const std::string& lang, 
                                const std::map<std::string, std::string>& translations);
 
+    /**
+     * @brief Undo a register_translations() call when its plugin is unloaded.
+     * @param lang Language code
+     * @param translations The map that was registered
+     * @note Keys another plugin has registered since with a different value
+     *       are kept.
+     */
+    void unregister_translations(const std::string& lang,
+                                 const std::map<std::string, std::string>& translations);
+
     /**
      * @brief Reload locale files from disk.
      */
     void reload();
 
+    /**
+     * @brief Re-read a single plugin locale file, or every file of one plugin.
+     * @param path A locales/plugins/<plugin>/<lang>.json file or a
+     *             locales/plugins/<plugin> directory; removed files are dropped
+     * @note Called from the locales directory watcher; other plugins' files
+     *       are left untouched.
+     */
+    void reload_plugin_locale(const std::filesystem::path& path);
+
+    /**
+     * @brief Re-read a core locale file after it was edited.
+     * @param path A locales/<lang>.json file
+     * @note Called from the locales directory watcher. Languages that aren't
+     *       loaded are ignored, and a file that fails to load (e.g. saved
+     *       halfway) keeps its previous translations.
+     */
+    void reload_core_locale(const std::filesystem::path& path);
+
     /**
      * @brief Get all available language codes.
      * @return Vector of language codes found in locales directory
@@ -84,7 +141,7 @@ public:
 
 private:
     i18n_manager();
-    ~i18n_manager() = default;
+    ~i18n_manager();
 
     // Non-copyable
     i18n_manager(const i18n_manager&) = delete;
@@ -100,9 +157,42 @@ private:
     bool load_locale(const std::string& lang);
 
     /**
-     * @brief Load plugin locale files from plugins directory.
+     * @brief Translations read from one plugin locale file.
      */
-    void load_plugin_locales();
+    struct plugin_locale_file {
+        std::string plugin_name;
+        std::string lang;
+        std::vector<std::pair<std::string, std::string>> translations;
+    };
+
+    /**
+     * @brief Read and parse plugin locale files, fanned out across threads.
+     * @param files Paths of locales/plugins/<plugin>/<lang>.json files
+     * @return Successfully parsed files, keyed by path
+     * @note Does not touch any member state, so it runs without the lock.
+     */
+    static std::map<std::filesystem::path, plugin_locale_file>
+    read_plugin_locales(const std::vector<std::filesystem::path>& files);
+
+    /**
+     * @brief List locales/plugins/<plugin>/<lang>.json files.
+     * @param dir The plugins directory, or a single plugin's directory
+     */
+    static std::vector<std::filesystem::path>
+    list_plugin_locales(const std::filesystem::path& dir);
+
+    /**
+     * @brief Drop core keys from a parsed plugin file and store it.
+     * @note Caller must hold the unique lock on mutex_.
+     */
+    void add_plugin_locale(const std::filesystem::path& path, plugin_locale_file file);
+
+    /**
+     * @brief Recompute plugin_translations_[lang] from the plugin files and
+     *        runtime-registered translations.
+     * @note Caller must hold the unique lock on mutex_.
+     */
+    void rebuild_plugin_translations(const std::string& lang);
 
     /**
      * @brief Get the system's preferred UI language.
@@ -111,15 +201,10 @@ private:
     static std::string get_system_language();
 
     /**
-     * @brief Perform placeholder substitution on a string.
-     * @param str The string containing {placeholder} patterns
-     * @param params Map of placeholder names to values
-     * @return String with placeholders replaced
-     * @note Supported placeholder characters: alphanumeric, dots, and hyphens (e.g., {user.name}, {my-key}).
-     *       Regex pattern: \{([\w.-]+)\}.
+     * @brief Rebuild the lookup table from the source maps and publish it.
+     * @note Caller must hold the unique lock on mutex_.
      */
-    static std::string interpolate(const std::string& str, 
-                                   const std::map<std::string, std::string>& params);
+    void publish();
 
     std::string current_lang_;
     bool is_rtl_;
@@ -127,13 +212,28 @@ private:
     // Core translations: lang -> (key -> value)
     std::map<std::string, std::map<std::string, std::string>> translations_;
     
-    // Plugin translations: lang -> (key -> value), stored separately for namespace protection
+    // Plugin translations: lang -> (key -> value), stored separately for namespace protection.
+    // Merged from plugin_files_ and registered_translations_, the latter taking precedence.
     std::map<std::string, std::map<std::string, std::string>> plugin_translations_;
+
+    // Plugin locale files on disk, core keys already removed
+    std::map<std::filesystem::path, plugin_locale_file> plugin_files_;
+
+    // Translations registered at runtime through register_translations()
+    std::map<std::string, std::map<std::string, std::string>> registered_translations_;
     
     // Set of core keys (cannot be overridden by plugins)
     std::set<std::string> core_keys_;
     
+    // Guards the source maps above; only writers take it
     mutable std::shared_mutex mutex_;
+
+    // Resolved snapshot read by get()/is_rtl()/current_language(); see the
+    // class comment on what loading it costs
+    std::atomic<std::shared_ptr<const translation_table>> table_;
+
+    // Watches locales/ and locales/plugins for incremental reloads
+    std::unique_ptr<filewatch::FileWatch<std::string>> locale_watch_;
 };
 
 } // namespace mb_shell
@@ -0,0 +1,87 @@
+#include "i18n_template.h"
+
+namespace mb_shell {
+
+bool i18n_template::compile(std::string_view str, std::vector<segment>& out) {
+    auto is_name_char = [](char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+               (c >= '0' && c <= '9') || c == '_' || c == '.' || c == '-';
+    };
+
+    auto begin = out.size();
+    size_t literal_start = 0;
+    bool has_placeholder = false;
+
+    for (size_t i = 0; i < str.size(); i++) {
+        if (str[i] != '{') {
+            continue;
+        }
+
+        size_t end = i + 1;
+        while (end < str.size() && is_name_char(str[end])) {
+            end++;
+        }
+        if (end == i + 1 || end == str.size() || str[end] != '}') {
+            continue;
+        }
+
+        if (i > literal_start) {
+            out.push_back({static_cast<uint32_t>(literal_start),
+                           static_cast<uint32_t>(i - literal_start), false});
+        }
+        out.push_back({static_cast<uint32_t>(i),
+                       static_cast<uint32_t>(end + 1 - i), true});
+        has_placeholder = true;
+        literal_start = end + 1;
+        i = end;
+    }
+
+    if (!has_placeholder) {
+        out.resize(begin);
+        return false;
+    }
+
+    if (literal_start < str.size()) {
+        out.push_back({static_cast<uint32_t>(literal_start),
+                       static_cast<uint32_t>(str.size() - literal_start),
+                       false});
+    }
+    return true;
+}
+
+std::string i18n_template::interpolate(
+    std::string_view str, std::span<const segment> segments,
+    std::span<const std::pair<std::string_view, std::string_view>> params) {
+    auto find_param = [&](std::string_view name) -> const std::string_view* {
+        for (const auto& [param_name, value] : params) {
+            if (param_name == name) {
+                return &value;
+            }
+        }
+        return nullptr;
+    };
+
+    size_t size = str.size();
+    for (const auto& [name, value] : params) {
+        size += value.size();
+    }
+
+    std::string output;
+    output.reserve(size);
+
+    for (const auto& segment : segments) {
+        auto text = str.substr(segment.offset, segment.size);
+        if (segment.placeholder) {
+            // Keep placeholder intact if not found
+            if (auto value = find_param(text.substr(1, text.size() - 2))) {
+                output.append(*value);
+                continue;
+            }
+        }
+        output.append(text);
+    }
+
+    return output;
+}
+
+} // namespace mb_shell
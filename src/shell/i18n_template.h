@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace mb_shell {
+
+/**
+ * @brief {placeholder} substitution for translation strings.
+ *
+ * Strings are split once into literal and placeholder segments, so a
+ * lookup only has to walk the segments.
+ */
+struct i18n_template {
+    /**
+     * @brief One piece of a precompiled translation string.
+     *
+     * A placeholder segment spans the whole "{name}" so it can be emitted
+     * verbatim when no parameter matches. Offsets are relative to the string.
+     */
+    struct segment {
+        uint32_t offset;
+        uint32_t size;
+        bool placeholder;
+    };
+
+    /**
+     * @brief Split a string into literal and {placeholder} segments.
+     * @param str The string containing {placeholder} patterns
+     * @param out Segments are appended here
+     * @return false if the string has no placeholders (nothing is appended)
+     * @note Supported placeholder characters: alphanumeric, underscores, dots, and hyphens (e.g., {user.name}, {my-key}).
+     *       Same grammar as the regex \{([\w.-]+)\}.
+     */
+    static bool compile(std::string_view str, std::vector<segment>& out);
+
+    /**
+     * @brief Perform placeholder substitution using precompiled segments.
+     * @param str The string the segments were compiled from
+     * @param segments Output of compile for str
+     * @param params Placeholder name/value pairs; the first match wins
+     * @return String with placeholders replaced
+     */
+    static std::string interpolate(std::string_view str,
+                                   std::span<const segment> segments,
+                                   std::span<const std::pair<std::string_view, std::string_view>> params);
+};
+
+} // namespace mb_shell
@@ -0,0 +1,301 @@
+#include "locale_cache.h"
+#include "fnv1a_hash.h"
+#include "logger.h"
+
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <unordered_set>
+
+#include "rfl.hpp"
+#include "rfl/json.hpp"
+
+namespace mb_shell {
+
+namespace {
+struct LocaleMetadata {
+    std::optional<std::string> direction;
+};
+
+struct LocaleFile {
+    rfl::Rename<"$metadata", std::optional<LocaleMetadata>> metadata;
+    rfl::ExtraFields<std::string> translations;
+};
+
+constexpr uint32_t image_magic = 0x434c5a42; // "BZLC"
+constexpr uint32_t image_version = 1;
+
+// On-disk layout: image_header, image_entry[entry_count], pool[pool_size]
+struct image_header {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t source_size;
+    int64_t source_mtime;
+    uint64_t source_hash;
+    uint32_t entry_count;
+    uint32_t pool_size;
+    uint32_t has_direction;
+    uint32_t direction_offset;
+    uint32_t direction_size;
+    uint32_t reserved;
+};
+
+struct image_entry {
+    uint32_t key_offset, key_size;
+    uint32_t value_offset, value_size;
+};
+
+// The whole image, empty if there is none. Images are small (one copy of
+// the strings they hold), so reading them is cheaper than mapping them.
+std::string read_image(const std::filesystem::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return {};
+    }
+    return std::string((std::istreambuf_iterator<char>(file)),
+                       std::istreambuf_iterator<char>());
+}
+
+std::filesystem::path image_path_for(const std::filesystem::path& source,
+                                     const std::filesystem::path& cache_dir) {
+    auto id = fnv1a_hash(source.lexically_normal().generic_string());
+    return cache_dir /
+           std::format("{}.{:016x}.bin", source.stem().string(), id);
+}
+
+std::optional<image_header> read_header(std::string_view image) {
+    image_header header;
+    if (image.size() < sizeof(header)) {
+        return std::nullopt;
+    }
+    std::memcpy(&header, image.data(), sizeof(header));
+
+    if (header.magic != image_magic || header.version != image_version) {
+        return std::nullopt;
+    }
+
+    uint64_t expected_size = sizeof(image_header) +
+                             uint64_t(header.entry_count) * sizeof(image_entry) +
+                             header.pool_size;
+    if (image.size() != expected_size) {
+        return std::nullopt;
+    }
+    return header;
+}
+
+std::optional<locale_cache::locale_data> decode(std::string_view image,
+                                                const image_header& header) {
+    auto entries = image.data() + sizeof(image_header);
+    auto pool = image.substr(sizeof(image_header) +
+                             header.entry_count * sizeof(image_entry));
+
+    auto str = [&](uint32_t offset,
+                   uint32_t size) -> std::optional<std::string_view> {
+        if (uint64_t(offset) + size > pool.size()) {
+            return std::nullopt;
+        }
+        return pool.substr(offset, size);
+    };
+
+    locale_cache::locale_data data;
+    if (header.has_direction) {
+        auto direction = str(header.direction_offset, header.direction_size);
+        if (!direction) {
+            return std::nullopt;
+        }
+        data.direction = std::string(*direction);
+    }
+
+    data.translations.reserve(header.entry_count);
+    for (uint32_t i = 0; i < header.entry_count; i++) {
+        image_entry entry;
+        std::memcpy(&entry, entries + i * sizeof(image_entry), sizeof(entry));
+
+        auto key = str(entry.key_offset, entry.key_size);
+        auto value = str(entry.value_offset, entry.value_size);
+        if (!key || !value) {
+            return std::nullopt;
+        }
+        data.translations.emplace_back(*key, *value);
+    }
+    return data;
+}
+
+void write_image(const std::filesystem::path& path, image_header header,
+                 const locale_cache::locale_data& data) {
+    std::string pool;
+    std::vector<image_entry> entries;
+    entries.reserve(data.translations.size());
+
+    auto append = [&](std::string_view s) {
+        auto offset = static_cast<uint32_t>(pool.size());
+        pool.append(s);
+        return offset;
+    };
+
+    for (const auto& [key, value] : data.translations) {
+        auto key_offset = append(key);
+        auto value_offset = append(value);
+        entries.push_back({key_offset, static_cast<uint32_t>(key.size()),
+                           value_offset, static_cast<uint32_t>(value.size())});
+    }
+
+    header.magic = image_magic;
+    header.version = image_version;
+    header.entry_count = static_cast<uint32_t>(entries.size());
+    header.has_direction = data.direction.has_value();
+    if (data.direction) {
+        header.direction_offset = append(*data.direction);
+        header.direction_size = static_cast<uint32_t>(data.direction->size());
+    }
+    header.pool_size = static_cast<uint32_t>(pool.size());
+
+    try {
+        std::filesystem::create_directories(path.parent_path());
+
+        // Write next to the target and rename, so a concurrent reader never
+        // sees a half-written image
+        auto tmp_path = path;
+        tmp_path += std::format(".{:08x}.tmp", std::random_device{}());
+        {
+            std::ofstream f(tmp_path, std::ios::binary | std::ios::trunc);
+            if (!f) {
+                return;
+            }
+            f.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            f.write(reinterpret_cast<const char*>(entries.data()),
+                    entries.size() * sizeof(image_entry));
+            f.write(pool.data(), pool.size());
+        }
+
+        std::error_code ec;
+        std::filesystem::rename(tmp_path, path, ec);
+        if (ec) {
+            std::filesystem::remove(tmp_path, ec);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to write locale cache " << path << ": "
+                  << e.what() << std::endl;
+    }
+}
+
+std::optional<locale_cache::locale_data>
+parse(const std::string& json_str, const std::filesystem::path& source) {
+    // Use reflect-cpp for JSON parsing
+    auto result = rfl::json::read<LocaleFile>(json_str);
+    if (!result) {
+        std::cerr << "Failed to parse locale file: " << source
+                  << " Error: " << result.error().what() << std::endl;
+        return std::nullopt;
+    }
+
+    const auto& locale_file = result.value();
+    locale_cache::locale_data data;
+    for (const auto& [key, val] : locale_file.translations) {
+        // Skip metadata keys just in case, though they should be handled by
+        // 'metadata' field
+        if (key.starts_with("$metadata")) {
+            continue;
+        }
+        data.translations.emplace_back(key, val);
+    }
+
+    if (locale_file.metadata.value()) {
+        data.direction = locale_file.metadata.value()->direction;
+    }
+    return data;
+}
+} // namespace
+
+std::optional<locale_cache::locale_data>
+locale_cache::load(const std::filesystem::path& source,
+                   const std::filesystem::path& cache_dir) {
+    std::error_code ec;
+    auto source_size = std::filesystem::file_size(source, ec);
+    if (ec) {
+        return std::nullopt;
+    }
+    auto source_mtime =
+        std::filesystem::last_write_time(source, ec).time_since_epoch().count();
+    if (ec) {
+        return std::nullopt;
+    }
+
+    auto image_path = image_path_for(source, cache_dir);
+    auto image = read_image(image_path);
+    auto header = read_header(image);
+
+    // Fast path: size and mtime match, no need to even read the source
+    if (header && header->source_size == source_size &&
+        header->source_mtime == source_mtime) {
+        if (auto data = decode(image, *header)) {
+            return data;
+        }
+    }
+
+    std::ifstream file(source, std::ios::binary);
+    if (!file) {
+        std::cerr << "Failed to open locale file: " << source << std::endl;
+        return std::nullopt;
+    }
+    std::string json_str((std::istreambuf_iterator<char>(file)),
+                         std::istreambuf_iterator<char>());
+    auto source_hash = fnv1a_hash(json_str);
+
+    std::optional<locale_data> data;
+    // Touched but not changed: reuse the image, only its key gets refreshed
+    if (header && header->source_hash == source_hash &&
+        header->source_size == json_str.size()) {
+        data = decode(image, *header);
+    }
+
+    if (!data) {
+        data = parse(json_str, source);
+        if (!data) {
+            return std::nullopt;
+        }
+        dbgout("Compiled locale image: {}", image_path.string());
+    }
+
+    write_image(image_path,
+                {.source_size = source_size,
+                 .source_mtime = source_mtime,
+                 .source_hash = source_hash},
+                *data);
+    return data;
+}
+
+void locale_cache::prune(const std::vector<std::filesystem::path>& sources,
+                         const std::filesystem::path& cache_dir) {
+    std::unordered_set<std::string> live;
+    for (const auto& source : sources) {
+        live.insert(image_path_for(source, cache_dir).filename().string());
+    }
+
+    try {
+        if (!std::filesystem::exists(cache_dir)) {
+            return;
+        }
+
+        for (const auto& entry : std::filesystem::directory_iterator(cache_dir)) {
+            const auto& path = entry.path();
+            // Leave temporaries alone, another process may still be writing
+            if (path.extension() != ".bin" ||
+                live.contains(path.filename().string())) {
+                continue;
+            }
+
+            std::error_code ec;
+            if (std::filesystem::remove(path, ec)) {
+                dbgout("Removed stale locale image: {}", path.string());
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to prune locale cache: " << e.what() << std::endl;
+    }
+}
+
+} // namespace mb_shell
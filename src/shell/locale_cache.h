@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace mb_shell {
+
+/**
+ * @brief Compiled binary images of locale JSON files.
+ *
+ * Each parsed locale file is stored as a flat image (header + entry table +
+ * string pool) in a cache directory; i18n_manager uses
+ * <data_directory>/locales/.cache. The image is keyed by
+ * the source file's size, mtime and content hash; on the next start it is
+ * read back and decoded without running the JSON parser. Only files whose
+ * image is missing or stale are parsed again.
+ */
+struct locale_cache {
+    /**
+     * @brief Contents of one locale file.
+     */
+    struct locale_data {
+        // Value of $metadata.direction, if present
+        std::optional<std::string> direction;
+        // Translation keys and values, $metadata keys excluded
+        std::vector<std::pair<std::string, std::string>> translations;
+    };
+
+    /**
+     * @brief Load a locale file, from its cached image when still valid.
+     * @param source Path to the locale JSON file
+     * @param cache_dir Directory holding the images; created when needed
+     * @return The parsed contents, or nullopt if the file can't be read/parsed
+     */
+    static std::optional<locale_data> load(const std::filesystem::path& source,
+                                           const std::filesystem::path& cache_dir);
+
+    /**
+     * @brief Remove cached images that belong to none of the given files.
+     * @param sources Paths of every locale file that still exists
+     * @param cache_dir Directory holding the images
+     *
+     * Images are keyed by source path, so those of deleted or renamed files
+     * would otherwise stay in the cache forever.
+     */
+    static void prune(const std::vector<std::filesystem::path>& sources,
+                      const std::filesystem::path& cache_dir);
+};
+
+} // namespace mb_shell
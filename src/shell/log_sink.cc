@@ -0,0 +1,109 @@
+#include "log_sink.h"
+
+#include <cstdio>
+#include <thread>
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+namespace mb_shell {
+log_sink::log_sink(std::filesystem::path path, std::uintmax_t max_size,
+                   bool echo, std::function<void()> on_writer_start)
+    : path(std::move(path)), max_size(max_size), echo(echo) {
+    open();
+    std::thread([this, on_writer_start = std::move(on_writer_start)] {
+        run(on_writer_start);
+    }).detach();
+}
+
+void log_sink::push(std::string text) {
+    auto head = pending.load(std::memory_order_relaxed);
+    auto next = new line{std::move(text), head};
+    while (!pending.compare_exchange_weak(head, next,
+                                          std::memory_order_release,
+                                          std::memory_order_relaxed))
+        next->next = head;
+
+    // The writer only sleeps on an empty queue, so waking it once per batch
+    // is enough
+    if (!head) {
+        wakeups.fetch_add(1, std::memory_order_release);
+        wakeups.notify_one();
+    }
+}
+
+bool log_sink::flush(std::chrono::milliseconds timeout) {
+    std::unique_lock lock(write_mutex, timeout);
+    if (!lock)
+        return false;
+    write(take());
+    return true;
+}
+
+log_sink::line *log_sink::take() {
+    auto first = pending.exchange(nullptr, std::memory_order_acquire);
+    line *reversed = nullptr;
+    while (first) {
+        auto next = first->next;
+        first->next = reversed;
+        reversed = first;
+        first = next;
+    }
+    return reversed;
+}
+
+void log_sink::write(line *first) {
+    std::string batch;
+    while (first) {
+        batch += first->text;
+#ifdef _WIN32
+        if (echo)
+            OutputDebugStringA(first->text.c_str());
+#endif
+        delete std::exchange(first, first->next);
+    }
+
+    if (batch.empty())
+        return;
+
+    if (echo)
+        fwrite(batch.data(), 1, batch.size(), stdout);
+    if (file) {
+        file.write(batch.data(), batch.size());
+        file.flush();
+        file_size += batch.size();
+        if (file_size > max_size)
+            rotate();
+    }
+}
+
+void log_sink::open() {
+    file.open(path, std::ios::app);
+    std::error_code ec;
+    file_size = std::filesystem::file_size(path, ec);
+    if (ec)
+        file_size = 0;
+}
+
+void log_sink::rotate() {
+    file.close();
+    std::error_code ec;
+    std::filesystem::rename(path, path.string() + ".1", ec);
+    open();
+}
+
+void log_sink::run(std::function<void()> on_writer_start) {
+    if (on_writer_start)
+        on_writer_start();
+    while (true) {
+        auto seen = wakeups.load(std::memory_order_acquire);
+        {
+            std::lock_guard lock(write_mutex);
+            write(take());
+        }
+        wakeups.wait(seen, std::memory_order_acquire);
+    }
+}
+} // namespace mb_shell
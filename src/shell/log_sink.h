@@ -0,0 +1,62 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <string>
+
+namespace mb_shell {
+// Background writer behind append_debug_string.
+//
+// Any thread may push lines; they are written in batches by a writer thread,
+// which appends them to a file and, with echo, to stdout and the debugger.
+// The file is moved to <path>.1 once it grows past max_size.
+//
+// The writer thread is detached, so a sink must outlive it; the shell's sink
+// is never destroyed.
+class log_sink {
+public:
+    // on_writer_start runs first thing on the writer thread
+    log_sink(std::filesystem::path path, std::uintmax_t max_size, bool echo,
+             std::function<void()> on_writer_start = {});
+
+    // Queues a line and returns without waiting for the file, the console or
+    // another thread that is logging
+    void push(std::string text);
+
+    // Synchronously writes everything queued so far. Gives up, returning
+    // false, if the writer holds the file for longer than `timeout`, e.g.
+    // because it crashed while writing.
+    bool flush(std::chrono::milliseconds timeout);
+
+private:
+    struct line {
+        std::string text;
+        line *next;
+    };
+
+    // Everything queued so far, oldest first
+    line *take();
+    void write(line *first);
+    void open();
+    void rotate();
+    void run(std::function<void()> on_writer_start);
+
+    std::filesystem::path path;
+    std::uintmax_t max_size;
+    bool echo;
+
+    // Lines queued by any thread, newest first. Producers only swap the head
+    // pointer.
+    std::atomic<line *> pending = nullptr;
+    std::atomic<uint32_t> wakeups = 0;
+    // Held while a batch is written, by the writer thread or a flush
+    std::timed_mutex write_mutex;
+
+    std::ofstream file;
+    std::uintmax_t file_size = 0;
+};
+} // namespace mb_shell
@@ -1,25 +1,32 @@
 #include "logger.h"
 #include "config.h"
+#include "log_sink.h"
 #include "utils.h"
 
-#include <fstream>
-#include <iostream>
+#include <chrono>
 #include <string>
-
-#include <windows.h>
+#include <utility>
 
 namespace mb_shell {
-void append_debug_string(const std::string &str) {
-    static std::mutex mutex;
-    static std::ofstream file(config::data_directory() / "debug.log",
-                              std::ios::app);
+namespace {
+// debug.log is moved to debug.log.1 once it grows past this
+constexpr std::uintmax_t max_log_size = 4 * 1024 * 1024;
 
-    std::lock_guard<std::mutex> lock(mutex);
+log_sink &sink() {
+    // Intentionally leaked: the writer thread is detached and keeps using it
+    // until the process exits
+    static auto sink =
+        new log_sink(config::data_directory() / "debug.log", max_log_size,
+                     true, [] { set_thread_name("breeze::logger"); });
+    return *sink;
+}
+} // namespace
 
-    file << str;
-    file.flush();
+void append_debug_string(std::string str) { sink().push(std::move(str)); }
 
-    printf("%s", str.c_str());
-    OutputDebugStringA(str.c_str());
+void flush_debug_log() {
+    // Don't hang the crash handler if the writer thread is the one that
+    // crashed while holding the lock
+    sink().flush(std::chrono::milliseconds(500));
 }
-} // namespace mb_shell
\ No newline at end of file
+} // namespace mb_shell
@@ -4,10 +4,25 @@
 #include <iostream>
 
 namespace mb_shell {
-void append_debug_string(const std::string &str);
+// Build with BREEZE_NO_DBGOUT (xmake f --dbgout=n) to compile debug output
+// out entirely
+#ifdef BREEZE_NO_DBGOUT
+inline constexpr bool dbgout_enabled = false;
+#else
+inline constexpr bool dbgout_enabled = true;
+#endif
+
+// Queues the string for the background log writer (debug.log, stdout and
+// the debugger) and returns immediately
+void append_debug_string(std::string str);
+// Synchronously writes everything queued so far; used by the crash handlers
+void flush_debug_log();
 template <class... types>
 void dbgout(const std::format_string<types...> fmt, types &&...args) {
-    std::string str = std::format(fmt, std::forward<types>(args)...);
-    append_debug_string(str + "\n");
+    if constexpr (dbgout_enabled) {
+        std::string str = std::format(fmt, std::forward<types>(args)...);
+        str += '\n';
+        append_debug_string(std::move(str));
+    }
 }
-} // namespace mb_shell
\ No newline at end of file
+} // namespace mb_shell
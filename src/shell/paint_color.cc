@@ -2,95 +2,21 @@
 #include "breeze_ui/ui.h"
 #include "nanovg.h"
 #include "utils.h"
-#include <numbers>
-#include <vector>
 
 namespace mb_shell {
-paint_color paint_color::from_string(const std::string &str) {
-    paint_color res;
-    // Trim whitespace
-    std::string trimmed = str;
-    trimmed.erase(0, trimmed.find_first_not_of(" \t\n\r"));
-    trimmed.erase(trimmed.find_last_not_of(" \t\n\r") + 1);
+// The parser is constexpr, so the grammar is checked at compile time
+static_assert(rgba_color::from_string("#ff000080") ==
+              rgba_color(1, 0, 0, 128 / 255.f));
+static_assert(rgba_color::from_string("0f0") == rgba_color(0, 1, 0));
+static_assert(rgba_color::from_string("255, 0,255") == rgba_color(1, 0, 1));
+static_assert(rgba_color::from_string("") == rgba_color(0, 0, 0));
+static_assert(paint_color::from_string(" solid(#fff) ").color ==
+              rgba_color(1, 1, 1));
+static_assert(paint_color::from_string("radial-gradient(10, #000, #fff)")
+                  .radius2 == 20);
+static_assert(paint_color::from_string("linear-gradient(0, #000, #fff)")
+                  .type == paint_color::type::linear_gradient);
 
-    if (trimmed.starts_with("solid(") && trimmed.ends_with(")")) {
-        std::string color_str = trimmed.substr(6, trimmed.length() - 7);
-        res.type = type::solid;
-        res.color = rgba_color::from_string(color_str);
-    } else if (trimmed.starts_with("linear-gradient(") &&
-               trimmed.ends_with(")")) {
-        std::string params = trimmed.substr(16, trimmed.length() - 17);
-
-        // Split by commas
-        std::vector<std::string> parts;
-        size_t start = 0, end = 0;
-        while ((end = params.find(',', start)) != std::string::npos) {
-            std::string part = params.substr(start, end - start);
-            part.erase(0, part.find_first_not_of(" \t"));
-            part.erase(part.find_last_not_of(" \t") + 1);
-            parts.push_back(part);
-            start = end + 1;
-        }
-        std::string last_part = params.substr(start);
-        last_part.erase(0, last_part.find_first_not_of(" \t"));
-        last_part.erase(last_part.find_last_not_of(" \t") + 1);
-        parts.push_back(last_part);
-
-        if (parts.size() >= 3) {
-            res.type = type::linear_gradient;
-            res.angle = std::stof(parts[0]) * std::numbers::pi /
-                        180.0f; // Convert degrees to radians
-            res.color = parse_color(parts[1]);
-            res.color2 = parse_color(parts[2]);
-        }
-    } else if (trimmed.starts_with("radial-gradient(") &&
-               trimmed.ends_with(")")) {
-        std::string params = trimmed.substr(16, trimmed.length() - 17);
-
-        // Split by commas
-        std::vector<std::string> parts;
-        size_t start = 0, end = 0;
-        while ((end = params.find(',', start)) != std::string::npos) {
-            std::string part = params.substr(start, end - start);
-            part.erase(0, part.find_first_not_of(" \t"));
-            part.erase(part.find_last_not_of(" \t") + 1);
-            parts.push_back(part);
-            start = end + 1;
-        }
-        std::string last_part = params.substr(start);
-        last_part.erase(0, last_part.find_first_not_of(" \t"));
-        last_part.erase(last_part.find_last_not_of(" \t") + 1);
-        parts.push_back(last_part);
-
-        if (parts.size() >= 3) {
-            res.type = type::radial_gradient;
-            res.radius = std::stof(parts[0]);
-            res.color = parse_color(parts[1]);
-            res.color2 = parse_color(parts[2]);
-            res.radius2 = res.radius * 2; // Default outer radius
-        }
-    } else {
-        // Default to solid color
-        res.type = type::solid;
-        res.color = parse_color(trimmed);
-    }
-
-    return res;
-}
-std::string paint_color::to_string() const {
-    switch (type) {
-    case type::solid:
-        return "solid(" + format_color(color) + ")";
-    case type::linear_gradient:
-        return "linear-gradient(" +
-               std::to_string(angle * 180.0f / std::numbers::pi) + ", " +
-               format_color(color) + ", " + format_color(color2) + ")";
-    case type::radial_gradient:
-        return "radial-gradient(" + std::to_string(radius) + ", " +
-               format_color(color) + ", " + format_color(color2) + ")";
-    }
-    return "";
-}
 void paint_color::apply_to_ctx(ui::nanovg_context &ctx, float x, float y,
                                float width, float height) const {
 
@@ -121,12 +47,4 @@ rgba_color::operator NVGcolor() const { return nvgRGBAf(r, g, b, a); }
 rgba_color::rgba_color(const NVGcolor &color)
     : r(color.r), g(color.g), b(color.b), a(color.a) {}
 NVGcolor rgba_color::nvg() const { return nvgRGBAf(r, g, b, a); }
-rgba_color rgba_color::from_string(const std::string &str) {
-    return parse_color(str);
-}
-std::string rgba_color::to_string() const {
-    return std::format("#{0:02x}{1:02x}{2:02x}{3:02x}",
-                       static_cast<int>(r * 255), static_cast<int>(g * 255),
-                       static_cast<int>(b * 255), static_cast<int>(a * 255));
-}
 } // namespace mb_shell
\ No newline at end of file
@@ -1,6 +1,15 @@
 #pragma once
+#include <algorithm>
 #include <array>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <format>
+#include <limits>
+#include <numbers>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 
 struct NVGcolor;
 
@@ -10,23 +19,266 @@ struct nanovg_context;
 
 namespace mb_shell {
 
+namespace color_parser {
+// The parsers below are single pass over a string_view and never allocate,
+// so built-in defaults can be parsed at compile time. Number parsing mirrors
+// std::stoi / std::stof (leading whitespace, sign, trailing garbage ignored,
+// std::invalid_argument when there are no digits), which is what the color
+// grammar was originally defined with.
+
+constexpr bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' ||
+           c == '\r';
+}
+
+constexpr int digit_value(char c) {
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'z')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'Z')
+        return c - 'A' + 10;
+    return 99;
+}
+
+constexpr std::string_view trim(std::string_view str, std::string_view chars) {
+    auto start = str.find_first_not_of(chars);
+    if (start == std::string_view::npos)
+        return {};
+    return str.substr(start, str.find_last_not_of(chars) - start + 1);
+}
+
+constexpr int parse_int(std::string_view str, int base = 10) {
+    size_t i = 0;
+    while (i < str.size() && is_space(str[i]))
+        i++;
+
+    bool negative = false;
+    if (i < str.size() && (str[i] == '+' || str[i] == '-'))
+        negative = str[i++] == '-';
+
+    // "0x" prefix, only when followed by a hex digit
+    if (base == 16 && i + 2 < str.size() && str[i] == '0' &&
+        (str[i + 1] == 'x' || str[i + 1] == 'X') &&
+        digit_value(str[i + 2]) < 16)
+        i += 2;
+
+    constexpr long long max = std::numeric_limits<int>::max();
+    long long value = 0;
+    size_t digits = 0;
+    for (; i < str.size() && digit_value(str[i]) < base; i++, digits++) {
+        value = value * base + digit_value(str[i]);
+        if (value > max + 1)
+            throw std::out_of_range("parse_int");
+    }
+
+    if (!digits)
+        throw std::invalid_argument("parse_int");
+
+    value = negative ? -value : value;
+    if (value > max)
+        throw std::out_of_range("parse_int");
+    return static_cast<int>(value);
+}
+
+constexpr bool starts_with_nocase(std::string_view str, std::string_view word) {
+    if (str.size() < word.size())
+        return false;
+    for (size_t i = 0; i < word.size(); i++) {
+        if ((str[i] | 0x20) != word[i])
+            return false;
+    }
+    return true;
+}
+
+// Same result as std::stof, rounding included: decimal and hex floats,
+// inf/infinity and nan, std::out_of_range when the value doesn't fit a
+// float. At run time the number itself is read by std::from_chars. Under
+// constant evaluation, where that isn't available, decimals of up to 15
+// significant digits with exponents up to 22 are exact, longer ones may be
+// off by one ulp.
+constexpr float parse_float(std::string_view str) {
+    size_t i = 0;
+    while (i < str.size() && is_space(str[i]))
+        i++;
+
+    bool negative = false;
+    if (i < str.size() && (str[i] == '+' || str[i] == '-'))
+        negative = str[i++] == '-';
+    str.remove_prefix(i);
+
+    // Overflow, or a non-zero number below the normal range, like strtof's
+    // ERANGE
+    auto finish = [&](double value, bool exact_zero) {
+        // Halfway between FLT_MAX and the next power of two rounds to inf
+        constexpr double overflow = 0x1.ffffffp127;
+        if (value >= overflow ||
+            (!exact_zero && static_cast<float>(value) <
+                                std::numeric_limits<float>::min()))
+            throw std::out_of_range("parse_float");
+        auto result = static_cast<float>(value);
+        return negative ? -result : result;
+    };
+
+    if (starts_with_nocase(str, "inf"))
+        return negative ? -std::numeric_limits<float>::infinity()
+                        : std::numeric_limits<float>::infinity();
+    if (starts_with_nocase(str, "nan"))
+        return negative ? -std::numeric_limits<float>::quiet_NaN()
+                        : std::numeric_limits<float>::quiet_NaN();
+
+    // "0x" only starts a hex float when a hex digit follows, otherwise the
+    // number is the 0
+    bool hex = str.size() > 2 && str[0] == '0' && (str[1] | 0x20) == 'x' &&
+               (digit_value(str[2]) < 16 ||
+                (str[2] == '.' && str.size() > 3 && digit_value(str[3]) < 16));
+
+    if (!std::is_constant_evaluated()) {
+        // from_chars takes no sign or 0x prefix itself
+        if (!str.empty() && str[0] == '-')
+            throw std::invalid_argument("parse_float");
+        float value = 0;
+        auto [end, error] = std::from_chars(
+            str.data() + (hex ? 2 : 0), str.data() + str.size(), value,
+            hex ? std::chars_format::hex : std::chars_format::general);
+        if (error == std::errc::invalid_argument)
+            throw std::invalid_argument("parse_float");
+        if (error == std::errc::result_out_of_range)
+            throw std::out_of_range("parse_float");
+        return finish(value, value == 0);
+    }
+
+    int base = hex ? 16 : 10;
+    i = hex ? 2 : 0;
+
+    // Significant digits go into the mantissa; the scale of the ones that
+    // don't fit and of the fraction digits is kept in `exponent`, in
+    // powers of the base
+    uint64_t mantissa = 0;
+    int exponent = 0;
+    size_t digits = 0;
+    bool fraction = false;
+    for (; i < str.size(); i++) {
+        if (str[i] == '.' && !fraction) {
+            fraction = true;
+            continue;
+        }
+        auto digit = digit_value(str[i]);
+        if (digit >= base)
+            break;
+        digits++;
+        if (mantissa < (uint64_t{1} << 59)) {
+            mantissa = mantissa * base + digit;
+            if (fraction)
+                exponent--;
+        } else if (!fraction) {
+            exponent++;
+        }
+    }
+
+    if (!digits)
+        throw std::invalid_argument("parse_float");
+
+    // Decimals take a decimal exponent after 'e', hex floats a binary one
+    // after 'p'
+    auto exponent_char = hex ? 'p' : 'e';
+    int written_exponent = 0;
+    if (i + 1 < str.size() && (str[i] | 0x20) == exponent_char) {
+        size_t j = i + 1;
+        bool negative_exp = false;
+        if (str[j] == '+' || str[j] == '-')
+            negative_exp = str[j++] == '-';
+        for (; j < str.size() && str[j] >= '0' && str[j] <= '9'; j++)
+            written_exponent =
+                std::min(written_exponent * 10 + (str[j] - '0'), 100000);
+        if (negative_exp)
+            written_exponent = -written_exponent;
+    }
+
+    double value = static_cast<double>(mantissa);
+    if (hex) {
+        for (int e = exponent * 4 + written_exponent; e != 0 && value != 0;
+             e += e > 0 ? -1 : 1)
+            value = e > 0 ? value * 2 : value / 2;
+        return finish(value, mantissa == 0);
+    }
+
+    // Both operands exact, so a single correctly rounded operation
+    constexpr double powers[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,
+                                 1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                 1e12, 1e13, 1e14, 1e15, 1e16, 1e17,
+                                 1e18, 1e19, 1e20, 1e21, 1e22};
+    auto total = exponent + written_exponent;
+    if (mantissa <= (uint64_t{1} << 53) && total >= -22 && total <= 22)
+        return finish(total < 0 ? value / powers[-total]
+                                : value * powers[total],
+                      mantissa == 0);
+
+    for (; total != 0 && value != 0; total += total > 0 ? -1 : 1) {
+        value = total > 0 ? value * 10 : value / 10;
+        if (value > 1e300)
+            break;
+    }
+    return finish(value, mantissa == 0);
+}
+
+// Channel value as nanovg's nvgRGBA would store it
+constexpr float channel(int value) {
+    return static_cast<unsigned char>(value) / 255.0f;
+}
+
+// The angle of a linear-gradient(), which is written in degrees
+constexpr float to_radians(float degrees) {
+    return degrees * std::numbers::pi / 180.0f;
+}
+
+// Degrees that to_radians() maps back to exactly `radians`, when some do
+inline float to_degrees(float radians) {
+    float estimate = radians * 180.0 / std::numbers::pi;
+    // Rounding can put the estimate a few floats off
+    auto below = estimate, above = estimate;
+    for (int i = 0; i < 4; i++) {
+        if (to_radians(below) == radians)
+            return below;
+        if (to_radians(above) == radians)
+            return above;
+        below = std::nextafter(below, -std::numeric_limits<float>::infinity());
+        above = std::nextafter(above, std::numeric_limits<float>::infinity());
+    }
+    return estimate;
+}
+} // namespace color_parser
+
 struct rgba_color {
     float r = 0;
     float g = 0;
     float b = 0;
     float a = 1;
 
-    rgba_color() = default;
-    rgba_color(float r, float g, float b, float a = 1)
+    constexpr rgba_color() = default;
+    constexpr rgba_color(float r, float g, float b, float a = 1)
         : r(r), g(g), b(b), a(a) {}
 
-    static rgba_color from_string(const std::string &str);
+    // allowed:
+    // #RRGGBB
+    // #RRGGBBAA
+    // #RGB
+    // #RGBA
+    // RRGGBB
+    // RRGGBBAA
+    // RGB
+    // RGBA
+    // r, g,b
+    // r,g, b,a
+    static constexpr rgba_color from_string(std::string_view str);
     std::string to_string() const;
 
     rgba_color(const NVGcolor &color);
     NVGcolor nvg() const;
     // we want to pass this directly into fillColor( NVGcolor color)
     operator NVGcolor() const;
+
+    constexpr bool operator==(const rgba_color &) const = default;
 };
 
 struct paint_color {
@@ -52,7 +304,149 @@ struct paint_color {
     // linear-gradient(angle, color1, color2)
     // radial-gradient(radius, color1, color2)
     // solid(color)
-    static paint_color from_string(const std::string &str);
+    static constexpr paint_color from_string(std::string_view str);
     std::string to_string() const;
+
+    constexpr bool operator==(const paint_color &) const = default;
 };
-} // namespace mb_shell
\ No newline at end of file
+
+constexpr rgba_color rgba_color::from_string(std::string_view s) {
+    using namespace color_parser;
+    constexpr rgba_color black = {0, 0, 0, 1};
+
+    if (s.empty())
+        return black;
+
+    // Remove leading '#' if present
+    if (s[0] == '#')
+        s.remove_prefix(1);
+
+    // Handle comma-separated values. Like std::getline, a trailing comma
+    // does not start another component.
+    if (s.find(',') != std::string_view::npos) {
+        std::array<int, 4> components{};
+        size_t count = 0, start = 0;
+        while (start < s.size()) {
+            auto end = std::min(s.find(',', start), s.size());
+            auto value = parse_int(s.substr(start, end - start));
+            if (count < components.size())
+                components[count] = value;
+            count++;
+            start = end + 1;
+        }
+
+        if (count == 3) {
+            return {channel(components[0]), channel(components[1]),
+                    channel(components[2]), 1};
+        }
+        if (count == 4) {
+            return {channel(components[0]), channel(components[1]),
+                    channel(components[2]), channel(components[3])};
+        }
+    }
+
+    auto hex = [&](size_t offset, size_t size) {
+        return parse_int(s.substr(offset, size), 16);
+    };
+
+    // Handle hex values
+    switch (s.length()) {
+    case 3: // RGB
+        return {channel(17 * hex(0, 1)), channel(17 * hex(1, 1)),
+                channel(17 * hex(2, 1)), 1};
+    case 4: // RGBA
+        return {channel(17 * hex(0, 1)), channel(17 * hex(1, 1)),
+                channel(17 * hex(2, 1)), channel(17 * hex(3, 1))};
+    case 6: // RRGGBB
+        return {channel(hex(0, 2)), channel(hex(2, 2)), channel(hex(4, 2)),
+                1};
+    case 8: // RRGGBBAA
+        return {channel(hex(0, 2)), channel(hex(2, 2)), channel(hex(4, 2)),
+                channel(hex(6, 2))};
+    }
+
+    return black; // Default black
+}
+
+constexpr paint_color paint_color::from_string(std::string_view str) {
+    using namespace color_parser;
+    paint_color res;
+    auto trimmed = trim(str, " \t\n\r");
+
+    // Splits "a, b, c" and reports whether there were at least 3 parts
+    auto split3 = [](std::string_view params,
+                     std::array<std::string_view, 3> &parts) {
+        size_t count = 0, start = 0;
+        while (true) {
+            auto end = params.find(',', start);
+            auto part = trim(params.substr(start, end - start), " \t");
+            if (count < parts.size())
+                parts[count] = part;
+            count++;
+            if (end == std::string_view::npos)
+                break;
+            start = end + 1;
+        }
+        return count >= 3;
+    };
+
+    auto is_call = [&](std::string_view name) {
+        return trimmed.starts_with(name) && trimmed.ends_with(")");
+    };
+    auto call_params = [&](std::string_view name) {
+        return trimmed.substr(name.size(), trimmed.size() - name.size() - 1);
+    };
+
+    std::array<std::string_view, 3> parts;
+    if (is_call("solid(")) {
+        res.type = type::solid;
+        res.color = rgba_color::from_string(call_params("solid("));
+    } else if (is_call("linear-gradient(")) {
+        if (split3(call_params("linear-gradient("), parts)) {
+            res.type = type::linear_gradient;
+            res.angle = to_radians(parse_float(parts[0]));
+            res.color = rgba_color::from_string(parts[1]);
+            res.color2 = rgba_color::from_string(parts[2]);
+        }
+    } else if (is_call("radial-gradient(")) {
+        if (split3(call_params("radial-gradient("), parts)) {
+            res.type = type::radial_gradient;
+            res.radius = parse_float(parts[0]);
+            res.color = rgba_color::from_string(parts[1]);
+            res.color2 = rgba_color::from_string(parts[2]);
+            res.radius2 = res.radius * 2; // Default outer radius
+        }
+    } else {
+        // Default to solid color
+        res.type = type::solid;
+        res.color = rgba_color::from_string(trimmed);
+    }
+
+    return res;
+}
+
+// Both print what from_string() parses back to the same value; floats are
+// written with as many digits as that takes
+inline std::string rgba_color::to_string() const {
+    auto byte = [](float channel) {
+        return std::clamp(static_cast<int>(std::lround(channel * 255)), 0, 255);
+    };
+    return std::format("#{:02x}{:02x}{:02x}{:02x}", byte(r), byte(g), byte(b),
+                       byte(a));
+}
+
+inline std::string paint_color::to_string() const {
+    switch (type) {
+    case type::solid:
+        return "solid(" + color.to_string() + ")";
+    case type::linear_gradient:
+        return std::format("linear-gradient({}, {}, {})",
+                           color_parser::to_degrees(angle), color.to_string(),
+                           color2.to_string());
+    case type::radial_gradient:
+        return std::format("radial-gradient({}, {}, {})", radius,
+                           color.to_string(), color2.to_string());
+    }
+    return "";
+}
+} // namespace mb_shell
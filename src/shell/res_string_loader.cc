@@ -107,7 +107,7 @@ std::string res_string_loader::string_to_id_string(std::wstring str) {
 void res_string_loader::init() {
     std::thread([]() {
         init_known_strings();
-        if (config::current->res_string_loader_use_hook)
+        if (config::current()->res_string_loader_use_hook)
             init_hook();
     }).detach();
 }
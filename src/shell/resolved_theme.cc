@@ -0,0 +1,66 @@
+#include "resolved_theme.h"
+#include "config.h"
+#include "utils.h"
+#include <atomic>
+
+namespace mb_shell {
+static std::atomic<std::shared_ptr<const resolved_theme>> current_resolved;
+
+std::shared_ptr<const resolved_theme> resolved_theme::current() {
+    auto generation = config::generation();
+    auto resolved = current_resolved.load(std::memory_order_acquire);
+    if (resolved && resolved->generation == generation) {
+        return resolved;
+    }
+
+    // Several threads may race to rebuild after a reload; they all produce
+    // the same values, so whichever store wins is fine. If the config is
+    // reloaded again in between, the stale generation makes the next call
+    // rebuild once more.
+    resolved = resolve(config::current(), generation);
+    current_resolved.store(resolved, std::memory_order_release);
+    return resolved;
+}
+
+std::shared_ptr<const resolved_theme>
+resolved_theme::resolve(std::shared_ptr<const config> source,
+                        uint64_t generation) {
+    auto res = std::make_shared<resolved_theme>();
+    auto &theme = source->context_menu.theme;
+
+    res->generation = generation;
+    res->light = is_light_mode();
+    res->acrylic = theme.acrylic;
+    res->use_dwm = theme.use_dwm_if_available && is_win11_or_later();
+    res->use_self_drawn_border = theme.use_self_drawn_border && !res->use_dwm;
+
+    res->acrylic_color = parse_color(res->light ? theme.acrylic_color_light
+                                                : theme.acrylic_color_dark);
+    res->shadow_color_from =
+        parse_color(res->light ? theme.shadow_color_light_from
+                               : theme.shadow_color_dark_from);
+    res->shadow_color_to = parse_color(res->light ? theme.shadow_color_light_to
+                                                  : theme.shadow_color_dark_to);
+    res->border_color =
+        res->light ? theme.border_color_light : theme.border_color_dark;
+    res->border_width = res->use_self_drawn_border ? theme.border_width : 0.0f;
+
+    res->foreground = res->light ? 0 : 1;
+    res->font_size = theme.font_size;
+    res->hotkey_font_size = theme.font_size * 0.9f;
+    res->icon_width = theme.font_size + 2;
+
+    res->item = {
+        .height = theme.item_height,
+        .margin = theme.margin,
+        .padding = theme.padding,
+        .text_padding = theme.text_padding,
+        .icon_padding = theme.icon_padding,
+        .right_icon_padding = theme.right_icon_padding,
+        .hotkey_padding = theme.hotkey_padding,
+    };
+
+    res->source = std::move(source);
+    return res;
+}
+} // namespace mb_shell
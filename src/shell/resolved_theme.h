@@ -0,0 +1,58 @@
+#pragma once
+
+#include "nanovg.h"
+#include "paint_color.h"
+#include <cstdint>
+#include <memory>
+
+namespace mb_shell {
+struct config;
+
+// Context menu theme values derived from one config snapshot: colors are
+// parsed, registry-backed flags are queried and metrics are precomputed
+// once per config generation instead of on every widget construction or
+// frame.
+struct resolved_theme {
+    // The snapshot these values were derived from, so the raw theme and the
+    // resolved values always agree
+    std::shared_ptr<const config> source;
+    uint64_t generation = 0;
+
+    bool light = false;
+    // The theme asks for acrylic. Whether transparency is enabled in Windows
+    // can change at any time, so is_acrylic_available() is left to the
+    // widget being built.
+    bool acrylic = false;
+    bool use_dwm = false;
+    bool use_self_drawn_border = false;
+
+    NVGcolor acrylic_color;
+    NVGcolor shadow_color_from;
+    NVGcolor shadow_color_to;
+    paint_color border_color;
+    // 0 when the border is not drawn by us
+    float border_width = 0;
+
+    // 0 for light mode, 1 for dark mode
+    float foreground = 0;
+    float font_size = 14;
+    float hotkey_font_size = 14 * 0.9f;
+    float icon_width = 14 + 2;
+
+    // Menu item layout, see the diagram in menu_widget.cc
+    struct item_metrics {
+        float height = 0;
+        float margin = 0;
+        float padding = 0;
+        float text_padding = 0;
+        float icon_padding = 0;
+        float right_icon_padding = 0;
+        float hotkey_padding = 0;
+    } item;
+
+    // Resolved theme for the current config, rebuilt lazily after a reload
+    static std::shared_ptr<const resolved_theme> current();
+    static std::shared_ptr<const resolved_theme>
+    resolve(std::shared_ptr<const config> source, uint64_t generation);
+};
+} // namespace mb_shell
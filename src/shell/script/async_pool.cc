@@ -0,0 +1,118 @@
+#include "async_pool.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <utility>
+
+namespace mb_shell {
+// Idle workers exit after this long, so a burst of requests doesn't leave
+// threads parked in explorer.exe
+static constexpr auto idle_timeout = std::chrono::seconds(30);
+
+static bool same_owner(const std::weak_ptr<qjs::Context> &a,
+                       const std::weak_ptr<qjs::Context> &b) {
+    return !a.owner_before(b) && !b.owner_before(a);
+}
+
+async_pool::async_pool(std::function<limits()> current_limits,
+                       std::function<void()> on_worker_start)
+    : current_limits(std::move(current_limits)),
+      on_worker_start(std::move(on_worker_start)) {}
+
+void async_pool::submit(std::weak_ptr<qjs::Context> owner,
+                        std::function<void()> work) {
+    auto next_limit = current_limits();
+    next_limit.threads = std::max<size_t>(1, next_limit.threads);
+    next_limit.threads_per_owner =
+        std::max<size_t>(1, next_limit.threads_per_owner);
+
+    std::lock_guard lock(mutex);
+    limit = next_limit;
+    auto it = std::ranges::find_if(
+        owners, [&](auto &queue) { return same_owner(queue.owner, owner); });
+    if (it == owners.end()) {
+        it = owners.insert(owners.end(), owner_queue{std::move(owner)});
+    }
+    it->tasks.push_back(std::move(work));
+
+    if (it->running < limit.threads_per_owner) {
+        spawn_worker_if_needed();
+    }
+    cv.notify_one();
+}
+
+void async_pool::spawn_worker_if_needed() {
+    if (idle_threads > 0 || threads >= limit.threads) {
+        return;
+    }
+
+    threads++;
+    std::thread(&async_pool::worker, this).detach();
+}
+
+bool async_pool::take(owner_iterator &owner, std::function<void()> &work) {
+    for (auto it = owners.begin(); it != owners.end();) {
+        if (it->owner.expired()) {
+            it->tasks.clear();
+            if (it->running == 0) {
+                it = owners.erase(it);
+                continue;
+            }
+        }
+
+        if (!it->tasks.empty() && it->running < limit.threads_per_owner) {
+            work = std::move(it->tasks.front());
+            it->tasks.pop_front();
+            it->running++;
+            // Move to the back so the next pick starts with the other owners
+            owners.splice(owners.end(), owners, it);
+            owner = it;
+            return true;
+        }
+        ++it;
+    }
+    return false;
+}
+
+void async_pool::worker() {
+    if (on_worker_start) {
+        on_worker_start();
+    }
+
+    std::unique_lock lock(mutex);
+    while (true) {
+        owner_iterator owner;
+        std::function<void()> work;
+        if (!take(owner, work)) {
+            idle_threads++;
+            bool woke = cv.wait_for(lock, idle_timeout,
+                                    [&] { return take(owner, work); });
+            idle_threads--;
+            if (!woke) {
+                threads--;
+                return;
+            }
+        }
+
+        lock.unlock();
+        try {
+            work();
+        } catch (std::exception &e) {
+            std::cerr << "Error in async task: " << e.what() << std::endl;
+        } catch (...) {
+            std::cerr << "Unknown error in async task" << std::endl;
+        }
+        work = nullptr;
+        lock.lock();
+
+        owner->running--;
+        if (owner->tasks.empty() && owner->running == 0) {
+            owners.erase(owner);
+        } else {
+            // The owner may have been held back by its quota
+            cv.notify_one();
+        }
+    }
+}
+} // namespace mb_shell
@@ -0,0 +1,67 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+
+namespace qjs {
+class Context;
+}
+
+namespace mb_shell {
+// Process-wide pool for the blocking work behind the *_async script bindings
+// (WinHTTP requests, subprocesses, shell file operations).
+//
+// Threads are started on demand up to limits::threads and exit after being
+// idle for a while. Every script context gets its own FIFO queue; contexts
+// are served round-robin and each may occupy at most
+// limits::threads_per_owner threads, so one plugin firing hundreds of
+// requests can't starve the others. The owning context acts as the
+// cancellation token: work that hasn't started when its context is
+// destroyed is dropped.
+//
+// Workers are detached, so a pool must outlive them; the bindings' pool is
+// never destroyed.
+struct async_pool {
+    struct limits {
+        size_t threads = 8;
+        size_t threads_per_owner = 4;
+    };
+
+    // current_limits is asked on every submit, so a config change applies
+    // to the work submitted after it. on_worker_start runs first thing on
+    // every new worker thread.
+    explicit async_pool(std::function<limits()> current_limits,
+                        std::function<void()> on_worker_start = {});
+
+    void submit(std::weak_ptr<qjs::Context> owner, std::function<void()> work);
+
+private:
+    struct owner_queue {
+        std::weak_ptr<qjs::Context> owner;
+        std::deque<std::function<void()>> tasks;
+        size_t running = 0;
+    };
+    using owner_iterator = std::list<owner_queue>::iterator;
+
+    void worker();
+    // Next runnable task, rotating through the owners. Drops the queues of
+    // destroyed contexts along the way.
+    bool take(owner_iterator &owner, std::function<void()> &work);
+    void spawn_worker_if_needed();
+
+    std::function<limits()> current_limits;
+    std::function<void()> on_worker_start;
+    // As of the last submit
+    limits limit;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::list<owner_queue> owners;
+    size_t threads = 0;
+    size_t idle_threads = 0;
+};
+} // namespace mb_shell
@@ -1076,6 +1076,103 @@ template<> struct js_bind<mb_shell::js::subproc> {
     }
 };
 
+template <> struct qjs::js_traits<mb_shell::js::js_memory_usage_data> {
+    static mb_shell::js::js_memory_usage_data unwrap(JSContext *ctx, JSValueConst v) {
+        mb_shell::js::js_memory_usage_data obj;
+
+        obj.bytes_in_use = js_traits<int64_t>::unwrap(ctx, JS_GetPropertyStr(ctx, v, "bytes_in_use"));
+
+        obj.peak_bytes = js_traits<int64_t>::unwrap(ctx, JS_GetPropertyStr(ctx, v, "peak_bytes"));
+
+        obj.reserved_bytes = js_traits<int64_t>::unwrap(ctx, JS_GetPropertyStr(ctx, v, "reserved_bytes"));
+
+        obj.allocations = js_traits<int64_t>::unwrap(ctx, JS_GetPropertyStr(ctx, v, "allocations"));
+
+        obj.live_allocations = js_traits<int64_t>::unwrap(ctx, JS_GetPropertyStr(ctx, v, "live_allocations"));
+
+        return obj;
+    }
+
+    static JSValue wrap(JSContext *ctx, const mb_shell::js::js_memory_usage_data &val) noexcept {
+        JSValue obj = JS_NewObject(ctx);
+
+        JS_SetPropertyStr(ctx, obj, "bytes_in_use", js_traits<int64_t>::wrap(ctx, val.bytes_in_use));
+
+        JS_SetPropertyStr(ctx, obj, "peak_bytes", js_traits<int64_t>::wrap(ctx, val.peak_bytes));
+
+        JS_SetPropertyStr(ctx, obj, "reserved_bytes", js_traits<int64_t>::wrap(ctx, val.reserved_bytes));
+
+        JS_SetPropertyStr(ctx, obj, "allocations", js_traits<int64_t>::wrap(ctx, val.allocations));
+
+        JS_SetPropertyStr(ctx, obj, "live_allocations", js_traits<int64_t>::wrap(ctx, val.live_allocations));
+
+        return obj;
+    }
+};
+template<> struct js_bind<mb_shell::js::js_memory_usage_data> {
+    static void bind(qjs::Context::Module &mod) {
+        mod.class_<mb_shell::js::js_memory_usage_data>("js_memory_usage_data")
+            .constructor<>()
+                .fun<&mb_shell::js::js_memory_usage_data::bytes_in_use>("bytes_in_use")
+                .fun<&mb_shell::js::js_memory_usage_data::peak_bytes>("peak_bytes")
+                .fun<&mb_shell::js::js_memory_usage_data::reserved_bytes>("reserved_bytes")
+                .fun<&mb_shell::js::js_memory_usage_data::allocations>("allocations")
+                .fun<&mb_shell::js::js_memory_usage_data::live_allocations>("live_allocations")
+            ;
+    }
+};
+
+template <> struct qjs::js_traits<mb_shell::js::menu_listener_stats_data> {
+    static mb_shell::js::menu_listener_stats_data unwrap(JSContext *ctx, JSValueConst v) {
+        mb_shell::js::menu_listener_stats_data obj;
+
+        obj.plugin = js_traits<std::string>::unwrap(ctx, JS_GetPropertyStr(ctx, v, "plugin"));
+
+        obj.runs = js_traits<int64_t>::unwrap(ctx, JS_GetPropertyStr(ctx, v, "runs"));
+
+        obj.overruns = js_traits<int64_t>::unwrap(ctx, JS_GetPropertyStr(ctx, v, "overruns"));
+
+        obj.total_ms = js_traits<double>::unwrap(ctx, JS_GetPropertyStr(ctx, v, "total_ms"));
+
+        obj.max_ms = js_traits<double>::unwrap(ctx, JS_GetPropertyStr(ctx, v, "max_ms"));
+
+        obj.deferred = js_traits<bool>::unwrap(ctx, JS_GetPropertyStr(ctx, v, "deferred"));
+
+        return obj;
+    }
+
+    static JSValue wrap(JSContext *ctx, const mb_shell::js::menu_listener_stats_data &val) noexcept {
+        JSValue obj = JS_NewObject(ctx);
+
+        JS_SetPropertyStr(ctx, obj, "plugin", js_traits<std::string>::wrap(ctx, val.plugin));
+
+        JS_SetPropertyStr(ctx, obj, "runs", js_traits<int64_t>::wrap(ctx, val.runs));
+
+        JS_SetPropertyStr(ctx, obj, "overruns", js_traits<int64_t>::wrap(ctx, val.overruns));
+
+        JS_SetPropertyStr(ctx, obj, "total_ms", js_traits<double>::wrap(ctx, val.total_ms));
+
+        JS_SetPropertyStr(ctx, obj, "max_ms", js_traits<double>::wrap(ctx, val.max_ms));
+
+        JS_SetPropertyStr(ctx, obj, "deferred", js_traits<bool>::wrap(ctx, val.deferred));
+
+        return obj;
+    }
+};
+template<> struct js_bind<mb_shell::js::menu_listener_stats_data> {
+    static void bind(qjs::Context::Module &mod) {
+        mod.class_<mb_shell::js::menu_listener_stats_data>("menu_listener_stats_data")
+            .constructor<>()
+                .fun<&mb_shell::js::menu_listener_stats_data::plugin>("plugin")
+                .fun<&mb_shell::js::menu_listener_stats_data::runs>("runs")
+                .fun<&mb_shell::js::menu_listener_stats_data::overruns>("overruns")
+                .fun<&mb_shell::js::menu_listener_stats_data::total_ms>("total_ms")
+                .fun<&mb_shell::js::menu_listener_stats_data::max_ms>("max_ms")
+                .fun<&mb_shell::js::menu_listener_stats_data::deferred>("deferred")
+            ;
+    }
+};
+
 template <> struct qjs::js_traits<mb_shell::js::fs> {
     static mb_shell::js::fs unwrap(JSContext *ctx, JSValueConst v) {
         mb_shell::js::fs obj;
@@ -1149,6 +1246,12 @@ template<> struct js_bind<mb_shell::js::breeze> {
                 .static_fun<&mb_shell::js::breeze::register_translations>("register_translations")
                 .static_fun<&mb_shell::js::breeze::available_languages>("available_languages")
                 .static_fun<&mb_shell::js::breeze::set_language>("set_language")
+                .static_fun<&mb_shell::js::breeze::set_tracing>("set_tracing")
+                .static_fun<&mb_shell::js::breeze::export_trace>("export_trace")
+                .static_fun<&mb_shell::js::breeze::set_profiling>("set_profiling")
+                .static_fun<&mb_shell::js::breeze::export_profile>("export_profile")
+                .static_fun<&mb_shell::js::breeze::js_memory_usage>("js_memory_usage")
+                .static_fun<&mb_shell::js::breeze::menu_listener_stats>("menu_listener_stats")
             ;
     }
 };
@@ -1306,6 +1409,10 @@ inline void bindAll(qjs::Context::Module &mod) {
 
     js_bind<mb_shell::js::subproc>::bind(mod);
 
+    js_bind<mb_shell::js::js_memory_usage_data>::bind(mod);
+
+    js_bind<mb_shell::js::menu_listener_stats_data>::bind(mod);
+
     js_bind<mb_shell::js::fs>::bind(mod);
 
     js_bind<mb_shell::js::breeze>::bind(mod);
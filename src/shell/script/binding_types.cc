@@ -23,9 +23,16 @@
 
 #include "shell/contextmenu/hooks.h"
 
+#include "async_pool.h"
+#include "js_arena.h"
+#include "js_profiler.h"
+#include "menu_listener_watchdog.h"
+#include "plugin_modules.h"
 #include "script.h"
+#include "timer_scheduler.h"
 #include "shell/utils.h"
 #include "shell/i18n_manager.h"
+#include "shell/trace.h"
 #include "winhttp.h"
 
 #include <shellapi.h>
@@ -38,6 +45,7 @@ using namespace WinToastLib;
 std::vector<
     std::shared_ptr<std::function<void(mb_shell::js::menu_info_basic_js)>>>
     mb_shell::menu_callbacks_js;
+std::mutex mb_shell::menu_callbacks_js_mutex;
 namespace mb_shell::js {
 bool menu_controller::valid() { return !$menu.expired(); }
 std::shared_ptr<mb_shell::js::menu_item_controller>
@@ -73,17 +81,37 @@ menu_controller::append_item_after(js_menu_data data, int after_index) {
 }
 std::function<void()> menu_controller::add_menu_listener(
     std::function<void(menu_info_basic_js)> listener) {
-    auto listener_cvt = [listener](menu_info_basic_js info) {
-        try {
-            listener(info);
-        } catch (std::exception &e) {
-            std::cerr << "Error in listener: " << e.what() << std::endl;
-        }
+    auto ctx = qjs::Context::current;
+    auto plugin = plugin_modules::caller(ctx->ctx).filename().string();
+    if (plugin.empty())
+        plugin = "(unknown)";
+    auto listener_cvt = [listener, plugin, weak = ctx->weak_from_this()](
+                            menu_info_basic_js info) {
+        auto conf = config::current();
+        menu_listener_watchdog::run(
+            plugin, weak,
+            {conf->context_menu.listener_budget_ms,
+             conf->context_menu.defer_slow_listeners},
+            [listener, info] { listener(info); });
     };
     auto ptr =
         std::make_shared<std::function<void(menu_info_basic_js)>>(listener_cvt);
-    menu_callbacks_js.push_back(ptr);
-    return [ptr]() { std::erase(menu_callbacks_js, ptr); };
+    auto remove = [ptr] {
+        std::lock_guard lock(menu_callbacks_js_mutex);
+        std::erase(menu_callbacks_js, ptr);
+    };
+    {
+        std::lock_guard lock(menu_callbacks_js_mutex);
+        menu_callbacks_js.push_back(ptr);
+    }
+    auto handle = plugin_modules::on_unload(ctx->ctx, [remove, plugin]() {
+        remove();
+        menu_listener_watchdog::reinstate(plugin);
+    });
+    return [remove, handle]() {
+        remove();
+        plugin_modules::forget(handle);
+    };
 }
 menu_controller::~menu_controller() {}
 void menu_item_controller::set_position(int new_index) {
@@ -467,36 +495,67 @@ std::string network::post(std::string url, std::string data) {
 
 std::string network::get(std::string url) { return post(url, ""); }
 
+// Runs the blocking work of the *_async bindings, sized from config
+static async_pool &script_pool() {
+    // Intentionally leaked: workers are detached and may still be blocked in
+    // a request while the process exits
+    static auto pool = new async_pool(
+        [] {
+            auto conf = config::current();
+            if (!conf) {
+                return async_pool::limits{};
+            }
+            return async_pool::limits{
+                .threads = static_cast<size_t>(
+                    std::max(1, conf->async_worker_threads)),
+                .threads_per_owner = static_cast<size_t>(
+                    std::max(1, conf->async_worker_threads_per_plugin)),
+            };
+        },
+        [] { set_thread_name("breeze::async_worker"); });
+    return *pool;
+}
+
+// The blocking part of every *_async binding runs on the shared async_pool,
+// owned by the calling context. Results are posted back only if that
+// context is still alive.
+template <typename F>
+static void enqueue_if_alive(const std::weak_ptr<qjs::Context> &ctx, F &&job) {
+    if (auto context = ctx.lock()) {
+        context->enqueueJob(std::forward<F>(job));
+    }
+}
+
 void network::get_async(std::string url,
                         std::function<void(std::string)> callback,
                         std::function<void(std::string)> error_callback) {
-    std::thread([url, callback, error_callback,
-                 &ctx = *qjs::Context::current]() {
+    auto ctx = qjs::Context::current->weak_from_this();
+    script_pool().submit(ctx, [url, callback, error_callback, ctx]() {
         try {
             auto res = get(url);
-            ctx.enqueueJob([=]() { callback(res); });
+            enqueue_if_alive(ctx, [=]() { callback(res); });
         } catch (std::exception &e) {
             std::cerr << "Error in network::get_async: " << e.what()
                       << std::endl;
             error_callback(e.what());
         }
-    }).detach();
+    });
 }
 
 void network::post_async(std::string url, std::string data,
                          std::function<void(std::string)> callback,
                          std::function<void(std::string)> error_callback) {
-    std::thread([url, data, callback, error_callback,
-                 &ctx = *qjs::Context::current]() {
+    auto ctx = qjs::Context::current->weak_from_this();
+    script_pool().submit(ctx, [url, data, callback, error_callback, ctx]() {
         try {
             auto res = post(url, data);
-            ctx.enqueueJob([=]() { callback(res); });
+            enqueue_if_alive(ctx, [=]() { callback(res); });
         } catch (std::exception &e) {
             std::cerr << "Error in network::post_async: " << e.what()
                       << std::endl;
             error_callback(e.what());
         }
-    }).detach();
+    });
 }
 subproc_result_data subproc::run(std::string cmd) {
     subproc_result_data result;
@@ -546,15 +605,16 @@ subproc_result_data subproc::run(std::string cmd) {
 }
 void subproc::run_async(std::string cmd,
                         std::function<void(subproc_result_data)> callback) {
-    std::thread([cmd, callback, &ctx = *qjs::Context::current]() {
+    auto ctx = qjs::Context::current->weak_from_this();
+    script_pool().submit(ctx, [cmd, callback, ctx]() {
         try {
             auto res = run(cmd);
-            ctx.enqueueJob([=]() { callback(res); });
+            enqueue_if_alive(ctx, [=]() { callback(res); });
         } catch (std::exception &e) {
             std::cerr << "Error in subproc::run_async: " << e.what()
                       << std::endl;
         }
-    }).detach();
+    });
 }
 void menu_controller::clear() {
     if (!valid())
@@ -627,7 +687,7 @@ std::string breeze::data_directory() {
     return config::data_directory().generic_string();
 }
 bool breeze::should_show_settings_button() {
-    return mb_shell::config::current->context_menu.show_settings_button;
+    return mb_shell::config::current()->context_menu.show_settings_button;
 }
 std::vector<std::string> fs::readdir(std::string path) {
     std::vector<std::string> result;
@@ -643,17 +703,17 @@ void network::download_async(std::string url, std::string path,
                              std::function<void()> callback,
                              std::function<void(std::string)> error_callback) {
 
-    std::thread([url, path, callback, error_callback,
-                 &ctx = *qjs::Context::current]() {
+    auto ctx = qjs::Context::current->weak_from_this();
+    script_pool().submit(ctx, [url, path, callback, error_callback, ctx]() {
         try {
             auto data = get(url);
             fs::write_binary(path,
                              std::vector<uint8_t>(data.begin(), data.end()));
-            ctx.enqueueJob([=]() { callback(); });
+            enqueue_if_alive(ctx, [=]() { callback(); });
         } catch (std::exception &e) {
             error_callback(e.what());
         }
-    }).detach();
+    });
 }
 std::string win32::resid_from_string(std::string str) {
     return res_string_loader::string_to_id_string(utf8_to_wstring(str));
@@ -692,6 +752,10 @@ void breeze::register_translations(
     const std::string& lang,
     const std::map<std::string, std::string>& translations) {
     mb_shell::i18n_manager::instance().register_translations(lang, translations);
+    plugin_modules::on_unload(qjs::Context::current->ctx, [=]() {
+        mb_shell::i18n_manager::instance().unregister_translations(
+            lang, translations);
+    });
 }
 
 std::vector<std::string> breeze::available_languages() {
@@ -701,6 +765,43 @@ std::vector<std::string> breeze::available_languages() {
 void breeze::set_language(const std::string& lang) {
     mb_shell::i18n_manager::instance().set_language(lang);
 }
+
+void breeze::set_tracing(bool enabled) {
+    mb_shell::trace::set_enabled(enabled);
+}
+
+std::string breeze::export_trace() {
+    return mb_shell::trace::export_json(
+               mb_shell::config::data_directory() / "traces")
+        .string();
+}
+
+void breeze::set_profiling(bool enabled) {
+    js_profiler::set_enabled(enabled);
+}
+
+std::string breeze::export_profile() {
+    return js_profiler::export_collapsed(
+               mb_shell::config::data_directory() / "profiles")
+        .string();
+}
+
+js_memory_usage_data breeze::js_memory_usage() {
+    auto arena = js_arena::current();
+    if (!arena)
+        return {};
+    auto stats = arena->statistics();
+    return {stats.bytes_in_use, stats.peak_bytes, stats.reserved_bytes,
+            stats.allocations, stats.live_allocations};
+}
+
+std::vector<menu_listener_stats_data> breeze::menu_listener_stats() {
+    std::vector<menu_listener_stats_data> result;
+    for (auto &s : menu_listener_watchdog::statistics())
+        result.push_back({s.plugin, s.runs, s.overruns, s.total_ms, s.max_ms,
+                          s.deferred});
+    return result;
+}
 std::vector<std::shared_ptr<mb_shell::js::menu_item_controller>>
 menu_item_parent_item_controller::children() {
     if (!valid())
@@ -836,110 +937,24 @@ void subproc::open(std::string path, std::string args) {
 }
 void subproc::open_async(std::string path, std::string args,
                          std::function<void()> callback) {
-    std::thread([path, callback, args, &ctx = *qjs::Context::current]() {
+    auto ctx = qjs::Context::current->weak_from_this();
+    script_pool().submit(ctx, [path, callback, args, ctx]() {
         try {
             open(path, args);
-            ctx.enqueueJob([=]() { callback(); });
+            enqueue_if_alive(ctx, [=]() { callback(); });
         } catch (std::exception &e) {
             std::cerr << "Error in subproc::open_async: " << e.what()
                       << std::endl;
         }
-    }).detach();
-}
-
-struct Timer {
-    std::function<void()> callback;
-    std::weak_ptr<qjs::Context> ctx;
-    int delay;
-    int elapsed = 0;
-    bool repeat;
-    int id;
-};
-
-std::list<std::unique_ptr<Timer>> timers;
-std::optional<std::thread> timer_thread;
-
-void timer_thread_func() {
-    while (true) {
-        constexpr auto sleep_time = 30;
-        Sleep(sleep_time);
-
-        std::vector<std::function<void()>> callbacks;
-        for (auto &timer : timers) {
-            if (!timer || timer->ctx.expired()) {
-                timer = nullptr;
-                continue;
-            }
-            timer->elapsed += sleep_time;
-            if (timer->elapsed >= timer->delay) {
-
-                bool repeat = timer->repeat;
-                timer->elapsed = 0;
-                callbacks.push_back(timer->callback);
-                if (!repeat) {
-                    timer = nullptr;
-                }
-            }
-        }
-
-        timers.erase(std::remove_if(timers.begin(), timers.end(),
-                                    [](const auto &timer) { return !timer; }),
-                     timers.end());
-
-        for (const auto &callback : callbacks) {
-            try {
-                callback();
-            } catch (std::exception &e) {
-                std::cerr << "Error in timer callback: " << e.what()
-                          << std::endl;
-            } catch (...) {
-                std::cerr << "Unknown in timer callback: " << std::endl;
-            }
-        }
-    }
-}
-
-void ensure_timer_thread() {
-    if (!timer_thread) {
-        timer_thread = std::thread(timer_thread_func);
-    }
+    });
 }
 
 int infra::setTimeout(std::function<void()> callback, int delay) {
-    ensure_timer_thread();
-
-    auto timer = std::make_unique<Timer>();
-    timer->callback = callback;
-    timer->delay = delay;
-    timer->repeat = false;
-    timer->ctx = qjs::Context::current->weak_from_this();
-    timer->id = timers.size() + 1;
-    auto id = timer->id;
-    timers.push_back(std::move(timer));
-
-    return id;
-};
-void infra::clearTimeout(int id) {
-    if (auto it = std::find_if(
-            timers.begin(), timers.end(),
-            [id](const auto &timer) { return timer && timer->id == id; });
-        it != timers.end()) {
-        timers.erase(it);
-    }
+    return timer_scheduler::schedule(std::move(callback), delay, false);
 };
+void infra::clearTimeout(int id) { timer_scheduler::cancel(id); };
 int infra::setInterval(std::function<void()> callback, int delay) {
-    ensure_timer_thread();
-
-    auto timer = std::make_unique<Timer>();
-    timer->callback = callback;
-    timer->delay = delay;
-    timer->repeat = true;
-    timer->ctx = qjs::Context::current->weak_from_this();
-    timer->id = timers.size() + 1;
-    auto id = timer->id;
-    timers.push_back(std::move(timer));
-
-    return id;
+    return timer_scheduler::schedule(std::move(callback), delay, true);
 };
 void infra::clearInterval(int id) { clearTimeout(id); };
 std::string infra::atob(std::string base64) {
@@ -994,7 +1009,8 @@ std::string infra::btoa(std::string str) {
 
 void fs::copy_shfile(std::string src_path, std::string dest_path,
                      std::function<void(bool, std::string)> callback) {
-    std::thread([=, &ctx = *qjs::Context::current] {
+    auto ctx = qjs::Context::current->weak_from_this();
+    script_pool().submit(ctx, [=] {
         SHFILEOPSTRUCTW FileOp = {GetForegroundWindow()};
         std::wstring wsrc = utf8_to_wstring(src_path);
         std::wstring wdest = utf8_to_wstring(dest_path);
@@ -1040,13 +1056,14 @@ void fs::copy_shfile(std::string src_path, std::string dest_path,
 
         std::string utf8_path = wstring_to_utf8(final_path);
 
-        ctx.enqueueJob([=]() { callback(success, utf8_path); });
-    }).detach();
+        enqueue_if_alive(ctx, [=]() { callback(success, utf8_path); });
+    });
 }
 
 void fs::move_shfile(std::string src_path, std::string dest_path,
                      std::function<void(bool)> callback) {
-    std::thread([=, &ctx = *qjs::Context::current] {
+    auto ctx = qjs::Context::current->weak_from_this();
+    script_pool().submit(ctx, [=] {
         SHFILEOPSTRUCTW FileOp = {GetForegroundWindow()};
         std::wstring wsrc = utf8_to_wstring(src_path);
         std::wstring wdest = utf8_to_wstring(dest_path);
@@ -1056,8 +1073,8 @@ void fs::move_shfile(std::string src_path, std::string dest_path,
         FileOp.pTo = wdest.c_str();
 
         auto res = SHFileOperationW(&FileOp);
-        ctx.enqueueJob([=]() { callback(res == 0); });
-    }).detach();
+        enqueue_if_alive(ctx, [=]() { callback(res == 0); });
+    });
 }
 size_t win32::load_file_icon(std::string path) {
     SHFILEINFOW sfi = {0};
@@ -1085,7 +1102,11 @@ fs::watch(std::string path, std::function<void(std::string, int)> callback) {
             if (*dispose)
                 return;
             try {
-                callback(path, (int)change_type);
+                // Don't hold the watcher thread while JS handles the event
+                if (!qjs::post_call(callback, path, (int)change_type))
+                    std::cerr << "File watch callback is falling behind, "
+                                 "dropped event for "
+                              << path << std::endl;
             } catch (qjs::qjs_context_destroyed_exception &e) {
                 *dispose = true;
             } catch (std::exception &e) {
@@ -1094,7 +1115,12 @@ fs::watch(std::string path, std::function<void(std::string, int)> callback) {
             }
         });
 
-    return [dispose] { *dispose = true; };
+    auto handle = plugin_modules::on_unload(qjs::Context::current->ctx,
+                                            [dispose] { *dispose = true; });
+    return [dispose, handle] {
+        *dispose = true;
+        plugin_modules::forget(handle);
+    };
 }
 std::shared_ptr<mb_shell::js::menu_controller>
 menu_controller::create_detached() {
@@ -917,6 +917,65 @@ export class subproc {
      */
     static open_async(path: string, args: string, callback: (() => void)): void
 }
+export class js_memory_usage_data {
+	/**
+     *  正在使用的字节数
+     *  Bytes in use
+     */
+    bytes_in_use: number
+	/**
+     *  使用字节数峰值
+     *  Peak bytes in use
+     */
+    peak_bytes: number
+	/**
+     *  从系统申请的字节数
+     *  Bytes reserved from the system
+     */
+    reserved_bytes: number
+	/**
+     *  累计分配次数
+     *  Total number of allocations
+     */
+    allocations: number
+	/**
+     *  尚未释放的分配数
+     *  Allocations not freed yet
+     */
+    live_allocations: number
+}
+export class menu_listener_stats_data {
+	/**
+     *  插件文件名
+     *  Plugin file name
+     */
+    plugin: string
+	/**
+     *  运行次数
+     *  Number of runs
+     */
+    runs: number
+	/**
+     *  超出时间预算而被中止的次数
+     *  Runs aborted for exceeding the time budget
+     */
+    overruns: number
+	/**
+     *  总耗时（毫秒）
+     *  Total time in milliseconds
+     */
+    total_ms: number
+	/**
+     *  单次最长耗时（毫秒）
+     *  Longest run in milliseconds
+     */
+    max_ms: number
+	/**
+     *  是否已改为在菜单显示后运行
+     *  Whether its listeners now run after the menu is shown
+     */
+    deferred: boolean
+}
 export class fs {
 	/**
      *  获取当前工作目录
@@ -1121,6 +1180,44 @@ export class breeze {
      * @returns void
      */
     static set_language(lang: string): void
+	/**
+     *  Enable or disable trace recording
+     *  启用或禁用性能追踪记录
+     * @param enabled: boolean
+     * @returns void
+     */
+    static set_tracing(enabled: boolean): void
+	/**
+     *  Write recorded traces as Chrome trace JSON and return the file path
+     *  将记录的追踪导出为 Chrome trace JSON 文件并返回文件路径
+      @returns string
+     */
+    static export_trace(): string
+	/**
+     *  Enable or disable sampling of JS stacks per plugin
+     *  启用或禁用按插件的 JS 调用栈采样
+     * @param enabled: boolean
+     * @returns void
+     */
+    static set_profiling(enabled: boolean): void
+	/**
+     *  Write sampled JS stacks for flame graphs and return the file path
+     *  将采样的 JS 调用栈导出为折叠格式的火焰图数据文件并返回文件路径
+      @returns string
+     */
+    static export_profile(): string
+	/**
+     *  Memory statistics of the JS runtime
+     *  JS 运行时的内存统计
+      @returns js_memory_usage_data
+     */
+    static js_memory_usage(): js_memory_usage_data
+	/**
+     *  Run statistics of menu listeners per plugin
+     *  按插件统计的菜单监听器运行情况
+      @returns Array<menu_listener_stats_data>
+     */
+    static menu_listener_stats(): Array<menu_listener_stats_data>
 }
 export class win32 {
 	/**
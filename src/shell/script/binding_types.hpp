@@ -2,6 +2,7 @@
 #include <functional>
 #include <future>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <stdlib.h>
 #include <string>
@@ -538,6 +539,58 @@ struct subproc {
                            std::function<void()> callback);
 };
 
+// JS 运行时内存统计
+// JS runtime memory statistics
+struct js_memory_usage_data {
+    // 正在使用的字节数
+    // Bytes in use
+    int64_t bytes_in_use;
+
+    // 使用字节数峰值
+    // Peak bytes in use
+    int64_t peak_bytes;
+
+    // 从系统申请的字节数
+    // Bytes reserved from the system
+    int64_t reserved_bytes;
+
+    // 累计分配次数
+    // Total number of allocations
+    int64_t allocations;
+
+    // 尚未释放的分配数
+    // Allocations not freed yet
+    int64_t live_allocations;
+};
+
+// 插件菜单监听器的运行统计
+// Run statistics of a plugin's menu listeners
+struct menu_listener_stats_data {
+    // 插件文件名
+    // Plugin file name
+    std::string plugin;
+
+    // 运行次数
+    // Number of runs
+    int64_t runs;
+
+    // 超出时间预算而被中止的次数
+    // Runs aborted for exceeding the time budget
+    int64_t overruns;
+
+    // 总耗时（毫秒）
+    // Total time in milliseconds
+    double total_ms;
+
+    // 单次最长耗时（毫秒）
+    // Longest run in milliseconds
+    double max_ms;
+
+    // 是否已改为在菜单显示后运行
+    // Whether its listeners now run after the menu is shown
+    bool deferred;
+};
+
 // 文件系统操作
 // File system operations
 struct fs {
@@ -665,6 +718,30 @@ struct breeze {
     // Set language
     // 设置语言
     static void set_language(const std::string& lang);
+
+    // Enable or disable trace recording
+    // 启用或禁用性能追踪记录
+    static void set_tracing(bool enabled);
+
+    // Write recorded traces as Chrome trace JSON and return the file path
+    // 将记录的追踪导出为 Chrome trace JSON 文件并返回文件路径
+    static std::string export_trace();
+
+    // Enable or disable sampling of JS stacks per plugin
+    // 启用或禁用按插件的 JS 调用栈采样
+    static void set_profiling(bool enabled);
+
+    // Write sampled JS stacks for flame graphs and return the file path
+    // 将采样的 JS 调用栈导出为折叠格式的火焰图数据文件并返回文件路径
+    static std::string export_profile();
+
+    // Memory statistics of the JS runtime
+    // JS 运行时的内存统计
+    static js_memory_usage_data js_memory_usage();
+
+    // Run statistics of menu listeners per plugin
+    // 按插件统计的菜单监听器运行情况
+    static std::vector<menu_listener_stats_data> menu_listener_stats();
 };
 
 struct win32 {
@@ -729,7 +806,10 @@ struct infra {
 } // namespace mb_shell::js
 
 namespace mb_shell {
+// Changed on the JS thread while the renderer thread runs the listeners, so
+// both go through the mutex; the renderer iterates over a copy
 extern std::vector<
     std::shared_ptr<std::function<void(js::menu_info_basic_js)>>>
     menu_callbacks_js;
+extern std::mutex menu_callbacks_js_mutex;
 } // namespace mb_shell
\ No newline at end of file
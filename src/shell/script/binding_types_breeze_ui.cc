@@ -543,7 +543,7 @@ breeze_ui::window::create_ex(std::string title, int width, int height,
     std::thread([win, on_close = std::move(on_close)]() {
         set_thread_name("breeze::js_window_renderer");
         if (auto res = win->$render_target->init(); res) {
-            config::current->apply_fonts_to_nvg(win->$render_target->nvg);
+            config::current()->apply_fonts_to_nvg(win->$render_target->nvg);
             win->$render_target->show();
             win->$render_target->start_loop();
         }
@@ -0,0 +1,136 @@
+#include "bytecode_cache.h"
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <unordered_set>
+
+#include "qjs_build_id.h"
+#include "shell/fnv1a_hash.h"
+#include "shell/logger.h"
+
+namespace mb_shell {
+namespace {
+// Written in front of the bytecode. Bytecode is only readable by the exact
+// QuickJS build that wrote it, and embeds the module name.
+std::string cache_key(std::string_view source,
+                      const std::string &module_name) {
+    return std::format("breeze-qjsbc\n{}\n{}\n{}\n{}:{:016x}\n",
+                       qjs_build_id(), sizeof(void *), module_name,
+                       source.size(), fnv1a_hash(source));
+}
+
+// Plugins with the same file name in different folders get their own entry
+std::filesystem::path cache_path(const std::filesystem::path &cache_dir,
+                                 const std::string &module_name) {
+    return cache_dir /
+           std::format("{}.{:016x}.qjsbc",
+                       std::filesystem::path(module_name).stem().string(),
+                       fnv1a_hash(module_name));
+}
+
+JSValue read_cached(JSContext *ctx, const std::filesystem::path &path,
+                    const std::string &key) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return JS_UNDEFINED;
+
+    std::string data((std::istreambuf_iterator<char>(file)),
+                     std::istreambuf_iterator<char>());
+    if (!data.starts_with(key))
+        return JS_UNDEFINED;
+
+    auto bytecode = reinterpret_cast<const uint8_t *>(data.data()) + key.size();
+    auto func = JS_ReadObject(ctx, bytecode, data.size() - key.size(),
+                              JS_READ_OBJ_BYTECODE);
+    if (JS_IsException(func)) {
+        JS_FreeValue(ctx, JS_GetException(ctx));
+        dbgout("Ignoring unreadable bytecode cache {}", path.string());
+        return JS_UNDEFINED;
+    }
+    return func;
+}
+
+void write_cached(JSContext *ctx, JSValueConst func,
+                  const std::filesystem::path &path, const std::string &key) {
+    size_t size = 0;
+    auto bytecode = JS_WriteObject(ctx, &size, func, JS_WRITE_OBJ_BYTECODE);
+    if (!bytecode) {
+        JS_FreeValue(ctx, JS_GetException(ctx));
+        return;
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(path.parent_path(), ec);
+
+    // Every explorer.exe instance loads the same plugins, so write to a
+    // private file and move it into place
+    auto temp = path;
+    temp += std::format(".{:08x}.tmp", std::random_device{}());
+    {
+        std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+        file << key;
+        file.write(reinterpret_cast<const char *>(bytecode), size);
+    }
+    js_free(ctx, bytecode);
+
+    std::filesystem::rename(temp, path, ec);
+    if (ec) {
+        std::filesystem::remove(temp, ec);
+    }
+}
+} // namespace
+
+JSValue bytecode_cache::compile_module(JSContext *ctx, std::string_view source,
+                                       const std::string &module_name,
+                                       const std::filesystem::path &cache_dir) {
+    auto path = cache_path(cache_dir, module_name);
+    auto key = cache_key(source, module_name);
+
+    if (auto func = read_cached(ctx, path, key); !JS_IsUndefined(func)) {
+        // Compiling resolves imports as well; do the same for cached modules.
+        // On failure QuickJS has already freed the unresolved module.
+        if (JS_ResolveModule(ctx, func) < 0)
+            return JS_EXCEPTION;
+        return func;
+    }
+
+    // JS_Eval wants a null-terminated buffer
+    std::string script(source);
+    auto func = JS_Eval(ctx, script.c_str(), script.size(), module_name.c_str(),
+                        JS_EVAL_TYPE_MODULE | JS_EVAL_FLAG_COMPILE_ONLY);
+    if (!JS_IsException(func)) {
+        write_cached(ctx, func, path, key);
+    }
+    return func;
+}
+
+void bytecode_cache::prune(const std::vector<std::string> &module_names,
+                           const std::filesystem::path &cache_dir) {
+    std::unordered_set<std::string> live;
+    for (auto &module_name : module_names)
+        live.insert(cache_path(cache_dir, module_name).filename().string());
+
+    std::error_code ec;
+    if (!std::filesystem::exists(cache_dir, ec))
+        return;
+
+    try {
+        for (auto &entry : std::filesystem::directory_iterator(cache_dir)) {
+            auto &path = entry.path();
+            // Temporaries may still be written by another process
+            if (path.extension() != ".qjsbc" ||
+                live.contains(path.filename().string()))
+                continue;
+            if (std::filesystem::remove(path, ec))
+                dbgout("Removed stale bytecode cache {}", path.string());
+        }
+    } catch (std::exception &e) {
+        std::cerr << "Failed to prune bytecode cache: " << e.what()
+                  << std::endl;
+    }
+}
+} // namespace mb_shell
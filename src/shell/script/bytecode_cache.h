@@ -0,0 +1,26 @@
+#pragma once
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "quickjs.h"
+
+namespace mb_shell {
+// Compiled plugin modules, serialized with JS_WriteObject into
+// <cache_dir>/<stem>.<path hash>.qjsbc. An entry is only used when
+// the QuickJS build, module name and source hash all match; anything else
+// (stale, corrupt, unreadable) silently falls back to compiling the source.
+struct bytecode_cache {
+    // Drop-in for compiling with JS_EVAL_TYPE_MODULE |
+    // JS_EVAL_FLAG_COMPILE_ONLY: returns the resolved module, or
+    // JS_EXCEPTION with the exception set
+    static JSValue compile_module(JSContext *ctx, std::string_view source,
+                                  const std::string &module_name,
+                                  const std::filesystem::path &cache_dir);
+    // Removes entries of modules not in `module_names`, i.e. of plugins that
+    // were deleted or renamed
+    static void prune(const std::vector<std::string> &module_names,
+                      const std::filesystem::path &cache_dir);
+};
+} // namespace mb_shell
@@ -0,0 +1,251 @@
+#include "js_arena.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <utility>
+
+namespace mb_shell {
+namespace {
+constexpr size_t chunk_size = 64 * 1024;
+constexpr uint32_t large_class = UINT32_MAX;
+
+// In front of every block: the arena it belongs to and its usable size,
+// which QuickJS asks for through js_malloc_usable_size without an arena
+struct alignas(16) block_header {
+    js_arena *arena;
+    uint32_t size_class;
+    uint32_t size;
+};
+constexpr size_t header_size = sizeof(block_header);
+static_assert(header_size == 16);
+
+// Whole block sizes, header included, all multiples of 16 so payloads stay
+// 16-byte aligned
+constexpr std::array<uint32_t, 18> class_sizes = {
+    32,  48,  64,  80,  96,  112, 128, 160, 192,
+    224, 256, 320, 384, 448, 512, 640, 768, 1040};
+constexpr size_t max_pooled_size = class_sizes.back() - header_size;
+
+// Size class for each payload size in 16-byte steps
+constexpr auto class_lookup = [] {
+    std::array<uint8_t, max_pooled_size / 16 + 1> lookup{};
+    uint8_t size_class = 0;
+    for (size_t i = 0; i < lookup.size(); i++) {
+        while (class_sizes[size_class] - header_size < i * 16)
+            size_class++;
+        lookup[i] = size_class;
+    }
+    return lookup;
+}();
+
+block_header *header_of(const void *ptr) {
+    return reinterpret_cast<block_header *>(
+        static_cast<char *>(const_cast<void *>(ptr)) - header_size);
+}
+
+thread_local js_arena *thread_arena = nullptr;
+
+void add(std::atomic<int64_t> &counter, int64_t value, bool owned) {
+    if (owned)
+        counter.store(counter.load(std::memory_order_relaxed) + value,
+                      std::memory_order_relaxed);
+    else
+        counter.fetch_add(value, std::memory_order_relaxed);
+}
+} // namespace
+
+const JSMallocFunctions js_arena::functions = {
+    .js_calloc = [](void *opaque, size_t count, size_t size) -> void * {
+        if (size && count > SIZE_MAX / size)
+            return nullptr;
+        auto ptr = static_cast<js_arena *>(opaque)->allocate(count * size);
+        if (ptr)
+            memset(ptr, 0, count * size);
+        return ptr;
+    },
+    .js_malloc = [](void *opaque, size_t size) -> void * {
+        return static_cast<js_arena *>(opaque)->allocate(size);
+    },
+    .js_free = [](void *opaque, void *ptr) {
+        if (ptr)
+            header_of(ptr)->arena->release(ptr);
+    },
+    .js_realloc = [](void *opaque, void *ptr, size_t size) -> void * {
+        return static_cast<js_arena *>(opaque)->reallocate(ptr, size);
+    },
+    .js_malloc_usable_size = [](const void *ptr) -> size_t {
+        return ptr ? header_of(ptr)->size : 0;
+    },
+};
+
+js_arena::js_arena() {
+    if (!thread_arena)
+        thread_arena = this;
+}
+
+js_arena::~js_arena() {
+    if (thread_arena == this)
+        thread_arena = nullptr;
+    for (auto chunk : chunks)
+        std::free(chunk);
+}
+
+js_arena *js_arena::current() { return thread_arena; }
+
+js_arena::stats js_arena::statistics() const {
+    auto sum = [](const std::atomic<int64_t> &a,
+                  const std::atomic<int64_t> &b) {
+        return a.load(std::memory_order_relaxed) +
+               b.load(std::memory_order_relaxed);
+    };
+    return {sum(local.bytes_in_use, remote.bytes_in_use),
+            peak_bytes.load(std::memory_order_relaxed),
+            sum(local.reserved_bytes, remote.reserved_bytes),
+            sum(local.allocations, remote.allocations),
+            sum(local.live_allocations, remote.live_allocations)};
+}
+
+void js_arena::on_allocated(int64_t size, bool owned) {
+    auto &counters = counters_of(owned);
+    add(counters.allocations, 1, owned);
+    add(counters.live_allocations, 1, owned);
+    add(counters.bytes_in_use, size, owned);
+
+    // Only the owner moves the peak; allocations from other threads count
+    // towards it from the owner's next one
+    if (!owned)
+        return;
+    auto in_use = local.bytes_in_use.load(std::memory_order_relaxed) +
+                  remote.bytes_in_use.load(std::memory_order_relaxed);
+    if (in_use > peak_bytes.load(std::memory_order_relaxed))
+        peak_bytes.store(in_use, std::memory_order_relaxed);
+}
+
+void js_arena::on_released(int64_t size, bool owned) {
+    auto &counters = counters_of(owned);
+    add(counters.live_allocations, -1, owned);
+    add(counters.bytes_in_use, -size, owned);
+}
+
+void *js_arena::allocate(size_t size) {
+    // Other threads shouldn't allocate from a runtime, but if they do they
+    // must not touch the owner's free lists
+    bool owned = std::this_thread::get_id() == owner;
+    if (size > max_pooled_size || !owned)
+        return allocate_large(size, owned);
+
+    auto size_class = class_lookup[(size + 15) / 16];
+    auto &list = free_lists[size_class];
+    if (!list)
+        reclaim_remote_frees();
+
+    void *block;
+    if (list) {
+        block = std::exchange(list, list->next);
+    } else {
+        block = carve(class_sizes[size_class]);
+        if (!block)
+            return nullptr;
+    }
+
+    auto header = new (block) block_header{
+        this, size_class,
+        static_cast<uint32_t>(class_sizes[size_class] - header_size)};
+    on_allocated(header->size, true);
+    return static_cast<char *>(block) + header_size;
+}
+
+void *js_arena::allocate_large(size_t size, bool owned) {
+    if (size > UINT32_MAX - header_size)
+        return nullptr;
+    // Rounded like the pool blocks, so the payload stays 16-byte aligned
+    auto usable = static_cast<uint32_t>((size + 15) & ~size_t(15));
+    auto block = std::malloc(header_size + usable);
+    if (!block)
+        return nullptr;
+    new (block) block_header{this, large_class, usable};
+    add(counters_of(owned).reserved_bytes, header_size + usable, owned);
+    on_allocated(usable, owned);
+    return static_cast<char *>(block) + header_size;
+}
+
+void *js_arena::carve(uint32_t block_size) {
+    if (chunk_end - chunk_next < block_size) {
+        // The tail of the previous chunk is too small for this class and
+        // is left unused
+        auto chunk = static_cast<char *>(std::malloc(chunk_size));
+        if (!chunk)
+            return nullptr;
+        chunks.push_back(chunk);
+        add(local.reserved_bytes, chunk_size, true);
+        chunk_next = chunk;
+        chunk_end = chunk + chunk_size;
+    }
+    return std::exchange(chunk_next, chunk_next + block_size);
+}
+
+void js_arena::release(void *ptr) {
+    auto header = header_of(ptr);
+    bool owned = std::this_thread::get_id() == owner;
+    on_released(header->size, owned);
+
+    if (header->size_class == large_class) {
+        add(counters_of(owned).reserved_bytes,
+            -int64_t(header_size + header->size), owned);
+        std::free(header);
+        return;
+    }
+
+    auto size_class = header->size_class;
+    auto block = new (header) free_block{nullptr, size_class};
+    if (owned) {
+        block->next = free_lists[block->size_class];
+        free_lists[block->size_class] = block;
+        return;
+    }
+
+    auto head = remote_frees.load(std::memory_order_relaxed);
+    do {
+        block->next = head;
+    } while (!remote_frees.compare_exchange_weak(head, block,
+                                                 std::memory_order_release,
+                                                 std::memory_order_relaxed));
+}
+
+void js_arena::reclaim_remote_frees() {
+    auto block = remote_frees.exchange(nullptr, std::memory_order_acquire);
+    while (block) {
+        auto next = block->next;
+        block->next = free_lists[block->size_class];
+        free_lists[block->size_class] = block;
+        block = next;
+    }
+}
+
+void *js_arena::reallocate(void *ptr, size_t size) {
+    if (!ptr)
+        return allocate(size);
+    if (size == 0) {
+        release(ptr);
+        return nullptr;
+    }
+
+    auto header = header_of(ptr);
+    // Kept when the new size still belongs in the same block: the same size
+    // class, or for large blocks, at least half of it
+    bool fits = header->size_class == large_class
+                    ? size <= header->size && size > header->size / 2
+                    : size <= max_pooled_size &&
+                          class_lookup[(size + 15) / 16] == header->size_class;
+    if (fits)
+        return ptr;
+
+    auto resized = allocate(size);
+    if (!resized)
+        return nullptr;
+    memcpy(resized, ptr, std::min<size_t>(size, header->size));
+    release(ptr);
+    return resized;
+}
+} // namespace mb_shell
@@ -0,0 +1,84 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "quickjs.h"
+
+namespace mb_shell {
+// Memory for one QuickJS runtime, passed to JS_NewRuntime2.
+//
+// Blocks up to 1 KiB come from per-size-class free lists carved out of
+// 64 KiB chunks, so the many small, short-lived objects QuickJS allocates
+// skip the system allocator; larger blocks go to malloc. The lists belong
+// to the thread that created the arena (the JS thread) and are used without
+// locks. Blocks freed by other threads, such as JSValues released from
+// native callbacks, are queued lock-free and reclaimed by the owner. Chunks
+// are released all at once when the arena is destroyed, which must happen
+// after JS_FreeRuntime.
+class js_arena {
+public:
+    struct stats {
+        // Requested sizes rounded up to their size class
+        int64_t bytes_in_use;
+        int64_t peak_bytes;
+        // Pool chunks plus large blocks
+        int64_t reserved_bytes;
+        int64_t allocations;
+        int64_t live_allocations;
+    };
+
+    static const JSMallocFunctions functions;
+
+    js_arena();
+    ~js_arena();
+    js_arena(const js_arena &) = delete;
+    js_arena &operator=(const js_arena &) = delete;
+
+    stats statistics() const;
+    // Arena owned by the calling thread, if any
+    static js_arena *current();
+
+private:
+    // Overlays the header of a free block
+    struct free_block {
+        free_block *next;
+        uint32_t size_class;
+    };
+
+    static constexpr size_t class_count = 18;
+
+    // Written by the owner thread only, so it updates them with plain
+    // loads and stores instead of locked read-modify-writes; the rare
+    // allocations and frees from other threads go to a second set
+    struct counters {
+        std::atomic<int64_t> bytes_in_use = 0;
+        std::atomic<int64_t> reserved_bytes = 0;
+        std::atomic<int64_t> allocations = 0;
+        std::atomic<int64_t> live_allocations = 0;
+    };
+
+    void *allocate(size_t size);
+    void release(void *ptr);
+    void *reallocate(void *ptr, size_t size);
+    void *allocate_large(size_t size, bool owned);
+    void *carve(uint32_t block_size);
+    void reclaim_remote_frees();
+    counters &counters_of(bool owned) { return owned ? local : remote; }
+    void on_allocated(int64_t size, bool owned);
+    void on_released(int64_t size, bool owned);
+
+    std::thread::id owner = std::this_thread::get_id();
+    std::array<free_block *, class_count> free_lists{};
+    std::vector<void *> chunks;
+    char *chunk_next = nullptr;
+    char *chunk_end = nullptr;
+    // Pool blocks freed by other threads
+    std::atomic<free_block *> remote_frees = nullptr;
+
+    counters local, remote;
+    std::atomic<int64_t> peak_bytes = 0;
+};
+} // namespace mb_shell
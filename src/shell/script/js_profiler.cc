@@ -0,0 +1,123 @@
+#include "js_profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <format>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "plugin_modules.h"
+#include "shell/logger.h"
+#include "shell/trace.h"
+
+namespace mb_shell {
+namespace {
+constexpr int64_t sample_interval_ns = 1'000'000;
+// Deeper frames are dropped, recursion shouldn't bloat every stack
+constexpr size_t max_depth = 128;
+
+// Collapsed stack -> sample count
+std::mutex samples_mutex;
+std::unordered_map<std::string, uint64_t> samples;
+
+// Reused between samples on the JS thread
+struct sampler {
+    int64_t next_sample = 0;
+    // Innermost first; only the first `depth` are in use
+    std::vector<std::string> frames;
+    size_t depth = 0;
+    std::string stack;
+};
+thread_local sampler local_sampler;
+
+std::string_view file_name_of(std::string_view path) {
+    auto slash = path.find_last_of("/\\");
+    return slash == std::string_view::npos ? path : path.substr(slash + 1);
+}
+
+bool collect_frame(void *opaque, const char *func_name, const char *filename) {
+    auto &s = *static_cast<sampler *>(opaque);
+    if (s.depth == max_depth)
+        return false;
+    if (s.frames.size() == s.depth)
+        s.frames.emplace_back();
+    auto &label = s.frames[s.depth++];
+    label.clear();
+    if (!filename) {
+        label = "[native]";
+        return true;
+    }
+
+    auto module_name = plugin_modules::unversioned(filename);
+    label += func_name && *func_name ? func_name : "(anonymous)";
+    label += " (";
+    label += file_name_of(module_name);
+    label += ")";
+    // ';' separates frames and the count follows the last space of a line
+    std::ranges::replace(label, ';', ',');
+    std::ranges::replace(label, '\n', ' ');
+    return true;
+}
+} // namespace
+
+void js_profiler::set_enabled(bool enable) {
+    if (enable && !enabled.load()) {
+        std::lock_guard lock(samples_mutex);
+        samples.clear();
+    }
+    if (enabled.exchange(enable) != enable)
+        dbgout("JS profiler {}", enable ? "enabled" : "disabled");
+}
+
+void js_profiler::sample_if_due(JSRuntime *rt) {
+    auto &s = local_sampler;
+    auto now = trace::now();
+    if (now < s.next_sample)
+        return;
+    s.next_sample = now + sample_interval_ns;
+
+    s.depth = 0;
+    JS_WalkStack(rt, collect_frame, &s);
+    if (!s.depth)
+        return;
+
+    // Attributed like the resources a plugin creates
+    auto plugin = plugin_modules::caller(rt);
+    s.stack = plugin.empty() ? "(breeze)" : plugin.filename().string();
+    for (auto i = s.depth; i-- > 0;) {
+        s.stack += ';';
+        s.stack += s.frames[i];
+    }
+
+    std::lock_guard lock(samples_mutex);
+    samples[s.stack]++;
+}
+
+std::filesystem::path
+js_profiler::export_collapsed(const std::filesystem::path &directory) {
+    std::filesystem::create_directories(directory);
+    auto path = directory /
+                std::format("profile-{:%Y%m%d-%H%M%S}.folded",
+                            std::chrono::floor<std::chrono::seconds>(
+                                std::chrono::system_clock::now()));
+
+    std::vector<std::pair<std::string, uint64_t>> lines;
+    {
+        std::lock_guard lock(samples_mutex);
+        lines.assign(samples.begin(), samples.end());
+    }
+    std::ranges::sort(lines);
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out)
+        throw std::runtime_error("Failed to open " + path.string());
+    for (auto &[stack, count] : lines)
+        out << stack << ' ' << count << '\n';
+    dbgout("Exported {} JS profile stacks to {}", lines.size(), path.string());
+    return path;
+}
+} // namespace mb_shell
@@ -0,0 +1,36 @@
+#pragma once
+#include <atomic>
+#include <filesystem>
+
+#include "quickjs.h"
+
+namespace mb_shell {
+// Sampling CPU profiler for plugin code.
+//
+// QuickJS calls the runtime's interrupt handler every few thousand bytecode
+// instructions while JS is running. Once per sample interval the handler
+// walks the JS stack and counts it under the plugin whose file is outermost
+// on it, i.e. the plugin whose listener or callback is being run. Idle time
+// isn't sampled, and neither are long native calls until they return to JS.
+//
+// Profiles are exported as collapsed stacks, one "plugin;outer;inner count"
+// line per distinct stack, which flamegraph.pl, inferno and speedscope read
+// directly. While disabled, the handler costs one relaxed load.
+struct js_profiler {
+    static inline std::atomic<bool> enabled = false;
+
+    // Enabling starts a new profile
+    static void set_enabled(bool enable);
+    // Called from the interrupt handler on the JS thread
+    static void on_interrupt(JSRuntime *rt) {
+        if (enabled.load(std::memory_order_relaxed))
+            sample_if_due(rt);
+    }
+    // Writes <directory>/profile-<time>.folded and returns its path
+    static std::filesystem::path
+    export_collapsed(const std::filesystem::path &directory);
+
+private:
+    static void sample_if_due(JSRuntime *rt);
+};
+} // namespace mb_shell
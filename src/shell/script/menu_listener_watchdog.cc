@@ -0,0 +1,138 @@
+#include "menu_listener_watchdog.h"
+#include <algorithm>
+#include <format>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <utility>
+
+#include "quickjspp.hpp"
+#include "shell/trace.h"
+
+namespace mb_shell {
+namespace {
+// Deferred listeners don't hold up the menu, but a stuck one would still
+// block every other script
+constexpr int deferred_budget_scale = 10;
+
+std::mutex mutex;
+std::map<std::string, menu_listener_watchdog::plugin_stats> stats;
+
+// Only touched on the JS thread; 0 while no listener runs under a budget
+thread_local int64_t deadline = 0;
+thread_local bool overran = false;
+
+bool is_deferred(const std::string &plugin) {
+    std::lock_guard lock(mutex);
+    auto it = stats.find(plugin);
+    return it != stats.end() && it->second.deferred;
+}
+
+void record(const std::string &plugin, int64_t elapsed_ns, bool aborted,
+            bool defer) {
+    auto ms = elapsed_ns / 1e6;
+    std::lock_guard lock(mutex);
+    auto &s = stats[plugin];
+    s.plugin = plugin;
+    s.runs++;
+    s.total_ms += ms;
+    s.max_ms = std::max(s.max_ms, ms);
+    if (aborted) {
+        s.overruns++;
+        s.deferred = s.deferred || defer;
+    }
+}
+
+// On the JS thread
+void run_listener(const std::string &plugin,
+                  const std::function<void()> &listener, int budget_ms,
+                  bool defer) {
+    auto start = trace::now();
+    auto previous_deadline = std::exchange(
+        deadline, budget_ms > 0 ? start + budget_ms * int64_t(1'000'000) : 0);
+    auto previous_overran = std::exchange(overran, false);
+
+    bool aborted = false;
+    try {
+        listener();
+    } catch (std::exception &e) {
+        aborted = overran;
+        if (!aborted)
+            std::cerr << "Error in listener of " << plugin << ": " << e.what()
+                      << std::endl;
+    }
+    deadline = previous_deadline;
+    overran = previous_overran;
+
+    auto elapsed = trace::now() - start;
+    if (aborted) {
+        std::cerr << std::format(
+                         "Menu listener of {} aborted after {:.1f} ms, over "
+                         "its {} ms budget{}",
+                         plugin, elapsed / 1e6, budget_ms,
+                         defer ? "; it will run after the menu is shown"
+                               : "")
+                  << std::endl;
+    }
+    record(plugin, elapsed, aborted, defer);
+}
+} // namespace
+
+void menu_listener_watchdog::run(const std::string &plugin,
+                                 const std::weak_ptr<qjs::Context> &ctx,
+                                 budget limit, std::function<void()> listener) {
+    auto context = ctx.lock();
+    if (!context)
+        return;
+    auto budget_ms = limit.ms;
+    auto defer = limit.defer;
+
+    if (defer && is_deferred(plugin)) {
+        context->enqueueJob([plugin, budget_ms,
+                             listener = std::move(listener)] {
+            run_listener(plugin, listener, budget_ms * deferred_budget_scale,
+                         false);
+        });
+        return;
+    }
+
+    if (is_thread_js_main) {
+        run_listener(plugin, listener, budget_ms, defer);
+        return;
+    }
+
+    // Also signaled when the job is dropped unrun with its context, so the
+    // context must not be kept alive while waiting
+    qjs::msgloop_waiter waiter;
+    qjs::waiter_signal done(&waiter);
+    context->enqueueJob([&, done = std::move(done)]() mutable {
+        run_listener(plugin, listener, budget_ms, defer);
+        // Must be the last access to this frame
+        done.reset();
+    });
+    context.reset();
+    waiter.wait();
+}
+
+bool menu_listener_watchdog::on_interrupt() {
+    if (!deadline || trace::now() < deadline)
+        return false;
+    overran = true;
+    return true;
+}
+
+void menu_listener_watchdog::reinstate(const std::string &plugin) {
+    std::lock_guard lock(mutex);
+    if (auto it = stats.find(plugin); it != stats.end())
+        it->second.deferred = false;
+}
+
+std::vector<menu_listener_watchdog::plugin_stats>
+menu_listener_watchdog::statistics() {
+    std::lock_guard lock(mutex);
+    std::vector<plugin_stats> result;
+    for (auto &[plugin, s] : stats)
+        result.push_back(s);
+    return result;
+}
+} // namespace mb_shell
@@ -0,0 +1,54 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace qjs {
+class Context;
+}
+
+namespace mb_shell {
+// Keeps one slow plugin from holding up every context menu.
+//
+// Menu listeners run before the menu is shown, each on the JS thread within
+// a budget, config::context_menu.listener_budget_ms in the shell. A listener still running past
+// its budget is aborted from the runtime's interrupt handler with an
+// uncatchable error. The handler only runs while JS is executing, so a
+// listener blocked in a native call is stopped once that call returns.
+//
+// With `defer` (context_menu.defer_slow_listeners), listeners of a plugin that was
+// aborted are queued to run after the menu is shown from then on, until the
+// plugin is reloaded. They get a much larger budget there, so a listener
+// that never returns can't stall the JS thread either.
+struct menu_listener_watchdog {
+    struct plugin_stats {
+        // Script file name of the plugin
+        std::string plugin;
+        int64_t runs = 0;
+        int64_t overruns = 0;
+        double total_ms = 0;
+        double max_ms = 0;
+        bool deferred = false;
+    };
+
+    struct budget {
+        // 0 for no limit
+        int ms = 0;
+        bool defer = false;
+    };
+
+    // Runs `listener` on the JS thread of `ctx` and waits for it, or only
+    // queues it if the plugin is deferred
+    static void run(const std::string &plugin,
+                    const std::weak_ptr<qjs::Context> &ctx, budget limit,
+                    std::function<void()> listener);
+    // Called from the interrupt handler on the JS thread; true once the
+    // running listener is over its budget
+    static bool on_interrupt();
+    // Lets a reloaded plugin run before the menu is shown again
+    static void reinstate(const std::string &plugin);
+    static std::vector<plugin_stats> statistics();
+};
+} // namespace mb_shell
@@ -0,0 +1,168 @@
+#include "plugin_modules.h"
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <set>
+
+#include "quickjspp.hpp"
+
+namespace mb_shell {
+namespace {
+struct registration {
+    std::string owner;
+    std::function<void()> dispose;
+};
+
+// on_unload is called on the JS thread, forget also from the timer thread
+std::mutex mutex;
+std::filesystem::path script_directory;
+// Keyed by file_key()
+std::map<std::string, int> generations;
+std::map<std::string, std::set<std::string>> importers;
+std::map<uint64_t, registration> registrations;
+uint64_t next_handle = 1;
+
+// The embedded runtime calls into the host on behalf of plugins, so its
+// frames are skipped when looking for the owner
+constexpr std::string_view runtime_module = "breeze-script.js";
+
+std::string file_key(const std::filesystem::path &file) {
+    return file.lexically_normal().generic_string();
+}
+
+std::string owner_of(JSRuntime *rt) {
+    // The walk goes outwards, so the last plugin frame seen is the owner
+    std::string owner_name;
+    JS_WalkStack(
+        rt,
+        [](void *opaque, const char *, const char *filename) {
+            // Native frames have no file name
+            if (filename && plugin_modules::unversioned(filename) !=
+                                runtime_module)
+                *static_cast<std::string *>(opaque) = filename;
+            return true;
+        },
+        &owner_name);
+    if (owner_name.empty())
+        return {};
+    return file_key(plugin_modules::file_of(owner_name));
+}
+} // namespace
+
+void plugin_modules::reset(const std::filesystem::path &directory) {
+    std::lock_guard lock(mutex);
+    script_directory = directory;
+    generations.clear();
+    importers.clear();
+    registrations.clear();
+}
+
+std::string plugin_modules::normalize(std::string_view base_name,
+                                      std::string_view name) {
+    auto normalized =
+        qjs::detail::normalizeModuleName(unversioned(base_name), name);
+    auto file = file_of(normalized);
+    if (!std::filesystem::exists(file))
+        return normalized;
+
+    auto key = file_key(file);
+    std::lock_guard lock(mutex);
+    importers[key].insert(file_key(file_of(base_name)));
+    if (auto generation = generations[key])
+        normalized += "@" + std::to_string(generation);
+    return normalized;
+}
+
+std::string_view plugin_modules::unversioned(std::string_view module_name) {
+    auto at = module_name.rfind('@');
+    if (at == std::string_view::npos || at + 1 == module_name.size())
+        return module_name;
+    auto generation = module_name.substr(at + 1);
+    if (!std::ranges::all_of(generation,
+                             [](char c) { return c >= '0' && c <= '9'; }))
+        return module_name;
+    return module_name.substr(0, at);
+}
+
+std::filesystem::path plugin_modules::file_of(std::string_view module_name) {
+    auto name = std::string(unversioned(module_name));
+    // Plugins are evaluated under their full path, imports name the file
+    // without extension
+    if (!name.ends_with(".js"))
+        name += ".js";
+    return script_directory / std::filesystem::path(name);
+}
+
+std::filesystem::path plugin_modules::caller(JSRuntime *rt) {
+    return owner_of(rt);
+}
+
+uint64_t plugin_modules::on_unload(JSContext *ctx,
+                                   std::function<void()> dispose) {
+    auto owner = owner_of(JS_GetRuntime(ctx));
+    if (owner.empty())
+        return 0;
+
+    std::lock_guard lock(mutex);
+    auto handle = next_handle++;
+    registrations.emplace(handle,
+                          registration{std::move(owner), std::move(dispose)});
+    return handle;
+}
+
+void plugin_modules::forget(uint64_t handle) {
+    if (!handle)
+        return;
+    std::lock_guard lock(mutex);
+    registrations.erase(handle);
+}
+
+std::vector<std::filesystem::path> plugin_modules::invalidate(
+    const std::vector<std::filesystem::path> &changed) {
+    std::vector<std::function<void()>> disposers;
+    std::vector<std::filesystem::path> affected;
+    {
+        std::lock_guard lock(mutex);
+        std::set<std::string> keys;
+        std::vector<std::string> pending;
+        for (auto &file : changed)
+            pending.push_back(file_key(file));
+        while (!pending.empty()) {
+            auto key = std::move(pending.back());
+            pending.pop_back();
+            if (!keys.insert(key).second)
+                continue;
+            if (auto it = importers.find(key); it != importers.end())
+                pending.insert(pending.end(), it->second.begin(),
+                               it->second.end());
+        }
+
+        for (auto &key : keys) {
+            generations[key]++;
+            affected.emplace_back(key);
+        }
+        // Edges from the affected files are recorded again when they are
+        // evaluated
+        for (auto &[file, from] : importers)
+            std::erase_if(from, [&](auto &key) { return keys.contains(key); });
+        std::erase_if(registrations, [&](auto &entry) {
+            if (!keys.contains(entry.second.owner))
+                return false;
+            disposers.push_back(std::move(entry.second.dispose));
+            return true;
+        });
+    }
+
+    // Without the lock, disposers may call forget()
+    for (auto &dispose : disposers) {
+        try {
+            dispose();
+        } catch (std::exception &e) {
+            std::cerr << "Error disposing plugin resource: " << e.what()
+                      << std::endl;
+        }
+    }
+    return affected;
+}
+} // namespace mb_shell
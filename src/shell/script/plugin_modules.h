@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "quickjs.h"
+
+namespace mb_shell {
+// Bookkeeping that lets a changed plugin be reloaded in the live runtime.
+//
+// Imports of script files are recorded, so a change can be propagated to
+// every plugin depending on the file, and once a file has changed its
+// imports are renamed to "<name>@<generation>" so importers evaluated again
+// get a fresh instance instead of the one cached in the context.
+//
+// Host resources created by plugin code (menu listeners, timers, file
+// watches, translations) are attributed to the plugin on the stack, see
+// caller(), and released when its file is unloaded.
+struct plugin_modules {
+    // Starts over for a new runtime loading plugins from `directory`.
+    // Registrations of the previous runtime are dropped without running them.
+    static void reset(const std::filesystem::path &directory);
+
+    // For qjs::Context::moduleNormalizer
+    static std::string normalize(std::string_view base_name,
+                                 std::string_view name);
+    // Module name without the generation normalize() may have added
+    static std::string_view unversioned(std::string_view module_name);
+    // Script file a module name refers to
+    static std::filesystem::path file_of(std::string_view module_name);
+
+    // Script file of the plugin calling into the host: that of the
+    // outermost plugin frame on the stack, so what a plugin creates through
+    // a helper in another file still belongs to the plugin. Frames of the
+    // embedded runtime are skipped. Empty when no plugin is on the stack.
+    // Also used to attribute profiler samples.
+    static std::filesystem::path caller(JSRuntime *rt);
+    static std::filesystem::path caller(JSContext *ctx) {
+        return caller(JS_GetRuntime(ctx));
+    }
+    // Runs `dispose` when the plugin calling into the host is unloaded.
+    // Returns a handle for forget(), or 0 when no plugin is on the stack.
+    static uint64_t on_unload(JSContext *ctx, std::function<void()> dispose);
+    // Drops a registration whose resource was released some other way
+    static void forget(uint64_t handle);
+
+    // Unloads the changed files and everything importing them, directly or
+    // not, and returns all of them; they need to be evaluated again
+    static std::vector<std::filesystem::path>
+    invalidate(const std::vector<std::filesystem::path> &changed);
+};
+} // namespace mb_shell
@@ -0,0 +1,19 @@
+#pragma once
+#include <format>
+#include <string>
+
+#include "quickjs.h"
+
+#ifndef BREEZE_QJS_BUILD_ID
+#error "BREEZE_QJS_BUILD_ID is set by the qjs.build_id rule in xmake.lua"
+#endif
+
+namespace mb_shell {
+// Identifies the QuickJS build that serialized bytecode, which no other
+// build can read safely: JS_ReadObject doesn't validate it. JS_GetVersion()
+// stays the same when the vendored sources are patched, so the build id
+// adds a hash of them.
+inline std::string qjs_build_id() {
+    return std::format("{}+{}", JS_GetVersion(), BREEZE_QJS_BUILD_ID);
+}
+} // namespace mb_shell
@@ -2008,13 +2008,10 @@ void JS_SetSharedArrayBufferFunctions(JSRuntime *rt,
     rt->sab_funcs = *sf;
 }
 
-extern void qjs_notify_job_enqueued(JSContext*);
-
 /* return 0 if OK, < 0 if exception */
 int JS_EnqueueJob(JSContext *ctx, JSJobFunc *job_func,
                   int argc, JSValueConst *argv)
 {
-    qjs_notify_job_enqueued(ctx);
     JSRuntime *rt = ctx->rt;
     JSJobEntry *e;
     int i;
@@ -28866,6 +28863,39 @@ JSAtom JS_GetScriptOrModuleName(JSContext *ctx, int n_stack_levels)
     return JS_DupAtom(ctx, b->filename);
 }
 
+/* Call 'cb' for each frame of the current stack, innermost first, with
+   the function name (NULL if anonymous) and script filename (NULL for
+   native frames). Nothing is allocated and no JS code runs, so it can be
+   used from an interrupt handler. Stops early when 'cb' returns false. */
+void JS_WalkStack(JSRuntime *rt, JSStackWalkFunc *cb, void *opaque)
+{
+    JSStackFrame *sf;
+    JSFunctionBytecode *b;
+    JSObject *p;
+    char func_name_buf[ATOM_GET_STR_BUF_SIZE];
+    char filename_buf[1024];
+    const char *func_name, *filename;
+
+    for (sf = rt->current_stack_frame; sf; sf = sf->prev_frame) {
+        func_name = NULL;
+        filename = NULL;
+        if (JS_VALUE_GET_TAG(sf->cur_func) == JS_TAG_OBJECT) {
+            p = JS_VALUE_GET_OBJ(sf->cur_func);
+            if (js_class_has_bytecode(p->class_id)) {
+                b = p->u.func.function_bytecode;
+                if (b->func_name != JS_ATOM_NULL)
+                    func_name = JS_AtomGetStrRT(rt, func_name_buf,
+                                                sizeof(func_name_buf),
+                                                b->func_name);
+                filename = JS_AtomGetStrRT(rt, filename_buf,
+                                           sizeof(filename_buf), b->filename);
+            }
+        }
+        if (!cb(opaque, func_name, filename))
+            break;
+    }
+}
+
 JSAtom JS_GetModuleName(JSContext *ctx, JSModuleDef *m)
 {
     return JS_DupAtom(ctx, m->module_name);
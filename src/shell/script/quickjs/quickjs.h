@@ -1121,6 +1121,10 @@ JS_EXTERN int JS_ResolveModule(JSContext *ctx, JSValueConst obj);
 
 /* only exported for os.Worker() */
 JS_EXTERN JSAtom JS_GetScriptOrModuleName(JSContext *ctx, int n_stack_levels);
+/* for sampling profilers, see JS_WalkStack() in quickjs.c */
+typedef bool JSStackWalkFunc(void *opaque, const char *func_name,
+                             const char *filename);
+JS_EXTERN void JS_WalkStack(JSRuntime *rt, JSStackWalkFunc *cb, void *opaque);
 /* only exported for os.Worker() */
 JS_EXTERN JSValue JS_LoadModule(JSContext *ctx, const char *basename,
                                 const char *filename);
@@ -1,26 +1,86 @@
 #include "quickjspp.hpp"
-#include <print>
+#include <iostream>
 
 namespace qjs {
 thread_local Context *Context::current;
-void wait_with_msgloop(std::function<void()> f) {
-    auto this_thread = GetCurrentThreadId();
-    bool completed_flag = false;
-    auto thread_wait = std::thread([=, &completed_flag]() {
-        f();
-        completed_flag = true;
-        PostThreadMessageW(this_thread, WM_NULL, 0, 0);
-    });
-
-    MSG msg;
-    while (GetMessageW(&msg, nullptr, 0, 0)) {
-        TranslateMessage(&msg);
-        DispatchMessageW(&msg);
-
-        if (completed_flag) {
-            break;
+#ifdef _WIN32
+namespace {
+// Free auto-reset events owned by this thread
+struct waiter_events {
+    std::vector<HANDLE> events;
+    ~waiter_events() {
+        for (auto event : events)
+            CloseHandle(event);
+    }
+};
+thread_local waiter_events free_events;
+} // namespace
+
+msgloop_waiter::msgloop_waiter() {
+    if (!free_events.events.empty()) {
+        event = free_events.events.back();
+        free_events.events.pop_back();
+        return;
+    }
+
+    event = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+    if (!event)
+        throw std::runtime_error("CreateEventW failed");
+}
+
+msgloop_waiter::~msgloop_waiter() {
+    // Don't hand a signaled event to the next waiter if wait() was skipped
+    ResetEvent(event);
+    free_events.events.push_back(event);
+}
+
+void msgloop_waiter::notify() { SetEvent(event); }
+
+void msgloop_waiter::wait() {
+    while (true) {
+        auto res = MsgWaitForMultipleObjectsEx(1, &event, INFINITE, QS_ALLINPUT,
+                                               MWMO_INPUTAVAILABLE);
+        if (res == WAIT_OBJECT_0)
+            return;
+
+        if (res != WAIT_OBJECT_0 + 1) {
+            std::cerr << "MsgWaitForMultipleObjectsEx failed: "
+                      << GetLastError() << std::endl;
+            WaitForSingleObject(event, INFINITE);
+            return;
+        }
+
+        MSG msg;
+        while (PeekMessageW(&msg, nullptr, 0, 0, PM_REMOVE)) {
+            if (msg.message == WM_QUIT) {
+                // Leave WM_QUIT to the thread's own loop and stop pumping
+                PostQuitMessage(static_cast<int>(msg.wParam));
+                WaitForSingleObject(event, INFINITE);
+                return;
+            }
+
+            TranslateMessage(&msg);
+            DispatchMessageW(&msg);
         }
     }
-    thread_wait.join();
 }
-} // namespace qjs
\ No newline at end of file
+#else
+msgloop_waiter::msgloop_waiter() = default;
+msgloop_waiter::~msgloop_waiter() = default;
+
+void msgloop_waiter::notify() {
+    // Notified under the lock: the waiter may return and be destroyed as soon
+    // as it is released
+    std::lock_guard lock(mutex);
+    notified = true;
+    cv.notify_one();
+}
+
+void msgloop_waiter::wait() {
+    std::unique_lock lock(mutex);
+    cv.wait(lock, [this] { return notified; });
+    // Reset like the auto-reset event on Windows
+    notified = false;
+}
+#endif
+} // namespace qjs
@@ -5,6 +5,8 @@
 #include <algorithm>
 #include <atomic>
 #include <cassert>
+#include <chrono>
+#include <condition_variable>
 #include <cstddef>
 #include <cstdio>
 #include <expected>
@@ -26,11 +28,14 @@
 #include <tuple>
 #include <type_traits>
 #include <map>
+#include <utility>
 #include <unordered_map>
 #include <variant>
 #include <vector>
 
+#ifdef _WIN32
 #include "Windows.h"
+#endif
 extern thread_local bool is_thread_js_main;
 #if defined(__cpp_rtti)
 #define QJSPP_TYPENAME(...) (typeid(__VA_ARGS__).name())
@@ -44,8 +49,45 @@ class Value;
 inline void setCurrentContext(JSContext *);
 inline JSContext *getContextFromWrapped(Context *);
 inline std::weak_ptr<Context> weakFromContext(JSContext *);
+/** Set while ~Context drops its unrun jobs: weak pointers to the context
+ * have expired by then, but values owned by those jobs can still be freed */
+inline thread_local JSContext *droppingJobsOf = nullptr;
+
+/** Blocks the calling thread until notify() is called from any thread, while
+ * still dispatching the calling thread's window messages. Waits use an event
+ * handle recycled per thread, so no thread or kernel object is created per
+ * wait once warmed up. Nested waits (started from a message dispatched while
+ * waiting) each get their own event.
+ * Elsewhere there are no window messages to dispatch, and it is a plain
+ * condition variable wait.
+ */
+class msgloop_waiter {
+public:
+    msgloop_waiter();
+    ~msgloop_waiter();
+    msgloop_waiter(const msgloop_waiter &) = delete;
+    msgloop_waiter &operator=(const msgloop_waiter &) = delete;
+
+    void notify();
+    void wait();
 
-void wait_with_msgloop(std::function<void()> f);
+private:
+#ifdef _WIN32
+    HANDLE event;
+#else
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool notified = false;
+#endif
+};
+
+/** unique_ptr deleter that signals the waiter. A queued job owning a
+ * waiter_signal wakes its waiter even when it is dropped without running,
+ * e.g. by a context being torn down. */
+struct notify_waiter {
+    void operator()(msgloop_waiter *waiter) const { waiter->notify(); }
+};
+using waiter_signal = std::unique_ptr<msgloop_waiter, notify_waiter>;
 /** Exception type.
  * Indicates that exception has occured in JS context.
  */
@@ -1344,7 +1386,8 @@ public:
     bool operator!=(const Value &rhs) const { return !((*this) == rhs); }
 
     ~Value() {
-        if (ctx && (ctx_holder.has_value() && !ctx_holder.value().expired()))
+        if (ctx && ((ctx_holder.has_value() && !ctx_holder.value().expired()) ||
+                    ctx == droppingJobsOf))
             JS_FreeValue(ctx, v);
     }
 
@@ -1480,15 +1523,19 @@ class Runtime {
 public:
     JSRuntime *rt;
 
-    Runtime() {
-        rt = JS_NewRuntime();
+    Runtime() : Runtime(nullptr, nullptr) {}
+
+    /** Allocates through mf (see JS_NewRuntime2), or QuickJS's default
+     * malloc when null; opaque must outlive the runtime */
+    Runtime(const JSMallocFunctions *mf, void *opaque) {
+        rt = mf ? JS_NewRuntime2(mf, opaque) : JS_NewRuntime();
         JS_SetMaxStackSize(rt, 0);
         if (!rt)
             throw std::runtime_error{"qjs: Cannot create runtime"};
 
         JS_SetHostPromiseRejectionTracker(
             rt, promise_unhandled_rejection_tracker, NULL);
-        JS_SetModuleLoaderFunc(rt, nullptr, module_loader, nullptr);
+        JS_SetModuleLoaderFunc(rt, module_normalize, module_loader, nullptr);
     }
 
     // noncopyable
@@ -1509,6 +1556,9 @@ private:
                                                     bool is_handled,
                                                     void *opaque);
 
+    static char *module_normalize(JSContext *ctx, const char *module_base_name,
+                                  const char *module_name, void *opaque);
+
     static JSModuleDef *module_loader(JSContext *ctx, const char *module_name,
                                       void *opaque);
 };
@@ -1527,6 +1577,43 @@ readFile(std::filesystem::path const &filepath) {
     return sstream.str();
 }
 
+/** QuickJS's default module name normalization: specifiers starting with
+ * "./" or "../" are resolved against the directory of the importing module,
+ * anything else is used as is */
+inline std::string normalizeModuleName(std::string_view base_name,
+                                       std::string_view name) {
+    if (!name.starts_with('.'))
+        return std::string{name};
+
+    auto slash = base_name.rfind('/');
+    std::string filename{
+        base_name.substr(0, slash == std::string_view::npos ? 0 : slash)};
+
+    // only the leading '..' or '.' are normalized
+    while (true) {
+        if (name.starts_with("./")) {
+            name.remove_prefix(2);
+        } else if (name.starts_with("../")) {
+            if (filename.empty())
+                break;
+            auto p = filename.rfind('/');
+            auto last = p == std::string::npos ? std::string_view{filename}
+                                               : std::string_view{filename}
+                                                     .substr(p + 1);
+            if (last == "." || last == "..")
+                break;
+            filename.resize(p == std::string::npos ? 0 : p);
+            name.remove_prefix(3);
+        } else {
+            break;
+        }
+    }
+    if (!filename.empty())
+        filename += '/';
+    filename += name;
+    return filename;
+}
+
 inline std::string toUri(std::string_view filename) {
     auto fname = std::string{filename};
     if (fname.find("://") < fname.find("/"))
@@ -1551,9 +1638,6 @@ class Context : public std::enable_shared_from_this<Context> {
 public:
     JSContext *ctx;
     thread_local static Context *current;
-    // for starting jobs quickly
-    std::atomic_int pending_job_count = 0;
-    std::recursive_mutex js_mutex;
     /** Module wrapper
      * Workaround for lack of opaque pointer for module load function by keeping
      * a list of modules in qjs::Context.
@@ -1802,6 +1886,58 @@ public:
     std::vector<Module> modules;
 
 private:
+    struct InboundJob {
+        std::move_only_function<void()> run;
+        InboundJob *next;
+    };
+    // Jobs posted by any thread, newest first. Producers only swap the head
+    // pointer, so they never wait for the JS thread, even while it is busy.
+    std::atomic<InboundJob *> inbound = nullptr;
+    std::atomic<uint32_t> wakeups = 0;
+    std::atomic<bool> stopping = false;
+    // Released after JS_FreeContext, see Context(std::shared_ptr<Runtime>)
+    std::shared_ptr<Runtime> runtime;
+
+    // Everything posted so far, oldest first
+    InboundJob *takeInbound() {
+        auto job = inbound.exchange(nullptr, std::memory_order_acquire);
+        InboundJob *reversed = nullptr;
+        while (job) {
+            auto next = job->next;
+            job->next = reversed;
+            reversed = job;
+            job = next;
+        }
+        return reversed;
+    }
+
+    void wake() {
+        wakeups.fetch_add(1, std::memory_order_release);
+        wakeups.notify_one();
+    }
+
+    void reportException(JSContext *job_ctx, std::string_view what) {
+        auto exception = JS_GetException(job_ctx);
+        auto message = JS_ToCString(job_ctx, exception);
+        auto stack = JS_GetPropertyStr(job_ctx, exception, "stack");
+        auto stack_str = JS_ToCString(job_ctx, stack);
+        std::cerr << what << (message ? message : "unknown error")
+                  << (stack_str ? stack_str : "") << std::endl;
+        JS_FreeCString(job_ctx, stack_str);
+        JS_FreeCString(job_ctx, message);
+        JS_FreeValue(job_ctx, stack);
+        JS_FreeValue(job_ctx, exception);
+    }
+
+    // Promise reactions and other jobs QuickJS queued itself
+    void runMicrotasks() {
+        JSContext *job_ctx;
+        while (int res = JS_ExecutePendingJob(JS_GetRuntime(ctx), &job_ctx)) {
+            if (res < 0)
+                reportException(job_ctx, "Error executing pending JS job: ");
+        }
+    }
+
     void init() {
         JS_SetContextOpaque(ctx, this);
         js_traits<detail::function>::register_class(ctx, "C++ function");
@@ -1810,6 +1946,13 @@ private:
 public:
     Context(Runtime &rt) : Context(rt.rt) {}
 
+    /** Keeps rt alive until this context is freed. The last reference to a
+     * context can be dropped on any thread, after its owner let go of the
+     * runtime. */
+    Context(std::shared_ptr<Runtime> rt) : Context(rt->rt) {
+        runtime = std::move(rt);
+    }
+
     Context(JSRuntime *rt) {
         ctx = JS_NewContext(rt);
         if (!ctx)
@@ -1823,6 +1966,11 @@ public:
     Context(const Context &) = delete;
 
     ~Context() {
+        // Jobs that never got to run may own JS values
+        droppingJobsOf = ctx;
+        for (auto job = takeInbound(); job;)
+            delete std::exchange(job, job->next);
+        droppingJobsOf = nullptr;
         // modules.clear();
         JS_FreeContext(ctx);
     }
@@ -1841,14 +1989,35 @@ public:
             : source(std::move(source)), url(std::move(url)) {}
     };
 
+    /** Function called to turn an import specifier into a module name,
+     * given the name of the importing module. Modules are cached by the
+     * resulting name. Defaults to detail::normalizeModuleName */
+    std::function<std::string(std::string_view, std::string_view)>
+        moduleNormalizer;
+
     /** Function called to obtain the source of a module */
     std::function<ModuleData(std::string_view)> moduleLoader =
         [](std::string_view filename) -> ModuleData {
         return ModuleData{detail::toUri(filename), detail::readFile(filename)};
     };
 
+    /** Queues job to run on the JS thread, after the job running now and
+     * the microtasks it schedules. Can be called from any thread and never
+     * blocks. */
     template <typename Function> void enqueueJob(Function &&job);
 
+    /** The JS thread's event loop: runs queued jobs in order, each followed
+     * by the microtasks (promise reactions) it scheduled, and sleeps while
+     * there is nothing to do. Timers, file watches and async bindings all
+     * arrive through enqueueJob, so one wait covers every source. Returns
+     * once stopEventLoop() is called; jobs still queued are dropped. */
+    void runEventLoop();
+    /** Can be called from any thread */
+    void stopEventLoop() {
+        stopping.store(true, std::memory_order_release);
+        wake();
+    }
+
     /** Create module and return a reference to it */
     Module &addModule(const char *name) {
         modules.emplace_back(ctx, name);
@@ -1904,6 +2073,19 @@ public:
         return Value{weakFromContext(ctx), std::move(v)};
     }
 
+    /// Evaluates a script or module serialized with JS_WriteObject. Modules
+    /// have their imports resolved first, as JS_Eval would.
+    /// @see JS_ReadObject
+    Value evalBinary(const uint8_t *buffer, size_t size) {
+        JSValue v = JS_ReadObject(ctx, buffer, size, JS_READ_OBJ_BYTECODE);
+        if (JS_IsException(v))
+            throw exception{ctx};
+        // On failure QuickJS frees the unresolved module itself
+        if (JS_ResolveModule(ctx, v) < 0)
+            throw exception{ctx};
+        return Value{weakFromContext(ctx), JS_EvalFunction(ctx, v)};
+    }
+
     Value evalFile(const char *filename, int flags = 0) {
         auto buf = detail::readFile(filename);
         if (!buf)
@@ -1950,6 +2132,171 @@ struct qjs_context_destroyed_exception : public std::exception {
     }
 };
 
+/** What std::function<R(Args...)> parameters unwrap to: a handle to a JS
+ * function that can be called, copied and destroyed on any thread.
+ *
+ * The JS function itself is only touched on the JS thread: copies share one
+ * reference-counted handle, and when the last copy goes away off the JS
+ * thread the JS value is released by a job queued there.
+ *
+ * operator() runs the function on the JS thread and blocks until it returns,
+ * converting the result there. If the context is torn down before the call
+ * ran, the queued job is dropped and operator() throws
+ * qjs_context_destroyed_exception instead of waiting forever.
+ * post() and call_async() only queue the call, so native producers (file
+ * watchers, timers) never wait for a slow JS consumer. At most
+ * max_pending queued calls are allowed per function (shared between
+ * copies); further calls are refused instead of piling up.
+ */
+template <typename R, typename... Args> class js_function {
+public:
+    static constexpr size_t max_pending = 256;
+
+    js_function(JSContext *ctx, JSValueConst fun_obj)
+        : fun(share(ctx, fun_obj)), weak(Context::get(ctx).weak_from_this()),
+          pending(std::make_shared<std::atomic<size_t>>(0)) {}
+
+    R operator()(Args... args) const {
+        auto context = weak.lock();
+        if (!context)
+            throw qjs_context_destroyed_exception{};
+        if (is_thread_js_main)
+            return invoke(std::move(args)...);
+
+        std::promise<R> promise;
+        auto future = promise.get_future();
+        msgloop_waiter waiter;
+        waiter_signal signal(&waiter);
+        context->enqueueJob([&, signal = std::move(signal)]() mutable {
+            try {
+                if constexpr (std::is_void_v<R>) {
+                    invoke(std::move(args)...);
+                    promise.set_value();
+                } else {
+                    promise.set_value(invoke(std::move(args)...));
+                }
+            } catch (...) {
+                promise.set_exception(std::current_exception());
+            }
+            // Must be the last access to this frame: the waiting thread may
+            // return as soon as it is signaled
+            signal.reset();
+        });
+        // Not kept alive while waiting, so a context torn down before the job
+        // ran drops it, which signals the waiter
+        context.reset();
+        waiter.wait();
+
+        if (future.wait_for(std::chrono::seconds(0)) !=
+            std::future_status::ready)
+            throw qjs_context_destroyed_exception{};
+        return future.get();
+    }
+
+    /** Queues the call and returns without waiting for it.
+     * @return false if the call was dropped because too many are pending
+     */
+    bool post(Args... args) const {
+        return enqueue([self = *this, ... args = std::move(args)]() mutable {
+            try {
+                self.invoke(std::move(args)...);
+            } catch (std::exception &e) {
+                std::cerr << "Error in posted JS callback: " << e.what()
+                          << std::endl;
+            }
+        });
+    }
+
+    /** Queues the call; the result (or exception) is delivered through the
+     * returned future. Throws std::runtime_error if too many are pending.
+     */
+    std::future<R> call_async(Args... args) const {
+        auto promise = std::make_shared<std::promise<R>>();
+        auto future = promise->get_future();
+        bool queued = enqueue([self = *this, promise,
+                               ... args = std::move(args)]() mutable {
+            try {
+                if constexpr (std::is_void_v<R>) {
+                    self.invoke(std::move(args)...);
+                    promise->set_value();
+                } else {
+                    promise->set_value(self.invoke(std::move(args)...));
+                }
+            } catch (...) {
+                promise->set_exception(std::current_exception());
+            }
+        });
+        if (!queued)
+            throw std::runtime_error("Too many pending calls to JS function");
+        return future;
+    }
+
+private:
+    // Called on the JS thread, which owns the function's reference
+    static std::shared_ptr<Value> share(JSContext *ctx, JSValueConst fun_obj) {
+        auto weak = weakFromContext(ctx);
+        return {new Value{weak, JS_DupValue(ctx, fun_obj)},
+                [weak](Value *value) {
+                    auto context = weak.lock();
+                    // Without a context there is nothing left to free
+                    if (!context || is_thread_js_main) {
+                        delete value;
+                        return;
+                    }
+                    context->enqueueJob(
+                        [value = std::unique_ptr<Value>(value)] {});
+                }};
+    }
+
+    // Runs on the JS thread
+    R invoke(Args... args) const {
+        const int argc = sizeof...(Args);
+        JSValue argv[std::max(1, argc)];
+        detail::wrap_args(fun->ctx, argv, std::forward<Args>(args)...);
+        JSValue result = JS_Call(fun->ctx, fun->v, JS_UNDEFINED, argc,
+                                 const_cast<JSValueConst *>(argv));
+        for (int i = 0; i < argc; i++)
+            JS_FreeValue(fun->ctx, argv[i]);
+
+        if (JS_IsException(result))
+            throw exception{fun->ctx};
+        return detail::unwrap_free<R>(fun->ctx, result);
+    }
+
+    template <typename Job> bool enqueue(Job &&job) const {
+        auto context = weak.lock();
+        if (!context)
+            throw qjs_context_destroyed_exception{};
+        if (pending->fetch_add(1, std::memory_order_relaxed) >= max_pending) {
+            pending->fetch_sub(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        context->enqueueJob([pending = pending,
+                             job = std::forward<Job>(job)]() mutable {
+            pending->fetch_sub(1, std::memory_order_relaxed);
+            job();
+        });
+        return true;
+    }
+
+    std::shared_ptr<Value> fun;
+    std::weak_ptr<Context> weak;
+    std::shared_ptr<std::atomic<size_t>> pending;
+};
+
+/** Calls f without blocking on the JS thread when it wraps a JS function
+ * (see js_function::post), and directly otherwise.
+ * @return false if the call was dropped because too many are pending
+ */
+template <typename... Args, typename... CallArgs>
+bool post_call(const std::function<void(Args...)> &f, CallArgs &&...args) {
+    if (auto js = f.template target<js_function<void, Args...>>())
+        return js->post(std::forward<CallArgs>(args)...);
+    f(std::forward<CallArgs>(args)...);
+    return true;
+}
+
 /** Convert to/from std::function. Actually accepts/returns callable object that
  * is compatible with function<R (Args...)>.
  * @tparam R return type
@@ -1958,46 +2305,7 @@ struct qjs_context_destroyed_exception : public std::exception {
 template <typename R, typename... Args>
 struct js_traits<std::function<R(Args...)>, int> {
     static auto unwrap(JSContext *ctx, JSValueConst fun_obj) {
-        auto weak = Context::get(ctx).weak_from_this();
-        return
-            [jsfun_obj = Value{weakFromContext(ctx), JS_DupValue(ctx, fun_obj)},
-             weak](Args... args) -> R {
-                if (weak.expired())
-                    throw qjs_context_destroyed_exception{};
-                auto &ctx = Context::get(jsfun_obj.ctx);
-                std::promise<std::expected<JSValue, exception>> promise;
-                auto future = promise.get_future();
-
-                auto work = [&]() {
-                    const int argc = sizeof...(Args);
-                    JSValue argv[std::max(1, argc)];
-                    detail::wrap_args(jsfun_obj.ctx, argv,
-                                      std::forward<Args>(args)...);
-                    JSValue result =
-                        JS_Call(jsfun_obj.ctx, jsfun_obj.v, JS_UNDEFINED, argc,
-                                const_cast<JSValueConst *>(argv));
-                    for (int i = 0; i < argc; i++)
-                        JS_FreeValue(jsfun_obj.ctx, argv[i]);
-                    promise.set_value(result);
-
-                    if (JS_IsException(result))
-                        promise.set_exception(
-                            std::make_exception_ptr(exception{jsfun_obj.ctx}));
-                };
-
-                if (!is_thread_js_main) {
-                    ctx.enqueueJob(work);
-                } else {
-                    work();
-                }
-
-                wait_with_msgloop([&future]() { future.wait(); });
-                auto result = future.get();
-                if (!result)
-                    throw result.error();
-
-                return detail::unwrap_free<R>(jsfun_obj.ctx, result.value());
-            };
+        return js_function<R, Args...>{ctx, fun_obj};
     }
 
     /** Convert from function object functor to JSValue.
@@ -2365,32 +2673,46 @@ template <typename Key> property_proxy<Key>::operator Value() const {
 } // namespace detail
 
 template <typename Function> void Context::enqueueJob(Function &&job) {
-    std::unique_lock lock(js_mutex);
-    JSValue job_val = js_traits<std::function<void()>>::wrap(
-        ctx, std::forward<Function>(job));
-    JSValueConst arg = job_val;
-    int err = JS_EnqueueJob(
-        ctx,
-        [](JSContext *ctx, int argc, JSValueConst *argv) {
+    auto entry = new InboundJob{std::forward<Function>(job), nullptr};
+    auto head = inbound.load(std::memory_order_relaxed);
+    entry->next = head;
+    while (!inbound.compare_exchange_weak(head, entry,
+                                          std::memory_order_release,
+                                          std::memory_order_relaxed))
+        entry->next = head;
+
+    // The loop only sleeps on an empty queue, so waking it once per batch
+    // is enough
+    if (!head)
+        wake();
+}
+
+inline void Context::runEventLoop() {
+    while (!stopping.load(std::memory_order_acquire)) {
+        auto seen = wakeups.load(std::memory_order_acquire);
+        for (auto job = takeInbound(); job;) {
             try {
-                assert(argc >= 1);
-                js_traits<std::function<void()>>::unwrap(ctx, argv[0])();
-            } catch (exception) {
-                return JS_EXCEPTION;
+                job->run();
             } catch (std::exception const &err) {
-                JS_ThrowInternalError(ctx, "%s", err.what());
-                return JS_EXCEPTION;
+                // Also qjs::exception, which took the JS error with it
+                std::cerr << "Error in JS job: " << err.what() << std::endl;
             } catch (...) {
-                JS_ThrowInternalError(ctx, "Unknown error");
-                return JS_EXCEPTION;
+                std::cerr << "Unknown error in JS job" << std::endl;
             }
-            return JS_UNDEFINED;
-        },
-        1, &arg);
+            delete std::exchange(job, job->next);
+            runMicrotasks();
+            if (stopping.load(std::memory_order_acquire)) {
+                // Not run, but still owned by us
+                while (job)
+                    delete std::exchange(job, job->next);
+                return;
+            }
+        }
+        runMicrotasks();
 
-    JS_FreeValue(ctx, job_val);
-    if (err < 0)
-        throw exception{ctx};
+        if (!inbound.load(std::memory_order_acquire))
+            wakeups.wait(seen, std::memory_order_acquire);
+    }
 }
 
 inline Context &exception::context() const { return Context::get(ctx); }
@@ -2409,6 +2731,28 @@ inline void Runtime::promise_unhandled_rejection_tracker(JSContext *ctx,
     }
 }
 
+inline char *Runtime::module_normalize(JSContext *ctx,
+                                      const char *module_base_name,
+                                      const char *module_name, void *opaque) {
+    auto &context = Context::get(ctx);
+
+    try {
+        auto name =
+            context.moduleNormalizer
+                ? context.moduleNormalizer(module_base_name, module_name)
+                : detail::normalizeModuleName(module_base_name, module_name);
+        return js_strdup(ctx, name.c_str());
+    } catch (exception) {
+        return NULL;
+    } catch (std::exception const &err) {
+        JS_ThrowInternalError(ctx, "%s", err.what());
+        return NULL;
+    } catch (...) {
+        JS_ThrowInternalError(ctx, "Unknown error");
+        return NULL;
+    }
+}
+
 inline JSModuleDef *
 Runtime::module_loader(JSContext *ctx, const char *module_name, void *opaque) {
     Context::ModuleData data;
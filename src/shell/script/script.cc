@@ -1,18 +1,28 @@
 #include "script.h"
 #include "binding_qjs.h"
+#include "bytecode_cache.h"
+#include "js_arena.h"
+#include "js_profiler.h"
+#include "menu_listener_watchdog.h"
+#include "plugin_modules.h"
+#include "qjs_build_id.h"
+#include "timer_scheduler.h"
 #include "cpptrace/exceptions.hpp"
 #include "shell/contextmenu/contextmenu.h"
 
 #include "shell/config.h"
+#include "shell/trace.h"
 #include "shell/utils.h"
 
 #include <algorithm>
+#include <format>
 #include <functional>
 #include <future>
 #include <iostream>
 #include <mutex>
 #include <print>
 #include <ranges>
+#include <set>
 #include <sstream>
 #include <string_view>
 #include <thread>
@@ -28,14 +38,15 @@
 
 thread_local bool is_thread_js_main = false;
 
-static unsigned char script_js_bytes[] = {
-#include "script.js.h"
-};
-
-std::string breeze_script_js = std::string(
-    reinterpret_cast<char *>(script_js_bytes), sizeof(script_js_bytes) - 1);
+// breeze_script_bytecode: script.js compiled by breeze-qjsc at build time
+#include "script.js.bytecode.h"
 
 namespace mb_shell {
+namespace {
+std::filesystem::path bytecode_cache_directory() {
+    return config::data_directory() / "cache";
+}
+} // namespace
 
 void println(qjs::rest<std::string> args) {
     std::stringstream ss;
@@ -68,6 +79,90 @@ void script_context::bind() {
 }
 script_context::script_context() : rt{}, js{} {}
 
+std::shared_ptr<qjs::Context> script_context::context() {
+    std::lock_guard lock(context_mutex);
+    return js;
+}
+
+void script_context::publish_context(std::shared_ptr<qjs::Context> ctx) {
+    {
+        std::lock_guard lock(context_mutex);
+        std::swap(js, ctx);
+    }
+    // The previous context is destroyed outside the lock
+}
+
+// Orders plugins by config plugin_load_order; unlisted ones go last, by name
+static void sort_by_load_order(std::vector<std::filesystem::path> &files) {
+    auto plugin_load_order = config::current()->plugin_load_order;
+    std::ranges::sort(files, [&](auto &a, auto &b) {
+        auto a_name = a.filename().stem().string();
+        auto b_name = b.filename().stem().string();
+
+        auto a_pos = std::ranges::find(plugin_load_order, a_name);
+        auto b_pos = std::ranges::find(plugin_load_order, b_name);
+
+        if (a_pos == plugin_load_order.end() &&
+            b_pos == plugin_load_order.end()) {
+            return a_name < b_name;
+        }
+
+        if (a_pos == plugin_load_order.end()) {
+            return false;
+        }
+
+        if (b_pos == plugin_load_order.end()) {
+            return true;
+        }
+
+        return a_pos < b_pos;
+    });
+}
+
+void script_context::load_plugin(const std::filesystem::path &path) {
+    try {
+        std::ifstream file(path);
+        std::string script((std::istreambuf_iterator<char>(file)),
+                           std::istreambuf_iterator<char>());
+
+        auto func = bytecode_cache::compile_module(
+            js->ctx, script, path.generic_string(), bytecode_cache_directory());
+
+        if (JS_IsException(func)) {
+            std::cerr << "Syntax Error in file: " << path << std::endl;
+            auto val = qjs::Value{js->ctx, JS_GetException(js->ctx)};
+            std::cerr << (std::string)val << (std::string)val["stack"]
+                      << std::endl;
+            JS_FreeValue(js->ctx, func);
+            return;
+        }
+
+        JSModuleDef *m = (JSModuleDef *)JS_VALUE_GET_PTR(func);
+        auto meta_obj = JS_GetImportMeta(js->ctx, m);
+
+        JS_DefinePropertyValueStr(
+            js->ctx, meta_obj, "url",
+            JS_NewString(js->ctx, path.generic_string().c_str()),
+            JS_PROP_C_W_E);
+
+        JS_DefinePropertyValueStr(
+            js->ctx, meta_obj, "name",
+            JS_NewString(js->ctx, path.filename().generic_string().c_str()),
+            JS_PROP_C_W_E);
+
+        JS_FreeValue(js->ctx, meta_obj);
+
+        auto val = qjs::Value{js->ctx, JS_EvalFunction(js->ctx, func)};
+        if (val.isError()) {
+            std::cerr << "Error in file: " << path << (std::string)val
+                      << (std::string)val["stack"] << std::endl;
+        }
+    } catch (std::exception &e) {
+        std::cerr << "Error in file: " << path << " " << e.what()
+                  << std::endl;
+    }
+}
+
 class WindowsThreadWrapper {
 private:
     HANDLE hThread_;
@@ -108,22 +203,25 @@ public:
 
 void script_context::watch_folder(const std::filesystem::path &path,
                                   std::function<bool()> on_reload) {
-    bool has_update = false;
+    std::mutex changed_mutex;
+    std::set<std::filesystem::path> changed_files;
 
     std::optional<WindowsThreadWrapper> js_thread;
     auto reload_all = [&]() {
         dbgout("Reloading all scripts");
 
-        if (js) {
-            js->pending_job_count.exchange(-1);
-            js->pending_job_count.notify_all();
+        if (auto previous = context()) {
+            previous->stopEventLoop();
             if (js_thread)
                 js_thread->join();
-            js->pending_job_count.exchange(0);
+            timer_scheduler::cancel_context(previous.get());
         }
 
         dbgout("Creating JS thread");
-        menu_callbacks_js.clear();
+        {
+            std::lock_guard lock(menu_callbacks_js_mutex);
+            menu_callbacks_js.clear();
+        }
 
         is_js_ready.exchange(false);
         js_thread.emplace(
@@ -131,15 +229,60 @@ void script_context::watch_folder(const std::filesystem::path &path,
                 CPPTRACE_TRY {
                     is_thread_js_main = true;
                     set_thread_locale_utf8();
-                    rt = std::make_shared<qjs::Runtime>();
+                    // The previous context has to be freed before its
+                    // runtime, and the runtime before its arena. Contexts
+                    // own their runtime and the runtime its arena, so this
+                    // holds even if another thread drops the last context
+                    // reference.
+                    publish_context(nullptr);
+                    rt = nullptr;
+                    auto arena = std::make_shared<js_arena>();
+                    rt = std::shared_ptr<qjs::Runtime>(
+                        new qjs::Runtime(&js_arena::functions, arena.get()),
+                        [arena](qjs::Runtime *runtime) { delete runtime; });
+                    JS_SetInterruptHandler(
+                        rt->rt,
+                        [](JSRuntime *rt, void *) {
+                            js_profiler::on_interrupt(rt);
+                            return menu_listener_watchdog::on_interrupt() ? 1
+                                                                          : 0;
+                        },
+                        nullptr);
                     JS_UpdateStackTop(rt->rt);
-                    js = std::make_shared<qjs::Context>(*rt);
+                    publish_context(std::make_shared<qjs::Context>(rt));
+
+                    plugin_modules::reset(path);
+                    js->moduleNormalizer = plugin_modules::normalize;
+                    js->moduleLoader = [](std::string_view module_name) {
+                        auto module_path = plugin_modules::file_of(module_name);
+                        if (!std::filesystem::exists(module_path)) {
+                            return qjs::Context::ModuleData{};
+                        }
+                        std::ifstream file(module_path);
+                        std::string script(
+                            (std::istreambuf_iterator<char>(file)),
+                            std::istreambuf_iterator<char>());
+                        // import.meta.url doesn't change across reloads
+                        return qjs::Context::ModuleData{
+                            std::string(
+                                plugin_modules::unversioned(module_name)),
+                            script};
+                    };
 
                     bind();
                     try {
                         JS_UpdateStackTop(rt->rt);
-                        js->eval(breeze_script_js, "breeze-script.js",
-                                 JS_EVAL_TYPE_MODULE);
+                        // Bytecode is only readable by the QuickJS build
+                        // that wrote it
+                        std::string_view compiled_for =
+                            breeze_script_bytecode_qjs_build_id;
+                        if (compiled_for != qjs_build_id()) {
+                            throw std::runtime_error(std::format(
+                                "compiled for QuickJS {}, running {}",
+                                compiled_for, qjs_build_id()));
+                        }
+                        js->evalBinary(breeze_script_bytecode,
+                                       sizeof(breeze_script_bytecode));
                     } catch (std::exception &e) {
                         std::cerr << "Error in breeze-script.js: " << e.what()
                                   << std::endl;
@@ -153,130 +296,21 @@ void script_context::watch_folder(const std::filesystem::path &path,
                             }),
                         std::back_inserter(files));
 
-                    // resort files by config
-                    auto plugin_load_order = config::current->plugin_load_order;
-                    // if not found, load after all
-                    std::ranges::sort(files, [&](auto &a, auto &b) {
-                        auto a_name = a.filename().stem().string();
-                        auto b_name = b.filename().stem().string();
-
-                        auto a_pos =
-                            std::ranges::find(plugin_load_order, a_name);
-                        auto b_pos =
-                            std::ranges::find(plugin_load_order, b_name);
-
-                        if (a_pos == plugin_load_order.end() &&
-                            b_pos == plugin_load_order.end()) {
-                            return a_name < b_name;
-                        }
-
-                        if (a_pos == plugin_load_order.end()) {
-                            return false;
-                        }
+                    sort_by_load_order(files);
 
-                        if (b_pos == plugin_load_order.end()) {
-                            return true;
-                        }
+                    std::vector<std::string> module_names;
+                    for (auto &path : files)
+                        module_names.push_back(path.generic_string());
+                    bytecode_cache::prune(module_names,
+                                          bytecode_cache_directory());
 
-                        return a_pos < b_pos;
-                    });
-
-                    for (auto &path : files) {
-                        try {
-                            std::ifstream file(path);
-                            std::string script(
-                                (std::istreambuf_iterator<char>(file)),
-                                std::istreambuf_iterator<char>());
-
-                            js->moduleLoader =
-                                [&](std::string_view module_name) {
-                                    auto module_path =
-                                        path.parent_path() /
-                                        (std::string(module_name) + ".js");
-                                    if (!std::filesystem::exists(module_path)) {
-                                        return qjs::Context::ModuleData{};
-                                    }
-                                    std::ifstream file(module_path);
-                                    std::string script(
-                                        (std::istreambuf_iterator<char>(file)),
-                                        std::istreambuf_iterator<char>());
-                                    return qjs::Context::ModuleData{script};
-                                };
-                            auto func =
-                                JS_Eval(js->ctx, script.c_str(), script.size(),
-                                        path.generic_string().c_str(),
-                                        JS_EVAL_TYPE_MODULE |
-                                            JS_EVAL_FLAG_COMPILE_ONLY);
-
-                            if (JS_IsException(func)) {
-                                std::cerr << "Syntax Error in file: " << path
-                                          << std::endl;
-                                auto val = qjs::Value{js->ctx,
-                                                      JS_GetException(js->ctx)};
-                                std::cerr << (std::string)val
-                                          << (std::string)val["stack"]
-                                          << std::endl;
-                                JS_FreeValue(js->ctx, func);
-                                continue;
-                            }
-
-                            JSModuleDef *m =
-                                (JSModuleDef *)JS_VALUE_GET_PTR(func);
-                            auto meta_obj = JS_GetImportMeta(js->ctx, m);
-
-                            JS_DefinePropertyValueStr(
-                                js->ctx, meta_obj, "url",
-                                JS_NewString(js->ctx,
-                                             path.generic_string().c_str()),
-                                JS_PROP_C_W_E);
-
-                            JS_DefinePropertyValueStr(
-                                js->ctx, meta_obj, "name",
-                                JS_NewString(
-                                    js->ctx,
-                                    path.filename().generic_string().c_str()),
-                                JS_PROP_C_W_E);
-
-                            JS_FreeValue(js->ctx, meta_obj);
-
-                            auto val = qjs::Value{
-                                js->ctx, JS_EvalFunction(js->ctx, func)};
-                            if (val.isError()) {
-                                std::cerr << "Error in file: " << path
-                                          << (std::string)val
-                                          << (std::string)val["stack"]
-                                          << std::endl;
-                            }
-                        } catch (std::exception &e) {
-                            std::cerr << "Error in file: " << path << " "
-                                      << e.what() << std::endl;
-                        }
-                    }
+                    for (auto &path : files)
+                        load_plugin(path);
 
                     is_js_ready.exchange(true);
                     is_js_ready.notify_all();
 
-                    while (true) {
-                        while (js->pending_job_count.load() > 0) {
-                            std::unique_lock lock(js->js_mutex);
-                            auto ctx = js->ctx;
-                            if (auto res = JS_ExecutePendingJob(rt->rt, &ctx);
-                                res < 0) {
-                                std::cerr << "Error executing pending JS job: ";
-                                auto val = qjs::Value{js->ctx,
-                                                      JS_GetException(js->ctx)};
-                                std::cerr << (std::string)val
-                                          << (std::string)val["stack"]
-                                          << std::endl;
-                            }
-                            lock.unlock();
-                            js->pending_job_count.fetch_sub(1);
-                            std::this_thread::yield();
-                        }
-                        js->pending_job_count.wait(0);
-                        if (js->pending_job_count.load() == -1)
-                            break;
-                    }
+                    js->runEventLoop();
                     is_thread_js_main = false;
                 }
                 CPPTRACE_CATCH(std::exception & e) {
@@ -289,6 +323,34 @@ void script_context::watch_folder(const std::filesystem::path &path,
             10485760); // 10 MB stack
     };
 
+    // Unloads the changed files and their importers, then evaluates them
+    // again in the live runtime, on the JS thread
+    auto reload_changed = [&](std::vector<std::filesystem::path> changed) {
+        auto ctx = context();
+        if (!ctx)
+            throw std::runtime_error("no JS context");
+        ctx->enqueueJob([this, &path, changed] {
+            trace::span span("script_context::reload_changed");
+            auto start = std::chrono::steady_clock::now();
+
+            auto files = plugin_modules::invalidate(changed);
+            // Removed files stay unloaded; imported modules outside the
+            // scripts folder are only evaluated by their importers
+            std::erase_if(files, [&](const std::filesystem::path &file) {
+                return file.parent_path() != path ||
+                       !std::filesystem::exists(file);
+            });
+            sort_by_load_order(files);
+            for (auto &file : files)
+                load_plugin(file);
+
+            dbgout("Reloaded {} script(s) in {}ms", files.size(),
+                   std::chrono::duration_cast<std::chrono::milliseconds>(
+                       std::chrono::steady_clock::now() - start)
+                       .count());
+        });
+    };
+
     reload_all();
 
     filewatch::FileWatch<std::string> watch(
@@ -299,22 +361,37 @@ void script_context::watch_folder(const std::filesystem::path &path,
             }
 
             dbgout("File change detected: {}", path);
-            has_update = true;
+            std::lock_guard lock(changed_mutex);
+            changed_files.insert(path);
         });
 
     while (true) {
         std::this_thread::sleep_for(std::chrono::milliseconds(300));
-        if (has_update && on_reload()) {
-            has_update = false;
+        std::vector<std::filesystem::path> changed;
+        {
+            std::lock_guard lock(changed_mutex);
+            if (changed_files.empty() || !on_reload())
+                continue;
+            for (auto &file : changed_files)
+                changed.push_back(path / file);
+            changed_files.clear();
+        }
+
+        // A runtime that is still loading, or died doing so, is started over
+        if (!is_js_ready.load()) {
+            reload_all();
+            continue;
+        }
+
+        dbgout("Reloading {} changed script(s)", changed.size());
+        try {
+            reload_changed(std::move(changed));
+        } catch (std::exception &e) {
+            std::cerr << "Failed to reload changed scripts: " << e.what()
+                      << std::endl;
             reload_all();
         }
     }
 }
 
 } // namespace mb_shell
-
-extern "C" void qjs_notify_job_enqueued(JSContext *jsctx) {
-    auto &ctx = qjs::Context::get(jsctx);
-    ctx.pending_job_count.fetch_add(1);
-    ctx.pending_job_count.notify_all();
-}
@@ -6,6 +6,7 @@
 #include <filesystem>
 #include <fstream>
 #include <memory>
+#include <mutex>
 #include <print>
 #include <thread>
 #include <threads.h>
@@ -14,17 +15,25 @@ extern thread_local bool is_thread_js_main;
 namespace mb_shell {
 struct script_context {
     std::shared_ptr<qjs::Runtime> rt;
+    // Only the JS thread assigns js (through publish_context) and may use it
+    // directly; other threads get it from context()
     std::shared_ptr<qjs::Context> js;
 
-
 public:
     std::atomic<bool> is_js_ready{false};
 
     script_context();
     void bind();
+    // Evaluates one plugin file in the current context; errors are logged
+    void load_plugin(const std::filesystem::path &path);
+    std::shared_ptr<qjs::Context> context();
 
     void watch_folder(
         const std::filesystem::path &path,
         std::function<bool()> on_reload = []() { return true; });
+
+private:
+    void publish_context(std::shared_ptr<qjs::Context> ctx);
+    std::mutex context_mutex;
 };
 } // namespace mb_shell
\ No newline at end of file
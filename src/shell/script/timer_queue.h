@@ -0,0 +1,121 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace mb_shell {
+// Deadline bookkeeping of timer_scheduler: timers keyed by id, kept in a
+// min-heap ordered by deadline, then id. Not thread safe; the scheduler
+// holds its lock around every call.
+template <typename T> class timer_queue {
+public:
+    using clock = std::chrono::steady_clock;
+
+    struct timer {
+        T value;
+        clock::time_point deadline;
+        clock::duration interval;
+        bool repeat;
+    };
+
+    // Ids are never reused
+    int reserve_id() { return next_id++; }
+
+    // Returns whether the timer is now the earliest one
+    bool add(int id, T value, clock::time_point now, clock::duration interval,
+             bool repeat) {
+        auto deadline = now + interval;
+        timers.emplace(id, timer{std::move(value), deadline, interval, repeat});
+        compact();
+        push(id, deadline);
+        return heap.front().id == id;
+    }
+
+    std::optional<T> remove(int id) {
+        auto it = timers.find(id);
+        if (it == timers.end())
+            return std::nullopt;
+        auto value = std::move(it->second.value);
+        timers.erase(it);
+        compact();
+        return value;
+    }
+
+    template <typename F> void remove_if(F &&pred) {
+        std::erase_if(timers,
+                      [&](auto &entry) { return pred(entry.second.value); });
+        compact();
+    }
+
+    // Calls fn(timer) for every timer due at `now`, earliest first. Repeating
+    // timers are rescheduled unless fn returns false, the others are
+    // removed. Returns the next deadline, if any timers are left.
+    template <typename F>
+    std::optional<clock::time_point> pop_due(clock::time_point now, F &&fn) {
+        while (!heap.empty()) {
+            auto node = heap.front();
+            if (!is_stale(node) && node.deadline > now)
+                return node.deadline;
+            std::ranges::pop_heap(heap, std::greater{});
+            heap.pop_back();
+            if (is_stale(node))
+                continue;
+
+            auto it = timers.find(node.id);
+            auto &t = it->second;
+            if (!fn(t) || !t.repeat) {
+                timers.erase(it);
+                continue;
+            }
+            // Keep the cadence, but don't fire a burst of catch-up ticks
+            // after falling behind
+            t.deadline += t.interval;
+            if (t.deadline <= now)
+                t.deadline = now + t.interval;
+            push(node.id, t.deadline);
+        }
+        return std::nullopt;
+    }
+
+    size_t size() const { return timers.size(); }
+    // Live and stale heap entries
+    size_t heap_size() const { return heap.size(); }
+
+private:
+    // Heap nodes aren't removed on cancel or reschedule; a node is stale
+    // once its timer is gone or has a different deadline
+    struct heap_node {
+        clock::time_point deadline;
+        int id;
+        bool operator>(const heap_node &other) const {
+            return deadline > other.deadline ||
+                   (deadline == other.deadline && id > other.id);
+        }
+    };
+
+    void push(int id, clock::time_point deadline) {
+        heap.push_back({deadline, id});
+        std::ranges::push_heap(heap, std::greater{});
+    }
+
+    bool is_stale(const heap_node &node) const {
+        auto it = timers.find(node.id);
+        return it == timers.end() || it->second.deadline != node.deadline;
+    }
+
+    void compact() {
+        if (heap.size() < 64 || heap.size() < timers.size() * 2)
+            return;
+        std::erase_if(heap, [this](auto &node) { return is_stale(node); });
+        std::ranges::make_heap(heap, std::greater{});
+    }
+
+    std::unordered_map<int, timer> timers;
+    std::vector<heap_node> heap;
+    int next_id = 1;
+};
+} // namespace mb_shell
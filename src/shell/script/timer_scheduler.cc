@@ -0,0 +1,167 @@
+#include "timer_scheduler.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "plugin_modules.h"
+#include "quickjspp.hpp"
+#include "timer_queue.h"
+#include "shell/utils.h"
+
+#include "windows.h"
+
+namespace mb_shell {
+namespace {
+using clock = std::chrono::steady_clock;
+
+struct timer {
+    std::function<void()> callback;
+    std::weak_ptr<qjs::Context> ctx;
+    uint64_t unload_handle;
+};
+
+struct scheduler {
+    std::mutex mutex;
+    timer_queue<timer> timers;
+    HANDLE wake_event = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+    HANDLE waitable_timer = create_waitable_timer();
+
+    scheduler() { std::thread([this] { run(); }).detach(); }
+
+    static HANDLE create_waitable_timer() {
+        // High resolution timers (Windows 10 1803+) aren't bound to the
+        // ~15.6 ms system tick
+        if (auto timer = CreateWaitableTimerExW(
+                nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION,
+                TIMER_ALL_ACCESS))
+            return timer;
+        return CreateWaitableTimerW(nullptr, FALSE, nullptr);
+    }
+
+    void run() {
+        set_thread_name("breeze::timers");
+        while (true) {
+            std::vector<std::function<void()>> due;
+            std::vector<uint64_t> finished;
+            std::optional<clock::time_point> next;
+            {
+                std::lock_guard lock(mutex);
+                next = timers.pop_due(clock::now(), [&](auto &t) {
+                    if (t.value.ctx.expired()) {
+                        finished.push_back(t.value.unload_handle);
+                        return false;
+                    }
+                    due.push_back(t.value.callback);
+                    if (!t.repeat)
+                        finished.push_back(t.value.unload_handle);
+                    return true;
+                });
+            }
+
+            for (auto handle : finished)
+                plugin_modules::forget(handle);
+
+            for (const auto &callback : due) {
+                try {
+                    // A slow JS thread must not stall the other timers;
+                    // ticks beyond the pending limit are skipped
+                    qjs::post_call(callback);
+                } catch (qjs::qjs_context_destroyed_exception &) {
+                } catch (std::exception &e) {
+                    std::cerr << "Error in timer callback: " << e.what()
+                              << std::endl;
+                } catch (...) {
+                    std::cerr << "Unknown in timer callback: " << std::endl;
+                }
+            }
+
+            if (!next) {
+                WaitForSingleObject(wake_event, INFINITE);
+                continue;
+            }
+
+            auto remaining = std::chrono::duration_cast<
+                std::chrono::duration<int64_t, std::ratio<1, 10000000>>>(
+                *next - clock::now());
+            if (remaining.count() <= 0)
+                continue;
+            // Negative due times are relative, in 100 ns units
+            LARGE_INTEGER due_time;
+            due_time.QuadPart = -remaining.count();
+            SetWaitableTimer(waitable_timer, &due_time, 0, nullptr, nullptr,
+                             FALSE);
+            HANDLE handles[] = {waitable_timer, wake_event};
+            WaitForMultipleObjects(2, handles, FALSE, INFINITE);
+        }
+    }
+};
+
+// Leaked: the thread outlives static destruction
+scheduler &instance() {
+    static auto s = new scheduler();
+    return *s;
+}
+} // namespace
+
+int timer_scheduler::schedule(std::function<void()> callback, int delay,
+                              bool repeat) {
+    auto &s = instance();
+    auto ctx = qjs::Context::current;
+    auto interval = std::chrono::duration_cast<clock::duration>(
+        std::chrono::milliseconds(std::max(delay, repeat ? 1 : 0)));
+
+    int id;
+    {
+        std::lock_guard lock(s.mutex);
+        id = s.timers.reserve_id();
+    }
+    // Registered first, so a timer that fires right away can forget it
+    auto handle = plugin_modules::on_unload(ctx->ctx, [id] { cancel(id); });
+
+    bool earliest;
+    {
+        std::lock_guard lock(s.mutex);
+        earliest = s.timers.add(
+            id, timer{std::move(callback), ctx->weak_from_this(), handle},
+            clock::now(), interval, repeat);
+    }
+
+    if (earliest)
+        SetEvent(s.wake_event);
+    return id;
+}
+
+void timer_scheduler::cancel(int id) {
+    auto &s = instance();
+    std::optional<timer> removed;
+    {
+        std::lock_guard lock(s.mutex);
+        removed = s.timers.remove(id);
+    }
+    if (removed)
+        plugin_modules::forget(removed->unload_handle);
+}
+
+void timer_scheduler::cancel_context(const qjs::Context *ctx) {
+    auto &s = instance();
+    std::vector<uint64_t> handles;
+    {
+        std::lock_guard lock(s.mutex);
+        s.timers.remove_if([&](const timer &t) {
+            auto owner = t.ctx.lock();
+            if (owner && owner.get() != ctx)
+                return false;
+            handles.push_back(t.unload_handle);
+            return true;
+        });
+    }
+    for (auto handle : handles)
+        plugin_modules::forget(handle);
+}
+} // namespace mb_shell
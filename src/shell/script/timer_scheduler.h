@@ -0,0 +1,25 @@
+#pragma once
+#include <functional>
+
+namespace qjs {
+class Context;
+}
+
+namespace mb_shell {
+// Backs setTimeout/setInterval. Timers live in a min-heap ordered by
+// deadline, served by one thread that sleeps on a high resolution waitable
+// timer until the earliest deadline, and not at all while there are none.
+// Callbacks are posted to the JS thread with qjs::post_call.
+//
+// Ids are unique for the lifetime of the process, so clearing a stale id
+// never hits a newer timer.
+struct timer_scheduler {
+    // Must be called on the JS thread of the calling context; the timer is
+    // cancelled when the plugin that created it is unloaded
+    static int schedule(std::function<void()> callback, int delay,
+                        bool repeat);
+    static void cancel(int id);
+    // Drops every timer of a context that is being torn down
+    static void cancel_context(const qjs::Context *ctx);
+};
+} // namespace mb_shell
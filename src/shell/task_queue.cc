@@ -0,0 +1,105 @@
+#include "task_queue.h"
+
+mb_shell::task_queue::task_queue() {
+    for (size_t i = 0; i < capacity; i++) {
+        cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    worker = std::thread(&task_queue::run, this);
+}
+mb_shell::task_queue::~task_queue() {
+    stop.store(true, std::memory_order_release);
+    wakeups.fetch_add(1, std::memory_order_release);
+    wakeups.notify_one();
+    if (worker.joinable()) {
+        worker.join();
+    }
+    // Tasks that raced with shutdown are destroyed with the cells and the
+    // overflow list, which breaks their promises instead of leaving the
+    // futures hanging
+}
+void mb_shell::task_queue::push(task t) {
+    if (overflow_size.load(std::memory_order_acquire) != 0 || !try_push(t)) {
+        std::lock_guard lock(overflow_mutex);
+        overflow.push_back(std::move(t));
+        overflow_size.store(overflow.size(), std::memory_order_release);
+    }
+
+    wakeups.fetch_add(1, std::memory_order_release);
+    wakeups.notify_one();
+}
+bool mb_shell::task_queue::try_push(task &t) {
+    auto pos = enqueue_pos.load(std::memory_order_relaxed);
+    while (true) {
+        auto &c = cells[pos & (capacity - 1)];
+        auto seq = c.sequence.load(std::memory_order_acquire);
+        auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+        if (diff == 0) {
+            if (enqueue_pos.compare_exchange_weak(pos, pos + 1,
+                                                  std::memory_order_relaxed)) {
+                c.value = std::move(t);
+                c.sequence.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = enqueue_pos.load(std::memory_order_relaxed);
+        }
+    }
+}
+bool mb_shell::task_queue::try_pop(task &out) {
+    auto &c = cells[dequeue_pos & (capacity - 1)];
+    if (c.sequence.load(std::memory_order_acquire) != dequeue_pos + 1) {
+        return false;
+    }
+
+    out = std::move(c.value);
+    c.sequence.store(dequeue_pos + capacity, std::memory_order_release);
+    dequeue_pos++;
+    return true;
+}
+bool mb_shell::task_queue::run_overflow() {
+    if (overflow_size.load(std::memory_order_acquire) == 0)
+        return false;
+    // A cell that is claimed but not yet filled may hold a task pushed
+    // before the spilled ones; its push bumps wakeups once it is filled
+    if (enqueue_pos.load(std::memory_order_acquire) != dequeue_pos)
+        return false;
+
+    std::vector<task> spilled;
+    {
+        std::lock_guard lock(overflow_mutex);
+        spilled.swap(overflow);
+        overflow_size.store(0, std::memory_order_release);
+    }
+    for (auto &t : spilled)
+        t();
+    return true;
+}
+void mb_shell::task_queue::run() {
+    task current;
+    while (true) {
+        // Read before draining: a push that lands after the last try_pop
+        // bumps wakeups past this value, so the wait below returns at once
+        auto seen = wakeups.load(std::memory_order_acquire);
+
+        do {
+            while (try_pop(current)) {
+                current();
+                current = {};
+            }
+        } while (run_overflow());
+
+        if (stop.load(std::memory_order_acquire)) {
+            do {
+                while (try_pop(current)) {
+                    current();
+                    current = {};
+                }
+            } while (run_overflow());
+            return;
+        }
+
+        wakeups.wait(seen, std::memory_order_acquire);
+    }
+}
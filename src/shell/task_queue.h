@@ -0,0 +1,173 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace mb_shell {
+// Single-consumer task queue backed by one worker thread.
+// Producers push into a bounded lock-free ring (Vyukov-style sequence
+// numbers per cell) and wake the worker through an atomic wait, so enqueuing
+// takes no lock while the ring has room. Small tasks are stored inline in
+// the ring cell. When the ring is full, tasks spill into a mutex-guarded
+// overflow list instead, so pushing never waits for the worker, also from
+// the worker itself or after it has exited. Tasks of one producer run in the
+// order it pushed them.
+struct task_queue {
+public:
+    task_queue();
+
+    ~task_queue();
+
+    template <typename F, typename... Args>
+    auto add_task(F &&f, Args &&...args)
+        -> std::future<std::invoke_result_t<F, Args...>> {
+        using return_type = std::invoke_result_t<F, Args...>;
+
+        if (stop.load(std::memory_order_acquire)) {
+            throw std::runtime_error("add_task called on stopped task_queue");
+        }
+
+        std::promise<return_type> promise;
+        std::future<return_type> res = promise.get_future();
+
+        auto bound =
+            std::bind_front(std::forward<F>(f), std::forward<Args>(args)...);
+        push(task([promise = std::move(promise),
+                   bound = std::move(bound)]() mutable {
+            try {
+                if constexpr (std::is_void_v<return_type>) {
+                    bound();
+                    promise.set_value();
+                } else {
+                    promise.set_value(bound());
+                }
+            } catch (...) {
+                promise.set_exception(std::current_exception());
+            }
+        }));
+        return res;
+    }
+
+private:
+    // Move-only type-erased callable. Callables up to inline_size bytes live
+    // in the object itself, larger ones are moved to the heap.
+    class task {
+    public:
+        static constexpr size_t inline_size = 96;
+
+        task() = default;
+
+        template <typename F>
+            requires(!std::is_same_v<std::decay_t<F>, task>)
+        task(F &&f) {
+            using T = std::decay_t<F>;
+            if constexpr (sizeof(T) <= inline_size &&
+                          alignof(T) <= alignof(std::max_align_t) &&
+                          std::is_nothrow_move_constructible_v<T>) {
+                new (storage) T(std::forward<F>(f));
+                ops = &inline_ops<T>;
+            } else {
+                new (storage) T *(new T(std::forward<F>(f)));
+                ops = &heap_ops<T>;
+            }
+        }
+
+        task(task &&other) noexcept { take(other); }
+        task &operator=(task &&other) noexcept {
+            if (this != &other) {
+                reset();
+                take(other);
+            }
+            return *this;
+        }
+        task(const task &) = delete;
+        task &operator=(const task &) = delete;
+        ~task() { reset(); }
+
+        void operator()() { ops->invoke(storage); }
+        explicit operator bool() const { return ops != nullptr; }
+
+    private:
+        struct vtable {
+            void (*invoke)(void *self);
+            // Move-constructs dst from src and destroys src
+            void (*relocate)(void *dst, void *src);
+            void (*destroy)(void *self);
+        };
+
+        template <typename T>
+        static constexpr vtable inline_ops = {
+            [](void *self) { (*static_cast<T *>(self))(); },
+            [](void *dst, void *src) {
+                new (dst) T(std::move(*static_cast<T *>(src)));
+                static_cast<T *>(src)->~T();
+            },
+            [](void *self) { static_cast<T *>(self)->~T(); },
+        };
+
+        template <typename T>
+        static constexpr vtable heap_ops = {
+            [](void *self) { (**static_cast<T **>(self))(); },
+            [](void *dst, void *src) {
+                new (dst) T *(*static_cast<T **>(src));
+            },
+            [](void *self) { delete *static_cast<T **>(self); },
+        };
+
+        void take(task &other) {
+            if (other.ops) {
+                other.ops->relocate(storage, other.storage);
+                ops = std::exchange(other.ops, nullptr);
+            }
+        }
+        void reset() {
+            if (ops) {
+                std::exchange(ops, nullptr)->destroy(storage);
+            }
+        }
+
+        alignas(std::max_align_t) std::byte storage[inline_size];
+        const vtable *ops = nullptr;
+    };
+
+    struct cell {
+        std::atomic<size_t> sequence;
+        task value;
+    };
+
+    // Must be a power of two
+    static constexpr size_t capacity = 64;
+
+    void push(task t);
+    bool try_push(task &t);
+    bool try_pop(task &out);
+    // Runs the spilled tasks once everything pushed to the ring before them
+    // has run; false if there were none to run yet
+    bool run_overflow();
+    void run();
+
+    std::array<cell, capacity> cells;
+    alignas(64) std::atomic<size_t> enqueue_pos = 0;
+    // Only touched by the worker
+    alignas(64) size_t dequeue_pos = 0;
+    // Bumped after every push and on shutdown; the worker waits on it
+    alignas(64) std::atomic<uint32_t> wakeups = 0;
+    std::atomic<bool> stop = false;
+    // Non-zero while tasks are spilled; producers then spill as well, which
+    // keeps their tasks behind the spilled ones
+    std::atomic<size_t> overflow_size = 0;
+    std::mutex overflow_mutex;
+    std::vector<task> overflow;
+    std::thread worker;
+};
+} // namespace mb_shell
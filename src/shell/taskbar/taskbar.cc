@@ -23,7 +23,7 @@ std::expected<void, std::string> taskbar_render::init() {
 
     int height = (monitor.rcMonitor.bottom - monitor.rcMonitor.top) / 20;
     rt.show();
-    config::current->apply_fonts_to_nvg(rt.nvg);
+    config::current()->apply_fonts_to_nvg(rt.nvg);
 
     bool top = position == menu_position::top;
 
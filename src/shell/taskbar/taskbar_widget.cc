@@ -210,10 +210,11 @@ struct app_list_stack_widget : public ui::widget {
                       active_indicator_opacity = anim_float();
     ui::animated_color bg_color = {this, 0.1f, 0.1f, 0.1f, 0.8f};
     app_list_stack_widget(const window_stack_info &stack) : stack(stack) {
-        config::current->taskbar.theme.animation.bg_color.apply_to(bg_color);
-        config::current->taskbar.theme.animation.active_indicator.apply_to(
+        auto conf = config::current();
+        conf->taskbar.theme.animation.bg_color.apply_to(bg_color);
+        conf->taskbar.theme.animation.active_indicator.apply_to(
             active_indicator_width);
-        config::current->taskbar.theme.animation.active_indicator.apply_to(
+        conf->taskbar.theme.animation.active_indicator.apply_to(
             active_indicator_opacity);
     }
 
@@ -0,0 +1,200 @@
+#include "trace.h"
+#include <array>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "logger.h"
+
+#ifdef _WIN32
+#include "windows.h"
+#else
+#include <unistd.h>
+#endif
+
+namespace mb_shell {
+namespace {
+struct trace_event {
+    const char *name;
+    int64_t start;
+    // Span end, unused for counters
+    int64_t end;
+    double value;
+    bool is_counter;
+};
+
+constexpr size_t buffer_capacity = 4096;
+
+uint32_t current_thread_id() {
+#ifdef _WIN32
+    return GetCurrentThreadId();
+#else
+    return static_cast<uint32_t>(gettid());
+#endif
+}
+
+uint32_t current_process_id() {
+#ifdef _WIN32
+    return GetCurrentProcessId();
+#else
+    return static_cast<uint32_t>(getpid());
+#endif
+}
+
+struct thread_buffer {
+    std::array<trace_event, buffer_capacity> events;
+    // Number of events ever written; only the owning thread writes
+    std::atomic<uint64_t> head = 0;
+    uint32_t thread_id = 0;
+    // Guarded by registry_mutex
+    std::string name;
+};
+
+std::mutex registry_mutex;
+std::vector<std::shared_ptr<thread_buffer>> registry;
+
+// Allocated on the first recorded event, so threads that never trace don't
+// pay for a buffer
+thread_local std::shared_ptr<thread_buffer> local_buffer;
+thread_local std::string local_thread_name;
+
+void push(const trace_event &event) {
+    if (!local_buffer) {
+        auto buffer = std::make_shared<thread_buffer>();
+        buffer->thread_id = current_thread_id();
+        buffer->name = local_thread_name;
+        std::lock_guard lock(registry_mutex);
+        registry.push_back(buffer);
+        local_buffer = buffer;
+    }
+
+    auto head = local_buffer->head.load(std::memory_order_relaxed);
+    local_buffer->events[head % buffer_capacity] = event;
+    local_buffer->head.store(head + 1, std::memory_order_release);
+}
+
+std::string escape_json(std::string_view str) {
+    std::string res;
+    res.reserve(str.size());
+    for (char c : str) {
+        switch (c) {
+        case '"':
+            res += "\\\"";
+            break;
+        case '\\':
+            res += "\\\\";
+            break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20)
+                res += std::format("\\u{:04x}",
+                                   static_cast<unsigned char>(c));
+            else
+                res += c;
+        }
+    }
+    return res;
+}
+} // namespace
+
+void trace::record_span(const char *name, int64_t start, int64_t end) {
+    push({name, start, end, 0, false});
+}
+
+void trace::record_counter(const char *name, int64_t time, double value) {
+    push({name, time, 0, value, true});
+}
+
+void trace::set_enabled(bool enable) {
+    if (enabled.exchange(enable) != enable)
+        dbgout("Tracing {}", enable ? "enabled" : "disabled");
+}
+
+void trace::set_thread_name(const std::string &name) {
+    local_thread_name = name;
+    if (local_buffer) {
+        std::lock_guard lock(registry_mutex);
+        local_buffer->name = name;
+    }
+}
+
+std::filesystem::path
+trace::export_json(const std::filesystem::path &directory) {
+    std::filesystem::create_directories(directory);
+    auto path = directory /
+                std::format("trace-{:%Y%m%d-%H%M%S}.json",
+                            std::chrono::floor<std::chrono::seconds>(
+                                std::chrono::system_clock::now()));
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out)
+        throw std::runtime_error("Failed to open " + path.string());
+    write_json(out);
+
+    dbgout("Trace exported to {}", path.string());
+    return path;
+}
+
+void trace::write_json(std::ostream &out) {
+    auto pid = current_process_id();
+    out << "{\"traceEvents\":[\n";
+    bool first = true;
+    auto separator = [&] {
+        if (!first)
+            out << ",\n";
+        first = false;
+    };
+
+    std::lock_guard lock(registry_mutex);
+    std::vector<trace_event> events;
+    for (auto &buffer : registry) {
+        separator();
+        out << std::format("{{\"name\":\"thread_name\",\"ph\":\"M\","
+                           "\"pid\":{},\"tid\":{},"
+                           "\"args\":{{\"name\":\"{}\"}}}}",
+                           pid, buffer->thread_id,
+                           escape_json(buffer->name.empty()
+                                           ? std::format("thread {}",
+                                                         buffer->thread_id)
+                                           : buffer->name));
+
+        // The owner keeps writing while we copy; anything it may have
+        // overwritten meanwhile is discarded below
+        auto head = buffer->head.load(std::memory_order_acquire);
+        auto begin = head > buffer_capacity ? head - buffer_capacity : 0;
+        events.clear();
+        for (auto i = begin; i < head; i++)
+            events.push_back(buffer->events[i % buffer_capacity]);
+        auto head_after = buffer->head.load(std::memory_order_acquire);
+        auto valid_from = head_after > buffer_capacity
+                              ? head_after - buffer_capacity
+                              : 0;
+
+        for (auto i = std::max(begin, valid_from); i < head; i++) {
+            auto &event = events[i - begin];
+            separator();
+            if (event.is_counter) {
+                out << std::format(
+                    "{{\"name\":\"{}\",\"ph\":\"C\",\"ts\":{:.3f},"
+                    "\"pid\":{},\"tid\":{},\"args\":{{\"value\":{}}}}}",
+                    escape_json(event.name), event.start / 1000.0, pid,
+                    buffer->thread_id, event.value);
+            } else {
+                out << std::format(
+                    "{{\"name\":\"{}\",\"ph\":\"X\",\"ts\":{:.3f},"
+                    "\"dur\":{:.3f},\"pid\":{},\"tid\":{}}}",
+                    escape_json(event.name), event.start / 1000.0,
+                    (event.end - event.start) / 1000.0, pid,
+                    buffer->thread_id);
+            }
+        }
+    }
+    out << "\n]}\n";
+
+    // Buffers of threads that have exited were exported for the last time
+    std::erase_if(registry,
+                  [](const auto &buffer) { return buffer.use_count() == 1; });
+}
+} // namespace mb_shell
@@ -0,0 +1,67 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <ostream>
+#include <string>
+
+namespace mb_shell {
+// Lightweight tracing. Spans and counters are recorded into a per-thread
+// ring buffer (single writer, no locks) and exported on demand as Chrome
+// trace-event JSON, which chrome://tracing and ui.perfetto.dev open
+// directly. While disabled, a span costs one relaxed load and a branch.
+//
+// Names must be string literals (or otherwise outlive the process): only
+// the pointer is stored.
+struct trace {
+    static inline std::atomic<bool> enabled = false;
+
+    // Records [construction, destruction) as a complete event. Spans on the
+    // same thread nest by time, so no explicit parent is needed.
+    class span {
+    public:
+        explicit span(const char *name) {
+            if (enabled.load(std::memory_order_relaxed)) {
+                this->name = name;
+                start = now();
+            }
+        }
+        ~span() {
+            if (name)
+                record_span(name, start, now());
+        }
+        span(const span &) = delete;
+        span &operator=(const span &) = delete;
+
+    private:
+        const char *name = nullptr;
+        int64_t start = 0;
+    };
+
+    static void counter(const char *name, double value) {
+        if (enabled.load(std::memory_order_relaxed))
+            record_counter(name, now(), value);
+    }
+
+    static void set_enabled(bool enable);
+    // Called by set_thread_name, so exported threads carry readable names
+    static void set_thread_name(const std::string &name);
+    // Writes <directory>/trace-<time>.json and returns its path
+    static std::filesystem::path
+    export_json(const std::filesystem::path &directory);
+    // The events recorded so far, as Chrome trace-event JSON with one event
+    // per line
+    static void write_json(std::ostream &out);
+
+    static int64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+private:
+    static void record_span(const char *name, int64_t start, int64_t end);
+    static void record_counter(const char *name, int64_t time, double value);
+};
+} // namespace mb_shell
@@ -0,0 +1,70 @@
+#include "translation_table.h"
+
+#include <algorithm>
+#include <bit>
+#include <utility>
+
+namespace mb_shell {
+
+std::shared_ptr<const translation_table> translation_table::build(
+    std::string lang, bool rtl,
+    const std::unordered_map<std::string_view, std::string_view>& resolved) {
+    auto table = std::make_shared<translation_table>();
+    table->lang = std::move(lang);
+    table->rtl = rtl;
+
+    std::unordered_map<std::string_view, uint32_t> interned;
+    size_t pool_size = 0;
+    for (const auto& [key, value] : resolved)
+        pool_size += key.size() + value.size();
+    // Reserve up front so views into the pool stay valid while interning
+    table->pool.reserve(pool_size);
+
+    auto intern = [&](std::string_view s) {
+        if (auto it = interned.find(s); it != interned.end())
+            return it->second;
+        auto offset = static_cast<uint32_t>(table->pool.size());
+        table->pool.append(s);
+        interned.emplace(table->str(offset, s.size()), offset);
+        return offset;
+    };
+
+    // Values are interned, so compile each distinct one only once
+    std::unordered_map<uint32_t, std::pair<uint32_t, uint32_t>> compiled;
+    auto compile = [&](uint32_t offset, std::string_view s) {
+        auto [it, inserted] = compiled.try_emplace(offset);
+        if (inserted) {
+            auto begin = static_cast<uint32_t>(table->segments.size());
+            i18n_template::compile(s, table->segments);
+            it->second = {begin, static_cast<uint32_t>(
+                                     table->segments.size() - begin)};
+        }
+        return it->second;
+    };
+
+    table->entries.reserve(resolved.size());
+    table->slots.resize(
+        std::bit_ceil(std::max<size_t>(resolved.size() * 2, 16)));
+    auto mask = table->slots.size() - 1;
+
+    for (const auto& [key, value] : resolved) {
+        auto value_offset = intern(value);
+        auto [segment_offset, segment_count] = compile(value_offset, value);
+        table->entries.push_back({intern(key),
+                                  static_cast<uint32_t>(key.size()),
+                                  value_offset,
+                                  static_cast<uint32_t>(value.size()),
+                                  segment_offset, segment_count});
+
+        auto hash = fnv1a_hash(key);
+        auto i = hash & mask;
+        while (table->slots[i].entry)
+            i = (i + 1) & mask;
+        table->slots[i] = {static_cast<uint32_t>(hash),
+                           static_cast<uint32_t>(table->entries.size())};
+    }
+
+    return table;
+}
+
+} // namespace mb_shell
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "fnv1a_hash.h"
+#include "i18n_template.h"
+
+namespace mb_shell {
+
+/**
+ * @brief Immutable, open-addressed key -> value table for one language.
+ *
+ * Built by i18n_manager with the fallback chain already resolved, then only
+ * read. Keys and values are interned into one pool, and every value's
+ * template is compiled once at build time.
+ */
+struct translation_table {
+    struct entry {
+        uint32_t key_offset, key_size;
+        uint32_t value_offset, value_size;
+        // Precompiled value template; empty if it has no placeholders
+        uint32_t segment_offset, segment_count;
+    };
+
+    // 0 marks an empty slot, otherwise index into entries + 1
+    struct slot {
+        uint32_t hash;
+        uint32_t entry;
+    };
+
+    std::string lang;
+    bool rtl = false;
+
+    // All keys and values, interned: identical strings share storage
+    std::string pool;
+    std::vector<entry> entries;
+    std::vector<i18n_template::segment> segments;
+    // Power-of-two sized, linear probing, load factor <= 0.5
+    std::vector<slot> slots;
+
+    std::string_view str(uint32_t offset, uint32_t size) const {
+        return {pool.data() + offset, size};
+    }
+
+    std::span<const i18n_template::segment> segments_of(const entry& e) const {
+        return {segments.data() + e.segment_offset, e.segment_count};
+    }
+
+    const entry* find(std::string_view key) const {
+        if (slots.empty())
+            return nullptr;
+
+        auto hash = fnv1a_hash(key);
+        auto mask = slots.size() - 1;
+        for (auto i = hash & mask;; i = (i + 1) & mask) {
+            auto& s = slots[i];
+            if (!s.entry)
+                return nullptr;
+            if (s.hash != static_cast<uint32_t>(hash))
+                continue;
+            auto& e = entries[s.entry - 1];
+            if (str(e.key_offset, e.key_size) == key)
+                return &e;
+        }
+    }
+
+    /**
+     * @brief Build a table from resolved translations.
+     * @param lang Language code the table is for
+     * @param rtl Whether the language is right-to-left
+     * @param resolved Key -> value; the views only need to outlive the call
+     */
+    static std::shared_ptr<const translation_table>
+    build(std::string lang, bool rtl,
+          const std::unordered_map<std::string_view, std::string_view>&
+              resolved);
+};
+
+} // namespace mb_shell
@@ -0,0 +1,191 @@
+#include "utf_convert.h"
+#include <cstdint>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define MB_SHELL_UTF_SSE2
+#elif defined(_M_ARM64) || defined(__aarch64__)
+#include <arm_neon.h>
+#define MB_SHELL_UTF_NEON
+#endif
+
+namespace mb_shell {
+namespace {
+constexpr char16_t replacement = 0xFFFD;
+
+// Widens whole 16-byte blocks of ASCII and returns how many bytes were
+// consumed; the caller finishes any remaining tail
+size_t ascii_to_utf16(const char *in, size_t size, char16_t *out) {
+    size_t i = 0;
+#if defined(MB_SHELL_UTF_SSE2)
+    const auto zero = _mm_setzero_si128();
+    for (; i + 16 <= size; i += 16) {
+        auto bytes =
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+        if (_mm_movemask_epi8(bytes))
+            break;
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i),
+                         _mm_unpacklo_epi8(bytes, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i + 8),
+                         _mm_unpackhi_epi8(bytes, zero));
+    }
+#elif defined(MB_SHELL_UTF_NEON)
+    for (; i + 16 <= size; i += 16) {
+        auto bytes = vld1q_u8(reinterpret_cast<const uint8_t *>(in + i));
+        if (vmaxvq_u8(bytes) >= 0x80)
+            break;
+        vst1q_u16(reinterpret_cast<uint16_t *>(out + i),
+                  vmovl_u8(vget_low_u8(bytes)));
+        vst1q_u16(reinterpret_cast<uint16_t *>(out + i + 8),
+                  vmovl_u8(vget_high_u8(bytes)));
+    }
+#endif
+    return i;
+}
+
+// Narrows whole blocks of 16 ASCII code units, like ascii_to_utf16
+size_t ascii_to_utf8(const char16_t *in, size_t size, char *out) {
+    size_t i = 0;
+#if defined(MB_SHELL_UTF_SSE2)
+    const auto zero = _mm_setzero_si128();
+    const auto non_ascii = _mm_set1_epi16(static_cast<short>(0xFF80));
+    for (; i + 16 <= size; i += 16) {
+        auto lo = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+        auto hi =
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i + 8));
+        auto high_bits = _mm_and_si128(_mm_or_si128(lo, hi), non_ascii);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(high_bits, zero)) != 0xFFFF)
+            break;
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i),
+                         _mm_packus_epi16(lo, hi));
+    }
+#elif defined(MB_SHELL_UTF_NEON)
+    for (; i + 16 <= size; i += 16) {
+        auto lo = vld1q_u16(reinterpret_cast<const uint16_t *>(in + i));
+        auto hi = vld1q_u16(reinterpret_cast<const uint16_t *>(in + i + 8));
+        if (vmaxvq_u16(vorrq_u16(lo, hi)) >= 0x80)
+            break;
+        vst1q_u8(reinterpret_cast<uint8_t *>(out + i),
+                 vcombine_u8(vmovn_u16(lo), vmovn_u16(hi)));
+    }
+#endif
+    return i;
+}
+} // namespace
+
+size_t utf8_to_utf16(std::string_view in, std::span<char16_t> out) {
+    auto src = reinterpret_cast<const uint8_t *>(in.data());
+    auto size = in.size();
+    auto dst = out.data();
+    size_t i = 0, o = 0;
+
+    while (i < size) {
+        if (src[i] < 0x80) {
+            auto n = ascii_to_utf16(in.data() + i, size - i, dst + o);
+            i += n;
+            o += n;
+            while (i < size && src[i] < 0x80)
+                dst[o++] = src[i++];
+            continue;
+        }
+
+        // Well-formed sequences per Unicode table 3-7: the allowed range of
+        // the second byte depends on the lead byte, which rules out overlong
+        // forms, surrogates and code points above U+10FFFF
+        auto lead = src[i];
+        size_t length;
+        uint32_t code_point;
+        uint8_t lower = 0x80, upper = 0xBF;
+        if (lead >= 0xC2 && lead <= 0xDF) {
+            length = 2;
+            code_point = lead & 0x1F;
+        } else if (lead >= 0xE0 && lead <= 0xEF) {
+            length = 3;
+            code_point = lead & 0x0F;
+            if (lead == 0xE0)
+                lower = 0xA0;
+            else if (lead == 0xED)
+                upper = 0x9F;
+        } else if (lead >= 0xF0 && lead <= 0xF4) {
+            length = 4;
+            code_point = lead & 0x07;
+            if (lead == 0xF0)
+                lower = 0x90;
+            else if (lead == 0xF4)
+                upper = 0x8F;
+        } else {
+            dst[o++] = replacement;
+            i++;
+            continue;
+        }
+
+        size_t k = 1;
+        for (; k < length && i + k < size; k++) {
+            auto c = src[i + k];
+            if (c < lower || c > upper)
+                break;
+            lower = 0x80;
+            upper = 0xBF;
+            code_point = (code_point << 6) | (c & 0x3F);
+        }
+
+        // A truncated sequence is consumed as one replacement character, and
+        // the byte that broke it starts the next one
+        i += k;
+        if (k < length) {
+            dst[o++] = replacement;
+        } else if (code_point >= 0x10000) {
+            code_point -= 0x10000;
+            dst[o++] = static_cast<char16_t>(0xD800 + (code_point >> 10));
+            dst[o++] = static_cast<char16_t>(0xDC00 + (code_point & 0x3FF));
+        } else {
+            dst[o++] = static_cast<char16_t>(code_point);
+        }
+    }
+    return o;
+}
+
+size_t utf16_to_utf8(std::u16string_view in, std::span<char> out) {
+    auto src = in.data();
+    auto size = in.size();
+    auto dst = out.data();
+    size_t i = 0, o = 0;
+
+    while (i < size) {
+        uint32_t c = src[i];
+        if (c < 0x80) {
+            auto n = ascii_to_utf8(src + i, size - i, dst + o);
+            i += n;
+            o += n;
+            while (i < size && src[i] < 0x80)
+                dst[o++] = static_cast<char>(src[i++]);
+            continue;
+        }
+
+        i++;
+        if (c < 0x800) {
+            dst[o++] = static_cast<char>(0xC0 | (c >> 6));
+            dst[o++] = static_cast<char>(0x80 | (c & 0x3F));
+            continue;
+        }
+
+        if (c >= 0xD800 && c <= 0xDFFF) {
+            if (c <= 0xDBFF && i < size && src[i] >= 0xDC00 &&
+                src[i] <= 0xDFFF) {
+                c = 0x10000 + ((c - 0xD800) << 10) + (src[i++] - 0xDC00);
+                dst[o++] = static_cast<char>(0xF0 | (c >> 18));
+                dst[o++] = static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+                dst[o++] = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+                dst[o++] = static_cast<char>(0x80 | (c & 0x3F));
+                continue;
+            }
+            c = replacement;
+        }
+
+        dst[o++] = static_cast<char>(0xE0 | (c >> 12));
+        dst[o++] = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+        dst[o++] = static_cast<char>(0x80 | (c & 0x3F));
+    }
+    return o;
+}
+} // namespace mb_shell
@@ -0,0 +1,25 @@
+#pragma once
+#include <cstddef>
+#include <span>
+#include <string_view>
+
+namespace mb_shell {
+// UTF-8 <-> UTF-16 conversion into caller-provided buffers.
+//
+// Runs of ASCII are converted 16 units at a time with SSE2 (x64) or NEON
+// (ARM64); everything else goes through a validating scalar path. Invalid
+// input never throws: ill-formed UTF-8 sequences and unpaired surrogates
+// are replaced with U+FFFD, one per maximal ill-formed subpart, the same
+// way MultiByteToWideChar and browsers do.
+
+// Output sizes that are always enough for an input of the given length
+constexpr size_t max_utf16_length(size_t utf8_length) { return utf8_length; }
+constexpr size_t max_utf8_length(size_t utf16_length) {
+    return utf16_length * 3;
+}
+
+// Both return the number of units written. `out` must hold at least
+// max_*_length(in.size()) units.
+size_t utf8_to_utf16(std::string_view in, std::span<char16_t> out);
+size_t utf16_to_utf8(std::u16string_view in, std::span<char> out);
+} // namespace mb_shell
@@ -1,6 +1,4 @@
-#define _SILENCE_ALL_CXX17_DEPRECATION_WARNINGS
 #include "utils.h"
-#include <codecvt>
 #include <iostream>
 #include <print>
 #include <sstream>
@@ -12,20 +10,31 @@
 #include <dwmapi.h>
 
 #include "logger.h"
-
-std::wstring mb_shell::utf8_to_wstring(std::string const &str) {
-    std::wstring_convert<
-        std::conditional_t<sizeof(wchar_t) == 4, std::codecvt_utf8<wchar_t>,
-                           std::codecvt_utf8_utf16<wchar_t>>>
-        converter;
-    return converter.from_bytes(str);
-}
-std::string mb_shell::wstring_to_utf8(std::wstring const &str) {
-    std::wstring_convert<
-        std::conditional_t<sizeof(wchar_t) == 4, std::codecvt_utf8<wchar_t>,
-                           std::codecvt_utf8_utf16<wchar_t>>>
-        converter;
-    return converter.to_bytes(str);
+#include "paint_color.h"
+#include "trace.h"
+#include "utf_convert.h"
+
+static_assert(sizeof(wchar_t) == sizeof(char16_t),
+              "wchar_t is expected to hold UTF-16, as on Windows");
+
+std::wstring mb_shell::utf8_to_wstring(std::string_view str) {
+    std::wstring res;
+    res.resize_and_overwrite(
+        max_utf16_length(str.size()), [&](wchar_t *buffer, size_t size) {
+            return utf8_to_utf16(
+                str, {reinterpret_cast<char16_t *>(buffer), size});
+        });
+    return res;
+}
+std::string mb_shell::wstring_to_utf8(std::wstring_view str) {
+    std::string res;
+    res.resize_and_overwrite(
+        max_utf8_length(str.size()), [&](char *buffer, size_t size) {
+            return utf16_to_utf8(
+                {reinterpret_cast<const char16_t *>(str.data()), str.size()},
+                {buffer, size});
+        });
+    return res;
 }
 
 bool mb_shell::is_win11_or_later() {
@@ -86,68 +95,8 @@ bool mb_shell::is_memory_readable(const void *ptr) {
                  PAGE_EXECUTE_WRITECOPY;
     return (mbi.Protect & mask) != 0;
 }
-NVGcolor mb_shell::parse_color(const std::string &str) {
-    // allowed:
-    // #RRGGBB
-    // #RRGGBBAA
-    // #RGB
-    // #RGBA
-    // RRGGBB
-    // RRGGBBAA
-    // RGB
-    // RGBA
-    // r, g,b
-    // r,g, b,a
-
-    std::string s = str;
-    if (s.empty())
-        return nvgRGBA(0, 0, 0, 255);
-
-    // Remove leading '#' if present
-    if (s[0] == '#')
-        s = s.substr(1);
-
-    // Handle comma-separated values
-    if (s.find(',') != std::string::npos) {
-        std::vector<int> components;
-        std::stringstream ss(s);
-        std::string item;
-        while (std::getline(ss, item, ',')) {
-            components.push_back(std::stoi(item));
-        }
-
-        if (components.size() == 3) {
-            return nvgRGB(components[0], components[1], components[2]);
-        }
-        if (components.size() == 4) {
-            return nvgRGBA(components[0], components[1], components[2],
-                           components[3]);
-        }
-    }
-
-    // Handle hex values
-    switch (s.length()) {
-    case 3: // RGB
-        return nvgRGB(17 * std::stoi(s.substr(0, 1), nullptr, 16),
-                      17 * std::stoi(s.substr(1, 1), nullptr, 16),
-                      17 * std::stoi(s.substr(2, 1), nullptr, 16));
-    case 4: // RGBA
-        return nvgRGBA(17 * std::stoi(s.substr(0, 1), nullptr, 16),
-                       17 * std::stoi(s.substr(1, 1), nullptr, 16),
-                       17 * std::stoi(s.substr(2, 1), nullptr, 16),
-                       17 * std::stoi(s.substr(3, 1), nullptr, 16));
-    case 6: // RRGGBB
-        return nvgRGB(std::stoi(s.substr(0, 2), nullptr, 16),
-                      std::stoi(s.substr(2, 2), nullptr, 16),
-                      std::stoi(s.substr(4, 2), nullptr, 16));
-    case 8: // RRGGBBAA
-        return nvgRGBA(std::stoi(s.substr(0, 2), nullptr, 16),
-                       std::stoi(s.substr(2, 2), nullptr, 16),
-                       std::stoi(s.substr(4, 2), nullptr, 16),
-                       std::stoi(s.substr(6, 2), nullptr, 16));
-    }
-
-    return nvgRGBA(0, 0, 0, 255); // Default black
+NVGcolor mb_shell::parse_color(std::string_view str) {
+    return rgba_color::from_string(str);
 }
 void mb_shell::set_thread_locale_utf8() {
     std::setlocale(LC_CTYPE, ".UTF-8");
@@ -158,37 +107,6 @@ void mb_shell::set_thread_locale_utf8() {
     SetThreadLocale(
         MAKELCID(MAKELANGID(LANG_ENGLISH, SUBLANG_ENGLISH_US), SORT_DEFAULT));
 }
-mb_shell::task_queue::task_queue() : stop(false) {
-    worker = std::thread(&task_queue::run, this);
-}
-mb_shell::task_queue::~task_queue() {
-    {
-        std::lock_guard<std::mutex> lock(queue_mutex);
-        stop = true;
-    }
-    condition.notify_all();
-    if (worker.joinable()) {
-        worker.join();
-    }
-}
-void mb_shell::task_queue::run() {
-    while (true) {
-        std::function<void()> task;
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex);
-            condition.wait(lock, [this]() { return stop || !tasks.empty(); });
-
-            if (stop && tasks.empty()) {
-                return;
-            }
-
-            task = std::move(tasks.front());
-            tasks.pop();
-        }
-
-        task();
-    }
-}
 mb_shell::perf_counter::perf_counter(std::string name) : name(name) {
     start = std::chrono::high_resolution_clock::now();
     last_end = start;
@@ -224,11 +142,27 @@ std::vector<std::string> mb_shell::split_string(const std::string &str,
     return result;
 }
 std::string mb_shell::format_color(NVGcolor color) {
-    return std::format(
-        "#{0:02x}{1:02x}{2:02x}{3:02x}", static_cast<int>(color.r * 255),
-        static_cast<int>(color.g * 255), static_cast<int>(color.b * 255),
-        static_cast<int>(color.a * 255));
+    return rgba_color(color).to_string();
 }
 void mb_shell::set_thread_name(const std::string &name) {
     SetThreadDescription(GetCurrentThread(), utf8_to_wstring(name).c_str());
-}
+    trace::set_thread_name(name);
+}
+
+namespace mb_shell {
+namespace {
+// enum_from_string is fully constexpr; keep its lookup rules checked at
+// compile time
+enum class enum_lookup_check { start, space_between, end = 4 };
+static_assert(enum_from_string<enum_lookup_check>("space-between") ==
+              enum_lookup_check::space_between);
+static_assert(enum_from_string<enum_lookup_check>("space_between") ==
+              enum_lookup_check::space_between);
+static_assert(enum_from_string<enum_lookup_check>("end") ==
+              enum_lookup_check::end);
+static_assert(!enum_from_string<enum_lookup_check>("space"));
+static_assert(!enum_from_string<enum_lookup_check>("starts"));
+static_assert(!enum_from_string<enum_lookup_check>(""));
+static_assert(enum_map<enum_lookup_check>.size() == 3);
+} // namespace
+} // namespace mb_shell
@@ -0,0 +1,40 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace mb_shell {
+// An immutable value published for lock-free readers, RCU style: a writer
+// builds the next value off to the side and swaps it in with one atomic
+// exchange, and readers keep the snapshot they loaded alive for as long as
+// they use it.
+//
+// Not lock-free on MSVC, whose std::atomic<std::shared_ptr> takes an
+// internal spinlock for each load and store. It is only held while the
+// pointer is copied, but that is why callers keep one snapshot per frame
+// instead of loading it per field.
+template <typename T> struct versioned_snapshot {
+    std::shared_ptr<const T> load() const {
+        return value.load(std::memory_order_acquire);
+    }
+
+    // Incremented after each publish(), so a snapshot loaded after reading
+    // the generation is at least that new, and values cached under an older
+    // generation are stale
+    uint64_t generation() const {
+        return counter.load(std::memory_order_acquire);
+    }
+
+    // Returns the snapshot it replaced
+    std::shared_ptr<const T> publish(std::shared_ptr<const T> next) {
+        auto previous =
+            value.exchange(std::move(next), std::memory_order_acq_rel);
+        counter.fetch_add(1, std::memory_order_release);
+        return previous;
+    }
+
+private:
+    std::atomic<std::shared_ptr<const T>> value;
+    std::atomic<uint64_t> counter = 0;
+};
+} // namespace mb_shell
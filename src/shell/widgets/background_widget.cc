@@ -3,25 +3,19 @@
 #include "nanovg.h"
 #include "shell/config.h"
 #include "shell/contextmenu/menu_render.h"
+#include "shell/resolved_theme.h"
 #include "shell/utils.h"
 
 namespace mb_shell {
 
 background_widget::background_widget(bool is_main) {
-    auto light_color = is_light_mode();
-    if (is_acrylic_available() && config::current->context_menu.theme.acrylic) {
-        auto acrylic_color =
-            light_color
-                ? parse_color(
-                      config::current->context_menu.theme.acrylic_color_light)
-                : parse_color(
-                      config::current->context_menu.theme.acrylic_color_dark);
-
+    auto resolved = resolved_theme::current();
+    auto &theme = resolved->source->context_menu.theme;
+    auto light_color = resolved->light;
+    if (resolved->acrylic && is_acrylic_available()) {
         auto acrylic = std::make_shared<ui::acrylic_background_widget>(
-            config::current->context_menu.theme.use_dwm_if_available
-                ? is_win11_or_later()
-                : false);
-        acrylic->acrylic_bg_color = acrylic_color;
+            resolved->use_dwm);
+        acrylic->acrylic_bg_color = resolved->acrylic_color;
         acrylic->update_color();
         bg_impl = acrylic;
 
@@ -35,26 +29,19 @@ background_widget::background_widget(bool is_main) {
         bg_impl->bg_color = nvgRGBAf(c, c, c, 1);
     }
 
-    bg_impl->radius->reset_to(config::current->context_menu.theme.radius);
+    bg_impl->radius->reset_to(theme.radius);
     bg_impl->opacity->reset_to(0);
 
     if (is_main)
-        config::current->context_menu.theme.animation.main_bg.opacity(
-            bg_impl->opacity, 0);
+        theme.animation.main_bg.opacity(bg_impl->opacity, 0);
     else {
-        config::current->context_menu.theme.animation.submenu_bg.opacity(
-            bg_impl->opacity, 0);
-        config::current->context_menu.theme.animation.submenu_bg.x(bg_impl->x,
-                                                                   0);
-        config::current->context_menu.theme.animation.submenu_bg.y(bg_impl->y,
-                                                                   0);
-        config::current->context_menu.theme.animation.submenu_bg.w(
-            bg_impl->width, 0);
-        config::current->context_menu.theme.animation.submenu_bg.h(
-            bg_impl->height, 0);
+        theme.animation.submenu_bg.opacity(bg_impl->opacity, 0);
+        theme.animation.submenu_bg.x(bg_impl->x, 0);
+        theme.animation.submenu_bg.y(bg_impl->y, 0);
+        theme.animation.submenu_bg.w(bg_impl->width, 0);
+        theme.animation.submenu_bg.h(bg_impl->height, 0);
     }
-    bg_impl->opacity->animate_to(
-        255 * config::current->context_menu.theme.background_opacity);
+    bg_impl->opacity->animate_to(255 * theme.background_opacity);
 
     opacity = bg_impl->opacity;
     x = bg_impl->x;
@@ -80,24 +67,17 @@ void background_widget::render(ui::nanovg_context ctx) {
     {
         auto t = ctx.transaction();
         ctx.globalAlpha(*opacity / 255.f);
-        auto &theme = config::current->context_menu.theme;
-        bool light = is_light_mode();
-
-        bool use_dwm = theme.use_dwm_if_available ? is_win11_or_later() : false;
-        bool use_self_drawn_border = theme.use_self_drawn_border && !use_dwm;
+        auto resolved = resolved_theme::current();
+        auto &theme = resolved->source->context_menu.theme;
 
-        float boarder_width = use_self_drawn_border ? theme.border_width : 0.0f;
-        if (use_self_drawn_border) {
+        float boarder_width = resolved->border_width;
+        if (resolved->use_self_drawn_border) {
             float shadow_size = theme.shadow_size,
                   shadow_offset_x = theme.shadow_offset_x,
                   shadow_offset_y = theme.shadow_offset_y;
             float corner_radius = theme.radius;
-            NVGcolor shadow_color_from =
-                         parse_color(light ? theme.shadow_color_light_from
-                                           : theme.shadow_color_dark_from),
-                     shadow_color_to =
-                         parse_color(light ? theme.shadow_color_light_to
-                                           : theme.shadow_color_dark_to);
+            auto &shadow_color_from = resolved->shadow_color_from,
+                 &shadow_color_to = resolved->shadow_color_to;
 
             ctx.beginPath();
             ctx.roundedRect(*x - shadow_size + shadow_offset_x,
@@ -119,9 +99,7 @@ void background_widget::render(ui::nanovg_context ctx) {
                 ctx.roundedRect(*x, *y, *width, *height, corner_radius);
             }
             ctx.strokeWidth(boarder_width);
-            auto border_color =
-                light ? theme.border_color_light : theme.border_color_dark;
-            border_color.apply_to_ctx(ctx, *x, *y, *width, *height);
+            resolved->border_color.apply_to_ctx(ctx, *x, *y, *width, *height);
             ctx.stroke();
         }
 
@@ -0,0 +1,175 @@
+#include "shell/script/async_pool.h"
+#include "test.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <latch>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+using mb_shell::async_pool;
+
+namespace {
+// Stands in for a script context: the pool only compares owners and checks
+// whether they expired
+std::shared_ptr<qjs::Context> make_owner() {
+    return std::shared_ptr<qjs::Context>(std::make_shared<int>(), nullptr);
+}
+
+// Workers are detached, so test pools are never destroyed either
+async_pool &make_pool(size_t threads, size_t threads_per_owner) {
+    return *new async_pool(
+        [=] { return async_pool::limits{threads, threads_per_owner}; });
+}
+
+// Tracks how many tasks run at once
+struct concurrency {
+    std::atomic<int> running = 0, peak = 0;
+
+    void enter() {
+        auto now = ++running;
+        for (auto seen = peak.load(); now > seen;)
+            peak.compare_exchange_weak(seen, now);
+    }
+    void leave() { running--; }
+};
+} // namespace
+
+TEST_CASE(async_pool, owners_stay_within_their_quota) {
+    auto &pool = make_pool(4, 2);
+    auto a = make_owner(), b = make_owner();
+    concurrency all, of_a;
+    std::latch done(20);
+    for (int i = 0; i < 10; i++) {
+        pool.submit(a, [&] {
+            all.enter();
+            of_a.enter();
+            std::this_thread::sleep_for(10ms);
+            of_a.leave();
+            all.leave();
+            done.count_down();
+        });
+        pool.submit(b, [&] {
+            all.enter();
+            std::this_thread::sleep_for(10ms);
+            all.leave();
+            done.count_down();
+        });
+    }
+    done.wait();
+    CHECK(of_a.peak <= 2);
+    CHECK(all.peak <= 4);
+}
+
+// A plugin flooding the pool doesn't hold back another plugin's request
+TEST_CASE(async_pool, owners_take_turns) {
+    auto &pool = make_pool(1, 1);
+    auto a = make_owner(), b = make_owner();
+    std::promise<void> release;
+    std::mutex mutex;
+    std::string order;
+    std::latch done(6);
+    auto task = [&](char name) {
+        return [&, name] {
+            std::lock_guard lock(mutex);
+            order += name;
+            done.count_down();
+        };
+    };
+
+    pool.submit(a, [&, gate = release.get_future().share()] {
+        gate.wait();
+        task('a')();
+    });
+    for (int i = 0; i < 4; i++)
+        pool.submit(a, task('a'));
+    pool.submit(b, task('b'));
+    release.set_value();
+    done.wait();
+    CHECK(order.find('b') <= 2);
+    CHECK_EQ(std::ranges::count(order, 'a'), 5);
+}
+
+TEST_CASE(async_pool, destroyed_owner_cancels_queued_work) {
+    auto &pool = make_pool(1, 1);
+    auto a = make_owner(), b = make_owner();
+    std::promise<void> started, release;
+    std::atomic<int> ran = 0;
+    pool.submit(a, [&, gate = release.get_future().share()] {
+        started.set_value();
+        gate.wait();
+        ran++;
+    });
+    for (int i = 0; i < 3; i++)
+        pool.submit(a, [&] { ran++; });
+    started.get_future().wait();
+    a.reset();
+    release.set_value();
+
+    std::promise<void> b_done;
+    pool.submit(b, [&] { b_done.set_value(); });
+    CHECK(b_done.get_future().wait_for(5s) == std::future_status::ready);
+    // The running task finishes; the queued ones are dropped
+    CHECK_EQ(ran.load(), 1);
+}
+
+// 4 plugins firing 100 requests each that block for 5 ms, like WinHTTP
+// calls, on the default pool limits and on a thread per request
+BENCHMARK(async_pool, request_burst) {
+    constexpr int plugins = 4, requests = 100;
+    constexpr auto blocking = 5ms;
+    using clock = std::chrono::steady_clock;
+
+    auto run = [&](const char *label, auto submit) {
+        std::vector<std::shared_ptr<qjs::Context>> owners;
+        for (int p = 0; p < plugins; p++)
+            owners.push_back(make_owner());
+        concurrency threads;
+        std::vector<double> latencies(plugins * requests);
+        std::latch done(plugins * requests);
+
+        auto start = clock::now();
+        for (int i = 0; i < requests; i++)
+            for (int p = 0; p < plugins; p++)
+                submit(owners[p], [&, slot = i * plugins + p,
+                                   submitted = clock::now()] {
+                    threads.enter();
+                    std::this_thread::sleep_for(blocking);
+                    threads.leave();
+                    latencies[slot] = std::chrono::duration<double, std::milli>(
+                                          clock::now() - submitted)
+                                          .count();
+                    done.count_down();
+                });
+        done.wait();
+        auto total = std::chrono::duration<double, std::milli>(
+                         clock::now() - start)
+                         .count();
+
+        std::ranges::sort(latencies);
+        auto percentile = [&](double p) {
+            return latencies[size_t(p * (latencies.size() - 1))];
+        };
+        mb_shell::test::report(std::format("{}: peak", label),
+                               threads.peak.load(), "threads");
+        mb_shell::test::report(std::format("{}: p50 latency", label),
+                               percentile(0.5), "ms");
+        mb_shell::test::report(std::format("{}: p99 latency", label),
+                               percentile(0.99), "ms");
+        mb_shell::test::report(std::format("{}: all done", label), total,
+                               "ms");
+    };
+
+    auto &pool = make_pool(async_pool::limits{}.threads,
+                           async_pool::limits{}.threads_per_owner);
+    run("pool", [&](auto &owner, auto work) { pool.submit(owner, work); });
+    run("thread per request", [](auto &, auto work) {
+        std::thread(std::move(work)).detach();
+    });
+}
@@ -0,0 +1,237 @@
+#include "shell/script/bytecode_cache.h"
+#include "shell/script/quickjspp.hpp"
+#include "test.h"
+
+#include <chrono>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using mb_shell::bytecode_cache;
+
+namespace {
+// A scripts folder and its bytecode cache, like <data_directory>/scripts
+// and <data_directory>/cache
+struct scripts_folder {
+    std::filesystem::path directory =
+        std::filesystem::temp_directory_path() /
+        std::format("shell_test_bytecode_{}", std::random_device{}());
+    std::filesystem::path cache = directory / "cache";
+
+    scripts_folder() { std::filesystem::create_directories(directory); }
+    ~scripts_folder() {
+        std::error_code ec;
+        std::filesystem::remove_all(directory, ec);
+    }
+
+    std::filesystem::path write(const std::string &name,
+                                const std::string &source) {
+        auto path = directory / name;
+        std::ofstream(path, std::ios::binary | std::ios::trunc) << source;
+        return path;
+    }
+
+    std::vector<std::filesystem::path> entries() const {
+        std::vector<std::filesystem::path> entries;
+        if (std::filesystem::exists(cache))
+            for (auto &entry : std::filesystem::directory_iterator(cache))
+                entries.push_back(entry.path());
+        return entries;
+    }
+};
+
+// Compiles and runs a plugin the way script_context::load_plugin does;
+// false on a syntax or runtime error
+bool load(qjs::Context &ctx, const std::filesystem::path &path,
+          const std::filesystem::path &cache) {
+    std::ifstream file(path);
+    std::string script((std::istreambuf_iterator<char>(file)),
+                       std::istreambuf_iterator<char>());
+    auto func = bytecode_cache::compile_module(
+        ctx.ctx, script, path.generic_string(), cache);
+    if (JS_IsException(func)) {
+        JS_FreeValue(ctx.ctx, JS_GetException(ctx.ctx));
+        return false;
+    }
+    auto result = JS_EvalFunction(ctx.ctx, func);
+    bool ok = !JS_IsException(result);
+    if (!ok)
+        JS_FreeValue(ctx.ctx, JS_GetException(ctx.ctx));
+    JS_FreeValue(ctx.ctx, result);
+    return ok;
+}
+
+// A plugin of roughly the size and shape of the ones in the plugin
+// repository: menu handlers, a settings object and string helpers
+std::string plugin_source(int plugin, int handlers) {
+    std::string source = std::format(
+        "const settings = {{ name: 'plugin{}', enabled: true, "
+        "items: [] }};\n"
+        "export function label(text, n) {{\n"
+        "    return `${{settings.name}}: ${{text}} (${{n}})`;\n"
+        "}}\n",
+        plugin);
+    for (int h = 0; h < handlers; h++)
+        source += std::format(
+            "export function on_menu_{0}(menu, ctx) {{\n"
+            "    const items = menu.items.filter(i => i.name?.includes("
+            "'{0}'));\n"
+            "    for (const [i, item] of items.entries()) {{\n"
+            "        if (item.disabled || i % 3 === 2) continue;\n"
+            "        settings.items.push({{ id: {0}, name: label(item.name, "
+            "i),\n"
+            "            action: () => ctx.run(item.name.split(' ')"
+            ".map(s => s.trim()).join('-')) }});\n"
+            "    }}\n"
+            "    return items.length > {1} ? items.slice(0, {1}) : items;\n"
+            "}}\n",
+            h, h % 7 + 1);
+    source += std::format("globalThis.plugin{} = settings.name;\n", plugin);
+    return source;
+}
+} // namespace
+
+TEST_CASE(bytecode_cache, second_load_reads_the_entry) {
+    scripts_folder folder;
+    qjs::Runtime rt;
+    auto path = folder.write("a.js", "globalThis.a = 40 + 2;\n");
+    {
+        auto ctx = std::make_shared<qjs::Context>(rt);
+        CHECK(load(*ctx, path, folder.cache));
+        CHECK_EQ(ctx->eval("a").as<int>(), 42);
+    }
+    CHECK_EQ(folder.entries().size(), 1u);
+    auto written = std::filesystem::last_write_time(folder.entries()[0]);
+
+    auto ctx = std::make_shared<qjs::Context>(rt);
+    CHECK(load(*ctx, path, folder.cache));
+    CHECK_EQ(ctx->eval("a").as<int>(), 42);
+    CHECK(std::filesystem::last_write_time(folder.entries()[0]) == written);
+}
+
+TEST_CASE(bytecode_cache, edited_source_is_compiled_again) {
+    scripts_folder folder;
+    qjs::Runtime rt;
+    auto path = folder.write("a.js", "globalThis.a = 1;\n");
+    {
+        auto ctx = std::make_shared<qjs::Context>(rt);
+        CHECK(load(*ctx, path, folder.cache));
+    }
+    folder.write("a.js", "globalThis.a = 2;\n");
+    auto ctx = std::make_shared<qjs::Context>(rt);
+    CHECK(load(*ctx, path, folder.cache));
+    CHECK_EQ(ctx->eval("a").as<int>(), 2);
+    CHECK_EQ(folder.entries().size(), 1u);
+}
+
+TEST_CASE(bytecode_cache, corrupt_entry_falls_back_to_source) {
+    scripts_folder folder;
+    qjs::Runtime rt;
+    auto path = folder.write("a.js", "globalThis.a = 'from source';\n");
+    {
+        auto ctx = std::make_shared<qjs::Context>(rt);
+        CHECK(load(*ctx, path, folder.cache));
+    }
+    // Keep the key, garble the bytecode after it
+    auto entry = folder.entries()[0];
+    std::string data;
+    {
+        std::ifstream file(entry, std::ios::binary);
+        data.assign(std::istreambuf_iterator<char>(file),
+                    std::istreambuf_iterator<char>());
+    }
+    data.resize(data.size() - 8);
+    std::ofstream(entry, std::ios::binary | std::ios::trunc) << data;
+
+    auto ctx = std::make_shared<qjs::Context>(rt);
+    CHECK(load(*ctx, path, folder.cache));
+    CHECK_EQ(ctx->eval("a").as<std::string>(), "from source");
+}
+
+TEST_CASE(bytecode_cache, syntax_error_writes_nothing) {
+    scripts_folder folder;
+    qjs::Runtime rt;
+    auto ctx = std::make_shared<qjs::Context>(rt);
+    CHECK(!load(*ctx, folder.write("a.js", "export const = 1;\n"),
+                folder.cache));
+    CHECK(folder.entries().empty());
+}
+
+TEST_CASE(bytecode_cache, prune_drops_entries_of_deleted_plugins) {
+    scripts_folder folder;
+    qjs::Runtime rt;
+    auto ctx = std::make_shared<qjs::Context>(rt);
+    auto kept = folder.write("kept.js", "globalThis.k = 1;\n");
+    // Same file name in another folder gets its own entry
+    std::filesystem::create_directories(folder.directory / "old");
+    auto deleted = folder.write("old/kept.js", "globalThis.d = 1;\n");
+    CHECK(load(*ctx, kept, folder.cache));
+    CHECK(load(*ctx, deleted, folder.cache));
+    CHECK_EQ(folder.entries().size(), 2u);
+
+    bytecode_cache::prune({kept.generic_string()}, folder.cache);
+    CHECK_EQ(folder.entries().size(), 1u);
+    bytecode_cache::prune({}, folder.cache);
+    CHECK(folder.entries().empty());
+}
+
+// 30 plugins of about 17 KB each, loaded into a fresh context the way
+// watch_folder does on every reload: compiled from source with no cache,
+// with a cold cache (compile and write) and with a warm one
+BENCHMARK(bytecode_cache, plugin_load) {
+    constexpr int plugins = 30, handlers = 40, rounds = 10;
+    scripts_folder folder;
+    std::vector<std::filesystem::path> files;
+    size_t bytes = 0;
+    for (int p = 0; p < plugins; p++) {
+        auto source = plugin_source(p, handlers);
+        bytes += source.size();
+        files.push_back(folder.write(std::format("plugin{}.js", p), source));
+    }
+    mb_shell::test::report("plugin sources", bytes / 1024.0, "KB");
+
+    qjs::Runtime rt;
+    auto run = [&](const char *label, auto prepare, auto load_one) {
+        double total = 0;
+        for (int r = 0; r < rounds; r++) {
+            prepare();
+            auto ctx = std::make_shared<qjs::Context>(rt);
+            auto start = std::chrono::steady_clock::now();
+            for (auto &file : files)
+                CHECK(load_one(*ctx, file));
+            total += std::chrono::duration<double, std::milli>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+            CHECK_EQ(ctx->eval("plugin29").as<std::string>(), "plugin29");
+        }
+        mb_shell::test::report(label, total / rounds, "ms");
+    };
+
+    run("30 plugins, source only", [] {},
+        [&](qjs::Context &ctx, const std::filesystem::path &file) {
+            std::ifstream in(file);
+            std::string script((std::istreambuf_iterator<char>(in)),
+                               std::istreambuf_iterator<char>());
+            auto func = JS_Eval(ctx.ctx, script.c_str(), script.size(),
+                                file.generic_string().c_str(),
+                                JS_EVAL_TYPE_MODULE |
+                                    JS_EVAL_FLAG_COMPILE_ONLY);
+            auto result = JS_EvalFunction(ctx.ctx, func);
+            bool ok = !JS_IsException(result);
+            JS_FreeValue(ctx.ctx, result);
+            return ok;
+        });
+    run("30 plugins, cold cache",
+        [&] { std::filesystem::remove_all(folder.cache); },
+        [&](qjs::Context &ctx, const std::filesystem::path &file) {
+            return load(ctx, file, folder.cache);
+        });
+    run("30 plugins, warm cache", [] {},
+        [&](qjs::Context &ctx, const std::filesystem::path &file) {
+            return load(ctx, file, folder.cache);
+        });
+}
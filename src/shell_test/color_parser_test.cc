@@ -0,0 +1,163 @@
+#include "shell/paint_color.h"
+#include "test.h"
+
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+using namespace mb_shell;
+
+namespace {
+// What std::stof does with the string, as a value or the exception name
+template <typename F> std::string outcome(F &&parse) {
+    try {
+        float value = parse();
+        if (std::isnan(value))
+            return std::signbit(value) ? "-nan" : "nan";
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return std::format("{:08x}", bits);
+    } catch (std::invalid_argument &) {
+        return "invalid_argument";
+    } catch (std::out_of_range &) {
+        return "out_of_range";
+    }
+}
+
+void check_like_stof(const std::string &str) {
+    auto expected = outcome([&] { return std::stof(str); });
+    auto actual = outcome([&] { return color_parser::parse_float(str); });
+    if (actual != expected)
+        throw test::failure(std::format("parse_float(\"{}\"): expected {}, got {}",
+                                        str, expected, actual));
+}
+} // namespace
+
+TEST_CASE(color_parser, parse_float_matches_stof) {
+    for (auto str :
+         {"0", "1", "-1", "+1", " \t42", "3.14159", ".5", "5.", "-.25",
+          "1e3", "1E-3", "2.5e+2", "1e", "1e+", "1ex", "10deg", "45,", "1.2.3",
+          "0.1", "0.7", "16777217", "123456789012345678901234567890",
+          "0.000000000000000000000000000000000000000012", "3.4028235e38",
+          "1e39", "-1e39", "1e-50", "inf", "-Infinity", "INF", "nan", "-nan",
+          "nan(123)", "0x1p3", "0x1.8p1", "-0x.8", "0X10", "0x", "0xg", "",
+          " ", ".", "-", "+-1", "--1", "e5", "x", "0.1f", "1_000"})
+        check_like_stof(str);
+}
+
+TEST_CASE(color_parser, parse_float_matches_stof_on_random_decimals) {
+    std::mt19937 rng(7);
+    for (int i = 0; i < 200000; i++) {
+        std::string str;
+        if (rng() % 4 == 0)
+            str += "-";
+        auto integer_digits = rng() % 8;
+        for (size_t d = 0; d < integer_digits; d++)
+            str += char('0' + rng() % 10);
+        if (rng() % 2) {
+            str += '.';
+            auto fraction_digits = rng() % 12;
+            for (size_t d = 0; d < fraction_digits; d++)
+                str += char('0' + rng() % 10);
+        }
+        if (rng() % 4 == 0)
+            str += std::format("e{}", int(rng() % 60) - 30);
+        check_like_stof(str);
+    }
+}
+
+TEST_CASE(color_parser, constant_evaluation_matches_stof) {
+    constexpr float values[] = {
+        color_parser::parse_float("0.1"),   color_parser::parse_float("0.7"),
+        color_parser::parse_float("-12.5"), color_parser::parse_float("1e-3"),
+        color_parser::parse_float("45"),    color_parser::parse_float("0x1.8p1"),
+        color_parser::parse_float("90deg"), color_parser::parse_float(" 2.5e2"),
+    };
+    constexpr const char *strings[] = {"0.1", "0.7",     "-12.5", "1e-3",
+                                       "45",  "0x1.8p1", "90deg", " 2.5e2"};
+    for (size_t i = 0; i < std::size(values); i++)
+        CHECK_EQ(values[i], std::stof(strings[i]));
+}
+
+TEST_CASE(color_parser, parse_int_matches_stoi) {
+    for (auto str : {"0", "255", " -7", "+8", "12px", "ff", "0x1f", "0x",
+                     "2147483647", "2147483648", "-2147483648", "", "z"}) {
+        for (int base : {10, 16}) {
+            std::string expected, actual;
+            try {
+                expected = std::to_string(std::stoi(str, nullptr, base));
+            } catch (std::exception &e) {
+                expected = typeid(e).name();
+            }
+            try {
+                actual = std::to_string(color_parser::parse_int(str, base));
+            } catch (std::exception &e) {
+                actual = typeid(e).name();
+            }
+            if (actual != expected)
+                throw test::failure(
+                    std::format("parse_int(\"{}\", {}): expected {}, got {}",
+                                str, base, expected, actual));
+        }
+    }
+}
+
+TEST_CASE(color_parser, colors) {
+    CHECK(rgba_color::from_string("#ff000080") ==
+          rgba_color(1, 0, 0, 128 / 255.f));
+    CHECK(rgba_color::from_string("0f0") == rgba_color(0, 1, 0));
+    CHECK(rgba_color::from_string("255, 0,255") == rgba_color(1, 0, 1));
+    CHECK(rgba_color::from_string("") == rgba_color(0, 0, 0));
+    CHECK_THROWS(rgba_color::from_string("#gg0000"), std::invalid_argument);
+
+    auto gradient = paint_color::from_string("radial-gradient(12.5, #000, #fff)");
+    CHECK(gradient.type == paint_color::type::radial_gradient);
+    CHECK_EQ(gradient.radius, 12.5f);
+    CHECK_EQ(gradient.radius2, 25.0f);
+    CHECK(gradient.color2 == rgba_color(1, 1, 1));
+}
+
+TEST_CASE(color_parser, rgba_to_string_round_trips) {
+    for (int v = 0; v < 256; v++) {
+        rgba_color color(color_parser::channel(v),
+                         color_parser::channel(255 - v),
+                         color_parser::channel(v / 3), color_parser::channel(v));
+        auto str = color.to_string();
+        if (!(rgba_color::from_string(str) == color))
+            throw test::failure(std::format("{} doesn't parse back", str));
+    }
+    CHECK_EQ(rgba_color::from_string("#0Af").to_string(), "#00aaffff");
+    // Out of range channels, e.g. set from a script, still print as a color
+    CHECK_EQ(rgba_color(2, -1, 0.5f).to_string(), "#ff0080ff");
+}
+
+TEST_CASE(color_parser, paint_to_string_round_trips) {
+    std::vector<std::string> sources = {
+        "#12345678", "solid(#abc)", "linear-gradient(0, #000, #fff)",
+        "linear-gradient(45, #f00, #00f8)", "linear-gradient(-90.5, #1, #2)",
+        "linear-gradient(1e-3, #000, #fff)", "radial-gradient(12.5, #000, #fff)",
+        "radial-gradient(0.1, #ff0000, #00ff0080)"};
+    std::mt19937 rng(9);
+    for (int i = 0; i < 20000; i++) {
+        auto number = std::format("{}.{}", int(rng() % 1440) - 720, rng() % 1000);
+        auto color = std::format("#{:08x}", uint32_t(rng()));
+        sources.push_back(std::format("linear-gradient({}, {}, #fff)", number,
+                                      color));
+        sources.push_back(std::format("radial-gradient({}, #000, {})",
+                                      number.substr(number[0] == '-'), color));
+    }
+
+    for (auto &source : sources) {
+        auto paint = paint_color::from_string(source);
+        auto str = paint.to_string();
+        if (!(paint_color::from_string(str) == paint))
+            throw test::failure(std::format(
+                "{} printed as {}, which doesn't parse back", source, str));
+    }
+    CHECK_EQ(paint_color::from_string("linear-gradient(45, #000, #fff)")
+                 .to_string(),
+             "linear-gradient(45, #000000ff, #ffffffff)");
+}
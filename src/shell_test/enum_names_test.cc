@@ -0,0 +1,137 @@
+#include "shell/enum_names.h"
+#include "shell/paint_color.h"
+#include "test.h"
+
+#include <optional>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace mb_shell;
+
+namespace {
+// Same names as the shell's enums that live in headers shell_test can't
+// build (breeze-ui widgets, the context menu, the taskbar)
+enum class popup_direction { top_left, top_right, bottom_left, bottom_right };
+enum class menu_item_type { button, spacer };
+enum class menu_position { top, bottom };
+enum class justify {
+    start,
+    center,
+    end,
+    space_between,
+    space_around,
+    space_evenly
+};
+
+// Values that aren't named must not be found
+enum class sparse { first = 1, second = 3, last = 10 };
+
+// paint_color::type names both the enum and the member holding it
+using paint_type = decltype(paint_color::type);
+
+// The lookup enum_from_string did before the sorted table: a copy of the
+// input per candidate name
+template <typename E>
+std::optional<E> linear_enum_from_string(std::string_view str) {
+    static constexpr auto enum_map = create_enum_map<E>();
+    for (const auto &[name, value] : enum_map) {
+        if ((str | std::views::transform([](char c) {
+                 return c == '-' ? '_' : c;
+             }) |
+             std::ranges::to<std::string>()) == name) {
+            return value;
+        }
+    }
+    return std::nullopt;
+}
+
+// Every name of E in both spellings, then a miss per name
+template <typename E> std::vector<std::string> inputs_for() {
+    std::vector<std::string> inputs;
+    for (auto &[name, value] : enum_map<E>) {
+        inputs.emplace_back(name);
+        inputs.push_back(string_from_enum(value));
+        inputs.push_back(std::string(name) + "x");
+    }
+    return inputs;
+}
+} // namespace
+
+static_assert(enum_map<justify>.size() == 6);
+static_assert(enum_map<sparse>.size() == 3);
+static_assert(enum_from_string<sparse>("last") == sparse::last);
+
+TEST_CASE(enum_names, round_trips_every_name) {
+    auto check = [](auto value) {
+        using E = decltype(value);
+        CHECK(enum_from_string<E>(string_from_enum(value)) == value);
+        CHECK(enum_from_string<E>(reflect::enum_name(value)) == value);
+    };
+    for (auto &[name, value] : enum_map<justify>)
+        check(value);
+    for (auto &[name, value] : enum_map<popup_direction>)
+        check(value);
+    for (auto &[name, value] : enum_map<paint_type>)
+        check(value);
+    CHECK_EQ(string_from_enum(justify::space_between), "space-between");
+    CHECK_EQ(string_from_enum(paint_type::linear_gradient),
+             "linear-gradient");
+}
+
+TEST_CASE(enum_names, matches_the_linear_scan) {
+    auto check = [](auto tag) {
+        using E = decltype(tag);
+        auto inputs = inputs_for<E>();
+        for (auto extra : {"", "-", "_", "top", "top-", "bottom_left_",
+                           "Start", "space--between", "radial-gradient "})
+            inputs.emplace_back(extra);
+        for (auto &input : inputs)
+            CHECK(enum_from_string<E>(input) ==
+                  linear_enum_from_string<E>(input));
+    };
+    check(justify{});
+    check(popup_direction{});
+    check(menu_item_type{});
+    check(menu_position{});
+    check(sparse{});
+    check(paint_type{});
+}
+
+BENCHMARK(enum_names, lookups) {
+    std::vector<std::string> inputs;
+    auto add = [&](auto tag) {
+        for (auto &input : inputs_for<decltype(tag)>())
+            inputs.push_back(input);
+    };
+    add(justify{});
+    add(popup_direction{});
+    add(menu_item_type{});
+    add(menu_position{});
+    add(paint_type{});
+    constexpr size_t rounds = 20000;
+
+    auto run = [&](const char *label, auto lookup) {
+        size_t found = 0, i = 0;
+        mb_shell::test::measure(label, rounds * inputs.size(), [&] {
+            found += lookup(inputs[i++ % inputs.size()]);
+        });
+        return found;
+    };
+    auto found_sorted = run("sorted table", [](std::string_view s) {
+        return enum_from_string<justify>(s).has_value() +
+               enum_from_string<popup_direction>(s).has_value() +
+               enum_from_string<menu_item_type>(s).has_value() +
+               enum_from_string<menu_position>(s).has_value() +
+               enum_from_string<paint_type>(s).has_value();
+    });
+    auto found_linear = run("linear scan", [](std::string_view s) {
+        return linear_enum_from_string<justify>(s).has_value() +
+               linear_enum_from_string<popup_direction>(s).has_value() +
+               linear_enum_from_string<menu_item_type>(s).has_value() +
+               linear_enum_from_string<menu_position>(s).has_value() +
+               linear_enum_from_string<paint_type>(s).has_value();
+    });
+    CHECK_EQ(found_sorted, found_linear);
+}
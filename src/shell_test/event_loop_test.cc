@@ -0,0 +1,304 @@
+#include "shell/script/FileWatch.hpp"
+#include "shell/script/quickjspp.hpp"
+#include "test.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace {
+// A context whose loop runs on the test thread, as on the shell's JS thread
+struct js_loop {
+    qjs::Runtime rt;
+    std::shared_ptr<qjs::Context> ctx = std::make_shared<qjs::Context>(rt);
+
+    js_loop() {
+        is_thread_js_main = true;
+        ctx->eval("globalThis.log = []");
+    }
+    ~js_loop() { is_thread_js_main = false; }
+
+    // Runs the loop until a job stops it, or gives up after `timeout` so a
+    // broken loop fails the test instead of hanging it
+    void run(std::chrono::milliseconds timeout = 5s) {
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool done = false;
+        std::thread watchdog([&] {
+            std::unique_lock lock(mutex);
+            if (!cv.wait_for(lock, timeout, [&] { return done; }))
+                ctx->stopEventLoop();
+        });
+        ctx->runEventLoop();
+        {
+            std::lock_guard lock(mutex);
+            done = true;
+        }
+        cv.notify_one();
+        watchdog.join();
+    }
+
+    std::string log() { return ctx->eval("log.join()").as<std::string>(); }
+};
+} // namespace
+
+TEST_CASE(event_loop, promise_chains_resolve_in_order) {
+    js_loop loop;
+    loop.ctx->enqueueJob([&] {
+        loop.ctx->eval(R"(
+            Promise.resolve(1)
+                .then(v => { log.push('a' + v); return v + 1; })
+                .then(v => { log.push('b' + v); return Promise.resolve(v + 1); })
+                .then(v => log.push('c' + v));
+            log.push('sync');
+        )");
+    });
+    loop.ctx->enqueueJob([&] { loop.ctx->stopEventLoop(); });
+    loop.run();
+    CHECK_EQ(loop.log(), "sync,a1,b2,c3");
+}
+
+// Each job's promise reactions run before the next job, like a browser's
+// task and microtask queues
+TEST_CASE(event_loop, microtasks_drain_between_jobs) {
+    js_loop loop;
+    for (auto name : {"1", "2"})
+        loop.ctx->enqueueJob([&, name = std::string(name)] {
+            loop.ctx->eval("log.push('job" + name + "'); Promise.resolve()"
+                          ".then(() => log.push('micro" + name + "'))");
+        });
+    loop.ctx->enqueueJob([&] { loop.ctx->stopEventLoop(); });
+    loop.run();
+    CHECK_EQ(loop.log(), "job1,micro1,job2,micro2");
+}
+
+// Timer callbacks are posted from the scheduler's thread while the loop is
+// asleep
+TEST_CASE(event_loop, timer_jobs_wake_the_loop) {
+    js_loop loop;
+    loop.ctx->eval("globalThis.tick = n => { log.push('tick' + n); "
+                  "return Promise.resolve().then(() => log.push('then' + n)); }");
+    std::thread timers([&] {
+        for (int i = 1; i <= 3; i++) {
+            std::this_thread::sleep_for(20ms);
+            loop.ctx->enqueueJob([&, i] {
+                loop.ctx->eval(std::format("tick({})", i));
+                if (i == 3)
+                    loop.ctx->stopEventLoop();
+            });
+        }
+    });
+    loop.run();
+    timers.join();
+    CHECK_EQ(loop.log(), "tick1,then1,tick2,then2,tick3,then3");
+}
+
+TEST_CASE(event_loop, file_watch_events_reach_js) {
+    js_loop loop;
+    auto directory = std::filesystem::temp_directory_path() /
+                     std::format("shell_test_loop_{}", std::random_device{}());
+    std::filesystem::create_directories(directory);
+    auto file = directory / "watched.js";
+    std::ofstream(file) << "1";
+    loop.ctx->eval("globalThis.changed = () => { log.push('changed'); }");
+    {
+        filewatch::FileWatch<std::string> watch(
+            file.string(), [&](const std::string &, const filewatch::Event) {
+                loop.ctx->enqueueJob([&] {
+                    loop.ctx->eval("changed()");
+                    loop.ctx->stopEventLoop();
+                });
+            });
+        std::thread writer([&] {
+            std::this_thread::sleep_for(20ms);
+            std::ofstream(file) << "2";
+        });
+        loop.run();
+        writer.join();
+    }
+    std::error_code ec;
+    std::filesystem::remove_all(directory, ec);
+    CHECK_EQ(loop.log(), "changed");
+}
+
+TEST_CASE(event_loop, jobs_from_many_threads_all_run) {
+    js_loop loop;
+    constexpr int threads = 4, per_thread = 25000;
+    int ran = 0;
+    std::vector<std::thread> producers;
+    for (int t = 0; t < threads; t++)
+        producers.emplace_back([&] {
+            for (int i = 0; i < per_thread; i++)
+                loop.ctx->enqueueJob([&] {
+                    if (++ran == threads * per_thread)
+                        loop.ctx->stopEventLoop();
+                });
+        });
+    loop.run(30s);
+    for (auto &producer : producers)
+        producer.join();
+    CHECK_EQ(ran, threads * per_thread);
+}
+
+TEST_CASE(event_loop, errors_are_reported_and_do_not_stop_the_loop) {
+    js_loop loop;
+    std::stringstream errors;
+    auto cerr = std::cerr.rdbuf(errors.rdbuf());
+    loop.ctx->enqueueJob([] { throw std::runtime_error("native"); });
+    loop.ctx->enqueueJob([&] { loop.ctx->eval("throw new Error('js')"); });
+    loop.ctx->enqueueJob([&] {
+        loop.ctx->eval("Promise.reject(new Error('rejected')); "
+                      "log.push('after')");
+    });
+    loop.ctx->enqueueJob([&] { loop.ctx->stopEventLoop(); });
+    loop.run();
+    std::cerr.rdbuf(cerr);
+    CHECK_EQ(loop.log(), "after");
+    CHECK(errors.str().contains("Error in JS job: native"));
+    CHECK(errors.str().contains("Error in JS job: Error: js"));
+}
+
+// Jobs left behind by a stop are dropped without running
+TEST_CASE(event_loop, stop_drops_queued_jobs) {
+    js_loop loop;
+    loop.ctx->enqueueJob([&] { loop.ctx->stopEventLoop(); });
+    loop.ctx->enqueueJob([&] { loop.ctx->eval("log.push('late')"); });
+    loop.run();
+    CHECK_EQ(loop.log(), "");
+}
+
+// Native threads calling into JS each wait on a msgloop_waiter; none of the
+// calls may be lost or answered out of turn
+TEST_CASE(event_loop, native_thread_calls_js_100k_times) {
+    js_loop loop;
+    auto add_one = loop.ctx->eval("n => n + 1").as<std::function<int(int)>>();
+    constexpr int calls = 100000;
+    int correct = 0;
+    std::thread caller([&] {
+        try {
+            for (int i = 0; i < calls; i++)
+                correct += add_one(i) == i + 1;
+        } catch (std::exception &) {
+            // The watchdog stopped the loop; the count below reports it
+        }
+        loop.ctx->enqueueJob([&] { loop.ctx->stopEventLoop(); });
+    });
+    loop.run(60s);
+    caller.join();
+    CHECK_EQ(correct, calls);
+}
+
+BENCHMARK(event_loop, native_thread_calls_js) {
+    js_loop loop;
+    auto add_one = loop.ctx->eval("n => n + 1").as<std::function<int(int)>>();
+    constexpr int calls = 100000;
+    int sum = 0;
+    std::thread caller([&] {
+        mb_shell::test::measure("msgloop_waiter", calls,
+                                [&] { sum += add_one(1); });
+        // What every call cost when wait_with_msgloop started a thread per
+        // wait
+        mb_shell::test::measure("thread per wait", calls, [&] {
+            std::thread([&] { sum += add_one(1); }).join();
+        });
+        loop.ctx->enqueueJob([&] { loop.ctx->stopEventLoop(); });
+    });
+    loop.run(300s);
+    caller.join();
+    CHECK_EQ(sum, 2 * 2 * calls);
+}
+
+// Producers like fs::watch and the timer thread post instead of waiting for
+// a slow JS consumer
+TEST_CASE(event_loop, posted_calls_do_not_wait) {
+    js_loop loop;
+    std::function<void(int)> slow =
+        loop.ctx
+            ->eval("n => { const end = Date.now() + 20; "
+                   "while (Date.now() < end) {} log.push(n); }")
+            .as<std::function<void(int)>>();
+    double posting_ms = 0;
+    std::thread producer([&] {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 1; i <= 3; i++)
+            CHECK(qjs::post_call(slow, i));
+        posting_ms = std::chrono::duration<double, std::milli>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+        loop.ctx->enqueueJob([&] { loop.ctx->stopEventLoop(); });
+    });
+    loop.run();
+    producer.join();
+    CHECK(posting_ms < 20);
+    CHECK_EQ(loop.log(), "1,2,3");
+}
+
+TEST_CASE(event_loop, posting_is_refused_past_the_limit) {
+    js_loop loop;
+    loop.ctx->eval("globalThis.calls = 0");
+    std::function<void()> count =
+        loop.ctx->eval("() => { calls++; }").as<std::function<void()>>();
+    auto limit = qjs::js_function<void>::max_pending;
+    for (size_t i = 0; i < limit; i++)
+        CHECK(qjs::post_call(count));
+    CHECK(!qjs::post_call(count));
+
+    loop.ctx->enqueueJob([&] { loop.ctx->stopEventLoop(); });
+    loop.run();
+    CHECK_EQ(loop.ctx->eval("calls").as<int>(), int(limit));
+    CHECK(qjs::post_call(count));
+}
+
+TEST_CASE(event_loop, call_async_delivers_results_and_errors) {
+    js_loop loop;
+    // Unwrapping to std::function gives a js_function
+    auto half = loop.ctx
+                    ->eval("n => { if (n % 2) throw new Error('odd'); "
+                           "return n / 2; }")
+                    .as<std::function<int(int)>>();
+    auto even = half.call_async(8);
+    auto odd = half.call_async(3);
+    loop.ctx->enqueueJob([&] { loop.ctx->stopEventLoop(); });
+    loop.run();
+    CHECK_EQ(even.get(), 4);
+    CHECK_THROWS(odd.get(), std::exception);
+}
+
+// A producer thread calling a JS consumer that takes 1 ms per call
+BENCHMARK(event_loop, producer_latency_with_slow_consumer) {
+    js_loop loop;
+    auto slow = loop.ctx
+                    ->eval("n => { const end = Date.now() + 1; "
+                           "while (Date.now() < end) {} return n; }")
+                    .as<std::function<int(int)>>();
+    constexpr int calls = 200;
+    std::thread producer([&] {
+        mb_shell::test::measure("blocking call", calls, [&] { slow(1); });
+        std::vector<std::future<int>> results;
+        mb_shell::test::measure("call_async", calls, [&] {
+            results.push_back(slow.call_async(1));
+        });
+        for (auto &result : results)
+            result.get();
+        mb_shell::test::measure("post", calls, [&] { slow.post(1); });
+        // Queued behind the posted calls
+        slow(1);
+        loop.ctx->enqueueJob([&] { loop.ctx->stopEventLoop(); });
+    });
+    loop.run(60s);
+    producer.join();
+}
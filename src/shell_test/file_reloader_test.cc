@@ -0,0 +1,80 @@
+#include "shell/file_reloader.h"
+#include "test.h"
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+
+using namespace std::chrono_literals;
+using mb_shell::file_reloader;
+
+namespace {
+// A watched file in a temp folder, with run() on its own thread like the
+// config loader
+struct watched_file {
+    std::filesystem::path directory =
+        std::filesystem::temp_directory_path() /
+        std::format("shell_test_reload_{}", std::random_device{}());
+    std::filesystem::path path = directory / "config.json";
+    std::atomic<int> reloads = 0;
+    std::unique_ptr<file_reloader> reloader;
+    std::thread loader;
+
+    watched_file() {
+        std::filesystem::create_directories(directory);
+        write("{}");
+        reloader = std::make_unique<file_reloader>(path, [this] { reloads++; });
+        loader = std::thread([this] { reloader->run(); });
+    }
+
+    ~watched_file() {
+        reloader->stop();
+        loader.join();
+        reloader.reset();
+        std::error_code ec;
+        std::filesystem::remove_all(directory, ec);
+    }
+
+    void write(const std::string &content) {
+        std::ofstream(path, std::ios::binary) << content;
+    }
+
+    // Reloads so far, once a change had time to pass the quiet period
+    int settle() {
+        std::this_thread::sleep_for(500ms);
+        return reloads;
+    }
+};
+} // namespace
+
+TEST_CASE(file_reloader, no_wakeups_while_idle) {
+    watched_file file;
+    std::this_thread::sleep_for(10s);
+    CHECK_EQ(file.reloader->wakeups(), 0u);
+    CHECK_EQ(file.reloads.load(), 0);
+}
+
+TEST_CASE(file_reloader, save_burst_reloads_once) {
+    watched_file file;
+    // Like an editor: truncate, write in parts, then touch again
+    for (auto part : {"", "{\"a\"", "{\"a\": 1}", "{\"a\": 1}"}) {
+        file.write(part);
+        std::this_thread::sleep_for(20ms);
+    }
+    CHECK_EQ(file.settle(), 1);
+
+    file.write("{\"a\": 2}");
+    CHECK_EQ(file.settle(), 2);
+}
+
+TEST_CASE(file_reloader, unchanged_content_is_skipped) {
+    watched_file file;
+    file.write("{}");
+    CHECK_EQ(file.settle(), 0);
+    CHECK(file.reloader->wakeups() > 0);
+}
@@ -0,0 +1,97 @@
+#include "shell/i18n_template.h"
+#include "test.h"
+
+#include <map>
+#include <random>
+#include <regex>
+#include <string>
+#include <vector>
+
+using mb_shell::i18n_template;
+
+namespace {
+// The std::regex implementation i18n_template replaced
+std::string regex_interpolate(const std::string &str,
+                              const std::map<std::string, std::string> &params) {
+    if (params.empty()) {
+        return str;
+    }
+
+    std::regex placeholder_regex(R"(\{([\w.-]+)\})");
+    std::smatch match;
+    std::string::const_iterator search_start(str.cbegin());
+    std::string output;
+
+    while (std::regex_search(search_start, str.cend(), match,
+                             placeholder_regex)) {
+        output.append(search_start, match[0].first);
+        auto param_it = params.find(match[1].str());
+        if (param_it != params.end()) {
+            output.append(param_it->second);
+        } else {
+            output.append(match[0].str());
+        }
+        search_start = match.suffix().first;
+    }
+    output.append(search_start, str.cend());
+    return output;
+}
+
+std::string interpolate(const std::string &str,
+                        const std::map<std::string, std::string> &params) {
+    std::vector<i18n_template::segment> segments;
+    if (params.empty() || !i18n_template::compile(str, segments)) {
+        return str;
+    }
+    std::vector<std::pair<std::string_view, std::string_view>> views(
+        params.begin(), params.end());
+    return i18n_template::interpolate(str, segments, views);
+}
+} // namespace
+
+TEST_CASE(i18n_template, substitutes_placeholders) {
+    std::map<std::string, std::string> params{
+        {"name", "Breeze"}, {"user.name", "A"}, {"my-key", "B"}, {"n_1", "C"}};
+    CHECK_EQ(interpolate("Hello {name}!", params), "Hello Breeze!");
+    CHECK_EQ(interpolate("{user.name}{my-key}{n_1}", params), "ABC");
+    CHECK_EQ(interpolate("{name} and {name}", params), "Breeze and Breeze");
+}
+
+TEST_CASE(i18n_template, keeps_unmatched_and_malformed) {
+    std::map<std::string, std::string> params{{"name", "x"}};
+    CHECK_EQ(interpolate("{missing}", params), "{missing}");
+    CHECK_EQ(interpolate("{}", params), "{}");
+    CHECK_EQ(interpolate("{name", params), "{name");
+    CHECK_EQ(interpolate("{na me}", params), "{na me}");
+    CHECK_EQ(interpolate("{{name}}", params), "{x}");
+    CHECK_EQ(interpolate("no placeholders", params), "no placeholders");
+}
+
+TEST_CASE(i18n_template, compile_reports_placeholders) {
+    std::vector<i18n_template::segment> segments;
+    CHECK(!i18n_template::compile("plain {text", segments));
+    CHECK(segments.empty());
+    CHECK(i18n_template::compile("a{b}c", segments));
+    CHECK_EQ(segments.size(), 3u);
+    CHECK(segments[1].placeholder);
+    CHECK_EQ(segments[1].offset, 1u);
+    CHECK_EQ(segments[1].size, 3u);
+}
+
+TEST_CASE(i18n_template, matches_regex_on_random_input) {
+    // Biased towards the characters the grammar cares about
+    constexpr std::string_view alphabet = "{}{}ab._-  Z9\xe4\xb8\xad";
+    std::map<std::string, std::string> params{
+        {"a", "1"}, {"b.", "22"}, {"_-", ""}, {"Z9", "{a}"}};
+    std::mt19937 rng(42);
+    for (int i = 0; i < 20000; i++) {
+        std::string str(rng() % 24, ' ');
+        for (auto &c : str)
+            c = alphabet[rng() % alphabet.size()];
+        auto expected = regex_interpolate(str, params);
+        auto actual = interpolate(str, params);
+        if (actual != expected)
+            throw mb_shell::test::failure(std::format(
+                "\"{}\": expected \"{}\", got \"{}\"", str, expected, actual));
+    }
+}
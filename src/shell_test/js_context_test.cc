@@ -0,0 +1,254 @@
+#include "shell/script/js_arena.h"
+#include "shell/script/quickjspp.hpp"
+#include "test.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <fstream>
+#include <malloc.h>
+#include <memory>
+#include <string>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi")
+#else
+#include <unistd.h>
+#endif
+
+using mb_shell::js_arena;
+
+namespace {
+// Built like script_context does: the runtime owns its arena
+std::shared_ptr<qjs::Runtime> make_runtime(std::atomic<bool> &freed) {
+    auto arena = std::make_shared<js_arena>();
+    return std::shared_ptr<qjs::Runtime>(
+        new qjs::Runtime(&js_arena::functions, arena.get()),
+        [arena, &freed](qjs::Runtime *runtime) {
+            delete runtime;
+            freed = true;
+        });
+}
+
+// QuickJS's default allocator, counted the way js_arena counts
+struct counting_malloc {
+    int64_t allocations = 0, bytes_in_use = 0, peak_bytes = 0;
+
+    static size_t usable_size(const void *ptr) {
+#ifdef _WIN32
+        return ptr ? _msize(const_cast<void *>(ptr)) : 0;
+#else
+        return malloc_usable_size(const_cast<void *>(ptr));
+#endif
+    }
+    void on_allocated(void *ptr) {
+        if (!ptr)
+            return;
+        allocations++;
+        bytes_in_use += usable_size(ptr);
+        peak_bytes = std::max(peak_bytes, bytes_in_use);
+    }
+
+    static const JSMallocFunctions functions;
+};
+
+const JSMallocFunctions counting_malloc::functions = {
+    .js_calloc = [](void *opaque, size_t count, size_t size) -> void * {
+        auto ptr = std::calloc(count, size);
+        static_cast<counting_malloc *>(opaque)->on_allocated(ptr);
+        return ptr;
+    },
+    .js_malloc = [](void *opaque, size_t size) -> void * {
+        auto ptr = std::malloc(size);
+        static_cast<counting_malloc *>(opaque)->on_allocated(ptr);
+        return ptr;
+    },
+    .js_free = [](void *opaque, void *ptr) {
+        static_cast<counting_malloc *>(opaque)->bytes_in_use -=
+            usable_size(ptr);
+        std::free(ptr);
+    },
+    .js_realloc = [](void *opaque, void *ptr, size_t size) -> void * {
+        auto self = static_cast<counting_malloc *>(opaque);
+        auto old_size = usable_size(ptr);
+        auto resized = std::realloc(ptr, size);
+        if (resized || !size) {
+            self->bytes_in_use -= old_size;
+            self->on_allocated(resized);
+        }
+        return resized;
+    },
+    .js_malloc_usable_size = usable_size,
+};
+
+size_t resident_bytes() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters{};
+    GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+    return counters.WorkingSetSize;
+#else
+    size_t pages = 0, resident = 0;
+    std::ifstream("/proc/self/statm") >> pages >> resident;
+    return resident * sysconf(_SC_PAGESIZE);
+#endif
+}
+} // namespace
+
+TEST_CASE(js_context, keeps_runtime_alive) {
+    std::atomic<bool> freed = false;
+    auto rt = make_runtime(freed);
+    auto ctx = std::make_shared<qjs::Context>(rt);
+    rt.reset();
+    CHECK(!freed);
+
+    ctx->eval("globalThis.items = [1, 2, 3].map(v => ({ v, s: 'x' + v }))");
+    CHECK_EQ(ctx->eval("items[2].s").as<std::string>(), "x3");
+    ctx.reset();
+    CHECK(freed);
+}
+
+// A reload lets go of the runtime on the JS thread while another thread may
+// still hold the context, e.g. a menu thread waiting on a listener
+TEST_CASE(js_context, last_reference_on_another_thread) {
+    std::atomic<bool> freed = false;
+    auto rt = make_runtime(freed);
+    auto ctx = std::make_shared<qjs::Context>(rt);
+    ctx->eval("globalThis.big = new Array(10000).fill(0).map((_, i) => "
+              "({ i }))");
+    ctx->enqueueJob([] {});
+
+    std::atomic<bool> dropped = false;
+    std::thread holder([ctx, &dropped]() mutable {
+        while (!dropped)
+            std::this_thread::yield();
+        ctx.reset();
+    });
+    ctx.reset();
+    rt.reset();
+    CHECK(!freed);
+
+    dropped = true;
+    holder.join();
+    CHECK(freed);
+}
+
+// Values released from native callbacks are freed off the JS thread
+TEST_CASE(js_context, arena_counts_frees_from_other_threads) {
+    js_arena arena;
+    auto &functions = js_arena::functions;
+    auto small = functions.js_malloc(&arena, 100);
+    auto large = functions.js_malloc(&arena, 100000);
+    auto stats = arena.statistics();
+    CHECK_EQ(stats.allocations, 2);
+    CHECK_EQ(stats.live_allocations, 2);
+    CHECK(stats.bytes_in_use >= 100100);
+    CHECK_EQ(stats.peak_bytes, stats.bytes_in_use);
+
+    std::thread([&] {
+        functions.js_free(&arena, small);
+        functions.js_free(&arena, large);
+        auto remote = functions.js_malloc(&arena, 100);
+        functions.js_free(&arena, remote);
+    }).join();
+    stats = arena.statistics();
+    CHECK_EQ(stats.allocations, 3);
+    CHECK_EQ(stats.live_allocations, 0);
+    CHECK_EQ(stats.bytes_in_use, 0);
+    // Only the pool chunk is left
+    CHECK_EQ(stats.reserved_bytes, 64 * 1024);
+
+    // The freed pool block is reused
+    CHECK(functions.js_malloc(&arena, 100) == small);
+}
+
+// 30 plugins of about 11 KB are loaded, each adding a menu listener, then a
+// menu of 10k items is opened 10 times: the items are built in JS and every
+// listener filters them. Runs on an arena first, then on the system
+// allocator, each in a fresh runtime.
+BENCHMARK(js_context, arena_versus_malloc) {
+    constexpr int plugins = 30, handlers = 30, items = 10000, opens = 10;
+    std::vector<std::string> sources;
+    for (int p = 0; p < plugins; p++) {
+        std::string source;
+        for (int h = 0; h < handlers; h++)
+            source += std::format(
+                "function on_menu_{0}(menu, out) {{\n"
+                "    const items = menu.items.filter(i => i.name?.includes("
+                "'{0}'));\n"
+                "    for (const [i, item] of items.entries()) {{\n"
+                "        if (item.disabled || i % 3 === 2) continue;\n"
+                "        out.push({{ id: {0}, name: `${{item.name}} (${{i}})`,"
+                "\n"
+                "            action: () => item.name.split(' ')"
+                ".map(s => s.trim()).join('-') }});\n"
+                "    }}\n"
+                "    return items.slice(0, {1});\n"
+                "}}\n",
+                h, h % 7 + 1);
+        source += std::format(
+            "listeners.push(menu => on_menu_{}(menu, menu.out));\n",
+            p % handlers);
+        sources.push_back(std::move(source));
+    }
+
+    auto run = [&](const char *label, const JSMallocFunctions *functions,
+                   void *opaque, auto statistics) {
+        using clock = std::chrono::steady_clock;
+        auto ms = [](clock::duration d) {
+            return std::chrono::duration<double, std::milli>(d).count();
+        };
+        auto rss_before = resident_bytes();
+        auto rt = std::make_shared<qjs::Runtime>(functions, opaque);
+        auto ctx = std::make_shared<qjs::Context>(rt);
+        ctx->eval("globalThis.listeners = [];\n"
+                  "globalThis.open_menu = count => {\n"
+                  "    const menu = { out: [], items: Array.from("
+                  "{ length: count }, (_, i) =>\n"
+                  "        ({ name: `Item ${i}`, disabled: i % 5 === 0 })) };\n"
+                  "    for (const listener of listeners) listener(menu);\n"
+                  "    return menu.out.length;\n"
+                  "};\n");
+
+        auto start = clock::now();
+        for (int p = 0; p < plugins; p++)
+            ctx->eval(sources[p], std::format("plugin{}.js", p).c_str(),
+                      JS_EVAL_TYPE_MODULE);
+        auto loaded = clock::now();
+        auto [load_allocations, ignored] = statistics();
+        for (int i = 0; i < opens; i++)
+            CHECK(ctx->eval(std::format("open_menu({})", items)).as<int>() >
+                  0);
+        auto done = clock::now();
+        auto [allocations, peak_bytes] = statistics();
+        auto rss = resident_bytes();
+
+        auto report = [&](const char *what, double value, const char *unit) {
+            mb_shell::test::report(std::format("{}: {}", label, what), value,
+                                   unit);
+        };
+        report("plugin load", ms(loaded - start), "ms");
+        report("plugin load allocations", load_allocations, "allocs");
+        report("10 menus of 10k items", ms(done - loaded), "ms");
+        report("menu allocations", allocations - load_allocations, "allocs");
+        report("peak bytes in use", peak_bytes / 1048576.0, "MB");
+        report("RSS growth", (double(rss) - double(rss_before)) / 1048576.0,
+               "MB");
+    };
+
+    {
+        js_arena arena;
+        run("arena", &js_arena::functions, &arena, [&] {
+            auto stats = arena.statistics();
+            return std::pair(stats.allocations, stats.peak_bytes);
+        });
+    }
+    counting_malloc counter;
+    run("malloc", &counting_malloc::functions, &counter, [&] {
+        return std::pair(counter.allocations, counter.peak_bytes);
+    });
+}
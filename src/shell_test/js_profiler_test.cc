@@ -0,0 +1,156 @@
+#include "shell/script/js_profiler.h"
+#include "shell/script/plugin_modules.h"
+#include "shell/script/quickjspp.hpp"
+#include "test.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using mb_shell::js_profiler;
+using mb_shell::plugin_modules;
+
+namespace {
+// A scripts folder with a context whose interrupt handler feeds the
+// profiler, as script_context sets up its runtime
+struct profiled_folder {
+    std::filesystem::path directory =
+        std::filesystem::temp_directory_path() /
+        std::format("shell_test_profiler_{}", std::random_device{}());
+    qjs::Runtime rt;
+    std::shared_ptr<qjs::Context> ctx;
+
+    explicit profiled_folder(bool handler = true) {
+        // Host callbacks into the plugins run on the JS thread
+        is_thread_js_main = true;
+        std::filesystem::create_directories(directory);
+        if (handler)
+            JS_SetInterruptHandler(
+                rt.rt,
+                [](JSRuntime *rt, void *) {
+                    js_profiler::on_interrupt(rt);
+                    return 0;
+                },
+                nullptr);
+        plugin_modules::reset(directory);
+        ctx = std::make_shared<qjs::Context>(rt);
+        ctx->moduleNormalizer = plugin_modules::normalize;
+    }
+
+    ~profiled_folder() {
+        js_profiler::set_enabled(false);
+        ctx.reset();
+        is_thread_js_main = false;
+        std::error_code ec;
+        std::filesystem::remove_all(directory, ec);
+    }
+
+    // Evaluates a plugin under its full path, like load_plugin
+    void load(const std::string &name, const std::string &source) {
+        ctx->eval(source, (directory / name).generic_string().c_str(),
+                  JS_EVAL_TYPE_MODULE);
+    }
+
+    std::vector<std::string> export_lines() {
+        std::ifstream file(js_profiler::export_collapsed(directory / "out"));
+        std::vector<std::string> lines;
+        for (std::string line; std::getline(file, line);)
+            lines.push_back(line);
+        return lines;
+    }
+};
+
+// Keeps JS busy for about `ms` milliseconds
+constexpr auto busy_plugin = "function spin(ms) {\n"
+                             "    const end = Date.now() + ms;\n"
+                             "    let n = 0;\n"
+                             "    while (Date.now() < end) n++;\n"
+                             "    return n;\n"
+                             "}\n"
+                             "globalThis.work = ms => spin(ms);\n";
+} // namespace
+
+TEST_CASE(js_profiler, samples_belong_to_the_plugin) {
+    profiled_folder folder;
+    folder.load("busy.js", busy_plugin);
+    js_profiler::set_enabled(true);
+    // Called by the host, like a menu listener
+    folder.ctx->global()["work"].as<std::function<void(int)>>()(50);
+    js_profiler::set_enabled(false);
+
+    auto lines = folder.export_lines();
+    CHECK(!lines.empty());
+    uint64_t total = 0;
+    for (auto &line : lines) {
+        CHECK(line.starts_with("busy.js;"));
+        CHECK(line.find("spin (busy.js)") != std::string::npos);
+        total += std::stoull(line.substr(line.rfind(' ') + 1));
+    }
+    // 1 ms interval; the interrupt handler runs often enough to hit most
+    CHECK(total >= 10 && total <= 60);
+}
+
+TEST_CASE(js_profiler, disabled_takes_no_samples) {
+    profiled_folder folder;
+    folder.load("busy.js", busy_plugin);
+    js_profiler::set_enabled(true);
+    folder.ctx->eval("work(20)");
+    CHECK(!folder.export_lines().empty());
+
+    // Enabling again starts a new profile
+    js_profiler::set_enabled(false);
+    js_profiler::set_enabled(true);
+    js_profiler::set_enabled(false);
+    folder.ctx->eval("work(20)");
+    CHECK(folder.export_lines().empty());
+}
+
+// A CPU-bound listener filtering 200k items, with no interrupt handler,
+// with the handler installed and the profiler off (the default), and
+// profiling
+BENCHMARK(js_profiler, overhead) {
+    constexpr int rounds = 30;
+    auto workload = "const items = Array.from({ length: 200000 }, (_, i) =>\n"
+                    "    ({ name: `Item ${i}`, disabled: i % 5 === 0 }));\n"
+                    "function on_menu(items) {\n"
+                    "    return items.filter(i => !i.disabled && "
+                    "i.name.includes('7'))\n"
+                    "        .map(i => i.name.toUpperCase()).length;\n"
+                    "}\n"
+                    "globalThis.run = () => on_menu(items);\n";
+
+    auto run = [&](bool handler, bool profiling) {
+        profiled_folder folder(handler);
+        folder.load("listener.js", workload);
+        auto listener = folder.ctx->global()["run"].as<std::function<int()>>();
+        js_profiler::set_enabled(profiling);
+        // The fastest round, the one least disturbed by the rest of the
+        // system
+        double best = 1e9;
+        for (int r = 0; r < rounds; r++) {
+            auto start = std::chrono::steady_clock::now();
+            CHECK(listener() > 0);
+            best = std::min(best, std::chrono::duration<double, std::milli>(
+                                      std::chrono::steady_clock::now() - start)
+                                      .count());
+        }
+        return best;
+    };
+
+    // The first runtime also pays for growing the process heap
+    run(false, false);
+    auto baseline = run(false, false);
+    auto off = run(true, false);
+    auto on = run(true, true);
+    mb_shell::test::report("no interrupt handler", baseline, "ms");
+    mb_shell::test::report("profiler off", off, "ms");
+    mb_shell::test::report("profiler on", on, "ms");
+    mb_shell::test::report("overhead, off", (off / baseline - 1) * 100, "%");
+    mb_shell::test::report("overhead, on", (on / baseline - 1) * 100, "%");
+}
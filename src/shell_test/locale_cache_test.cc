@@ -0,0 +1,173 @@
+#include "shell/locale_cache.h"
+#include "test.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using mb_shell::locale_cache;
+
+namespace {
+// A locales directory with its image cache, like <data_directory>/locales
+struct locales_folder {
+    std::filesystem::path directory =
+        std::filesystem::temp_directory_path() /
+        std::format("shell_test_locales_{}", std::random_device{}());
+    std::filesystem::path cache = directory / ".cache";
+
+    locales_folder() { std::filesystem::create_directories(directory); }
+    ~locales_folder() {
+        std::error_code ec;
+        std::filesystem::remove_all(directory, ec);
+    }
+
+    std::filesystem::path write(const std::string &name,
+                                const std::string &json) {
+        auto path = directory / name;
+        std::filesystem::create_directories(path.parent_path());
+        std::ofstream(path, std::ios::binary | std::ios::trunc) << json;
+        return path;
+    }
+
+    size_t images() const {
+        if (!std::filesystem::exists(cache))
+            return 0;
+        auto files = std::filesystem::directory_iterator(cache);
+        return std::distance(begin(files), end(files));
+    }
+};
+
+std::string value_of(const locale_cache::locale_data &data,
+                     const std::string &key) {
+    for (auto &[k, v] : data.translations)
+        if (k == key)
+            return v;
+    return "";
+}
+} // namespace
+
+TEST_CASE(locale_cache, parses_then_reads_the_image) {
+    locales_folder folder;
+    auto json = [](const char *a) {
+        return std::format(R"({{"$metadata": {{"direction": "rtl"}}, )"
+                           R"("a": "{}", "b": "B {{x}}"}})",
+                           a);
+    };
+    auto path = folder.write("ar.json", json("A"));
+    auto data = locale_cache::load(path, folder.cache);
+    CHECK(data && data->direction == "rtl");
+    CHECK_EQ(data->translations.size(), 2u);
+    CHECK_EQ(value_of(*data, "b"), "B {x}");
+    CHECK_EQ(folder.images(), 1u);
+
+    // Same size and mtime: the image is trusted without reading the source
+    auto mtime = std::filesystem::last_write_time(path);
+    folder.write("ar.json", json("Z"));
+    std::filesystem::last_write_time(path, mtime);
+    CHECK_EQ(value_of(*locale_cache::load(path, folder.cache), "a"), "A");
+}
+
+TEST_CASE(locale_cache, edited_file_is_parsed_again) {
+    locales_folder folder;
+    auto path = folder.write("en-US.json", R"({"a": "A"})");
+    CHECK_EQ(value_of(*locale_cache::load(path, folder.cache), "a"), "A");
+    std::filesystem::last_write_time(
+        path, std::filesystem::last_write_time(path) - std::chrono::hours(1));
+    folder.write("en-US.json", R"({"a": "New A", "c": "C"})");
+    auto data = locale_cache::load(path, folder.cache);
+    CHECK(data && !data->direction);
+    CHECK_EQ(value_of(*data, "a"), "New A");
+    CHECK_EQ(value_of(*data, "c"), "C");
+    CHECK_EQ(folder.images(), 1u);
+}
+
+TEST_CASE(locale_cache, broken_file_is_rejected) {
+    locales_folder folder;
+    CHECK(!locale_cache::load(folder.directory / "missing.json", folder.cache));
+    auto path = folder.write("en-US.json", R"({"a": )");
+    CHECK(!locale_cache::load(path, folder.cache));
+    CHECK_EQ(folder.images(), 0u);
+}
+
+TEST_CASE(locale_cache, prune_drops_images_of_deleted_files) {
+    locales_folder folder;
+    auto kept = folder.write("plugins/a/en-US.json", R"({"a.x": "X"})");
+    auto deleted = folder.write("plugins/b/en-US.json", R"({"b.x": "X"})");
+    locale_cache::load(kept, folder.cache);
+    locale_cache::load(deleted, folder.cache);
+    CHECK_EQ(folder.images(), 2u);
+
+    std::filesystem::remove(deleted);
+    locale_cache::prune({kept}, folder.cache);
+    CHECK_EQ(folder.images(), 1u);
+    CHECK(locale_cache::load(kept, folder.cache));
+}
+
+// 200 plugins with 100 keys each, read serially and fanned out across
+// threads the way i18n_manager::read_plugin_locales does
+BENCHMARK(locale_cache, plugin_locales) {
+    constexpr int plugins = 200, keys = 100;
+    locales_folder folder;
+    std::vector<std::filesystem::path> files;
+    for (int p = 0; p < plugins; p++) {
+        std::string json = R"({"$metadata": {"direction": "ltr"})";
+        for (int k = 0; k < keys; k++)
+            json += std::format(
+                R"(, "plugin{}.menu.item_{}": "Item {} of {{name}}")", p, k,
+                k);
+        json += "}";
+        files.push_back(
+            folder.write(std::format("plugins/plugin{}/en-US.json", p), json));
+    }
+
+    auto load_all = [&](bool parallel) {
+        std::atomic<size_t> next = 0, loaded = 0;
+        auto worker = [&] {
+            for (size_t i; (i = next++) < files.size();)
+                loaded +=
+                    locale_cache::load(files[i], folder.cache).has_value();
+        };
+        std::vector<std::jthread> threads;
+        if (parallel)
+            for (unsigned t = 1; t < std::thread::hardware_concurrency(); t++)
+                threads.emplace_back(worker);
+        worker();
+        threads.clear();
+        return loaded.load();
+    };
+    auto time = [&](const char *label, bool parallel, bool cold) {
+        if (cold)
+            std::filesystem::remove_all(folder.cache);
+        auto start = std::chrono::steady_clock::now();
+        CHECK_EQ(load_all(parallel), size_t(plugins));
+        mb_shell::test::report(label,
+                               std::chrono::duration<double, std::milli>(
+                                   std::chrono::steady_clock::now() - start)
+                                   .count(),
+                               "ms");
+    };
+
+    time("200 files, serial, cold cache", false, true);
+    time("200 files, parallel, cold cache", true, true);
+    time("200 files, serial, warm cache", false, false);
+    time("200 files, parallel, warm cache", true, false);
+
+    // What reload_plugin_locale reads when one file changes
+    std::filesystem::last_write_time(
+        files[0],
+        std::filesystem::last_write_time(files[0]) - std::chrono::hours(1));
+    auto start = std::chrono::steady_clock::now();
+    CHECK(locale_cache::load(files[0], folder.cache));
+    mb_shell::test::report("1 changed file, incremental",
+                           std::chrono::duration<double, std::milli>(
+                               std::chrono::steady_clock::now() - start)
+                               .count(),
+                           "ms");
+}
@@ -0,0 +1,145 @@
+#include "shell/log_sink.h"
+#include "test.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+using mb_shell::log_sink;
+
+namespace {
+struct log_folder {
+    std::filesystem::path directory =
+        std::filesystem::temp_directory_path() /
+        std::format("shell_test_log_{}", std::random_device{}());
+    std::filesystem::path path = directory / "debug.log";
+
+    log_folder() { std::filesystem::create_directories(directory); }
+    ~log_folder() {
+        std::error_code ec;
+        std::filesystem::remove_all(directory, ec);
+    }
+
+    // The writer thread is detached, so test sinks are never destroyed
+    log_sink &make_sink(std::uintmax_t max_size = 1 << 30) {
+        return *new log_sink(path, max_size, false);
+    }
+
+    std::vector<std::string> lines() const {
+        std::ifstream file(path);
+        std::vector<std::string> lines;
+        for (std::string line; std::getline(file, line);)
+            lines.push_back(line);
+        return lines;
+    }
+};
+} // namespace
+
+TEST_CASE(log_sink, lines_from_many_threads_keep_their_order) {
+    constexpr int threads = 4, per_thread = 2000;
+    log_folder folder;
+    auto &sink = folder.make_sink();
+    std::vector<std::thread> loggers;
+    for (int t = 0; t < threads; t++)
+        loggers.emplace_back([&, t] {
+            for (int i = 0; i < per_thread; i++)
+                sink.push(std::format("{} {}\n", t, i));
+        });
+    for (auto &logger : loggers)
+        logger.join();
+    CHECK(sink.flush(5s));
+
+    auto lines = folder.lines();
+    CHECK_EQ(lines.size(), size_t(threads * per_thread));
+    std::vector<int> next(threads, 0);
+    for (auto &line : lines) {
+        int t, i;
+        std::istringstream(line) >> t >> i;
+        CHECK_EQ(i, next[t]++);
+    }
+}
+
+TEST_CASE(log_sink, appends_to_an_existing_log) {
+    log_folder folder;
+    std::ofstream(folder.path) << "earlier\n";
+    auto &sink = folder.make_sink();
+    sink.push("later\n");
+    CHECK(sink.flush(5s));
+    CHECK(folder.lines() == std::vector<std::string>({"earlier", "later"}));
+}
+
+TEST_CASE(log_sink, rotates_past_max_size) {
+    log_folder folder;
+    auto &sink = folder.make_sink(1000);
+    for (int i = 0; i < 100; i++) {
+        sink.push(std::string(49, 'x') + "\n");
+        if (i % 10 == 9)
+            CHECK(sink.flush(5s));
+    }
+    CHECK(std::filesystem::exists(folder.path.string() + ".1"));
+    CHECK(std::filesystem::file_size(folder.path) <= 1000);
+}
+
+// 1M lines from one caller, timing every call, through the sink and through
+// what append_debug_string did before it: a mutex, then write and flush
+BENCHMARK(log_sink, million_lines) {
+    constexpr int lines = 1000000;
+    using clock = std::chrono::steady_clock;
+    log_folder folder;
+
+    auto run = [&](const char *label, auto log, auto drain) {
+        std::vector<float> latencies(lines);
+        auto start = clock::now();
+        for (int i = 0; i < lines; i++) {
+            auto call = clock::now();
+            log(std::format("[renderer] frame {} took {} us\n", i, i % 977));
+            latencies[i] =
+                std::chrono::duration<float, std::nano>(clock::now() - call)
+                    .count();
+        }
+        auto returned = clock::now();
+        drain();
+        auto written = clock::now();
+
+        std::ranges::sort(latencies);
+        double mean = std::chrono::duration<double, std::nano>(returned - start)
+                          .count() /
+                      lines;
+        mb_shell::test::report(std::format("{}: caller mean", label), mean,
+                               "ns/line");
+        mb_shell::test::report(std::format("{}: caller p99", label),
+                               latencies[lines * 99 / 100], "ns/line");
+        mb_shell::test::report(std::format("{}: caller max", label),
+                               latencies.back(), "ns/line");
+        mb_shell::test::report(
+            std::format("{}: all written", label),
+            lines / std::chrono::duration<double>(written - start).count(),
+            "lines/s");
+    };
+
+    auto &sink = folder.make_sink();
+    run("log_sink", [&](std::string line) { sink.push(std::move(line)); },
+        [&] { CHECK(sink.flush(60s)); });
+    CHECK_EQ(folder.lines().size(), size_t(lines));
+
+    std::filesystem::remove(folder.path);
+    std::mutex mutex;
+    std::ofstream file(folder.path, std::ios::app);
+    run(
+        "mutex and flush per line",
+        [&](std::string line) {
+            std::lock_guard lock(mutex);
+            file << line;
+            file.flush();
+        },
+        [] {});
+}
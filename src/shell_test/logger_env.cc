@@ -0,0 +1,7 @@
+#include "shell/logger.h"
+
+// Defined by logger.cc in the shell, which writes debug.log under the data
+// directory; tests have no use for debug output
+namespace mb_shell {
+void append_debug_string(std::string) {}
+} // namespace mb_shell
@@ -0,0 +1,65 @@
+#include "test.h"
+#include <exception>
+#include <iostream>
+#include <print>
+#include <string>
+#include <vector>
+
+namespace mb_shell::test {
+namespace {
+struct test_case {
+    std::string suite;
+    std::string name;
+    void (*fn)();
+    bool benchmark;
+};
+
+// Filled by static registrars before main runs
+std::vector<test_case> &registry() {
+    static std::vector<test_case> cases;
+    return cases;
+}
+} // namespace
+
+registrar::registrar(std::string_view suite, std::string_view name,
+                     void (*fn)(), bool benchmark) {
+    registry().push_back(
+        {std::string(suite), std::string(name), fn, benchmark});
+}
+
+void report(std::string_view label, double value, std::string_view unit) {
+    std::println("  {:<52} {:>12.1f} {}", label, value, unit);
+}
+} // namespace mb_shell::test
+
+int main(int argc, char **argv) {
+    std::vector<std::string_view> args(argv + 1, argv + argc);
+    bool bench = !args.empty() && args[0] == "bench";
+    if (bench)
+        args.erase(args.begin());
+    std::string_view suite = args.empty() ? "" : args[0];
+
+    int passed = 0, failed = 0;
+    for (auto &test : mb_shell::test::registry()) {
+        if (test.benchmark != bench ||
+            (!suite.empty() && test.suite != suite))
+            continue;
+        if (bench)
+            std::println("{}.{}", test.suite, test.name);
+        try {
+            test.fn();
+            passed++;
+        } catch (std::exception &e) {
+            std::cerr << test.suite << "." << test.name << ": " << e.what()
+                      << std::endl;
+            failed++;
+        }
+    }
+
+    if (!passed && !failed) {
+        std::cerr << "No tests in suite " << suite << std::endl;
+        return 1;
+    }
+    std::println("{} passed, {} failed", passed, failed);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,177 @@
+#include "shell/script/menu_listener_watchdog.h"
+#include "shell/script/quickjspp.hpp"
+#include "test.h"
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace std::chrono_literals;
+using mb_shell::menu_listener_watchdog;
+
+namespace {
+constexpr auto plugins = R"(
+    globalThis.log = [];
+    globalThis.fast = () => log.push('fast');
+    globalThis.stuck = () => {
+        try { while (true) {} } catch (e) { log.push('caught'); }
+    };
+    globalThis.slow = () => {
+        const end = Date.now() + 300;
+        while (Date.now() < end) {}
+        log.push('slow');
+    };
+)";
+
+// A JS thread set up like script_context::watch_folder's, with plugins that
+// register a fast, a stuck and a slow menu listener
+struct js_thread {
+    std::shared_ptr<qjs::Runtime> rt = std::make_shared<qjs::Runtime>();
+    std::shared_ptr<qjs::Context> ctx;
+    std::thread thread;
+
+    js_thread() {
+        JS_SetInterruptHandler(
+            rt->rt,
+            [](JSRuntime *, void *) {
+                return menu_listener_watchdog::on_interrupt() ? 1 : 0;
+            },
+            nullptr);
+        ctx = std::make_shared<qjs::Context>(rt);
+        ctx->eval(plugins);
+        thread = std::thread([ctx = ctx] {
+            is_thread_js_main = true;
+            JS_UpdateStackTop(JS_GetRuntime(ctx->ctx));
+            ctx->runEventLoop();
+        });
+    }
+
+    ~js_thread() {
+        if (ctx)
+            ctx->stopEventLoop();
+        thread.join();
+    }
+
+    // Runs `job` on the JS thread after everything queued so far
+    template <typename F> void call(F &&job) {
+        qjs::msgloop_waiter waiter;
+        qjs::waiter_signal done(&waiter);
+        ctx->enqueueJob([&, done = std::move(done)]() mutable {
+            job();
+            done.reset();
+        });
+        waiter.wait();
+    }
+
+    std::string log() {
+        std::string log;
+        call([&] { log = ctx->eval("log.join()").as<std::string>(); });
+        return log;
+    }
+
+    // Runs each plugin's listener like menu_render::create, from a menu
+    // thread, and returns how long the menu waited for them in ms
+    double show_menu(const std::string &prefix,
+                     menu_listener_watchdog::budget limit) {
+        auto start = std::chrono::steady_clock::now();
+        for (auto name : {"fast", "stuck", "slow"}) {
+            menu_listener_watchdog::run(
+                prefix + name + ".js", ctx, limit,
+                [ctx = ctx.get(), name = std::string(name)] {
+                    ctx->eval(name + "()");
+                });
+        }
+        return std::chrono::duration<double, std::milli>(
+                   std::chrono::steady_clock::now() - start)
+            .count();
+    }
+};
+
+menu_listener_watchdog::plugin_stats stats_of(const std::string &plugin) {
+    for (auto &s : menu_listener_watchdog::statistics())
+        if (s.plugin == plugin)
+            return s;
+    throw mb_shell::test::failure("no statistics for " + plugin);
+}
+} // namespace
+
+TEST_CASE(menu_listener_watchdog, slow_plugins_are_aborted_then_deferred) {
+    js_thread js;
+    auto waited = js.show_menu("defer/", {100, true});
+    // Two listeners aborted at their 100 ms budget
+    CHECK(waited >= 200 && waited < 1000);
+    // Aborting is uncatchable, so the stuck listener's catch never ran
+    CHECK_EQ(js.log(), "fast");
+    CHECK_EQ(stats_of("defer/stuck.js").overruns, 1);
+    CHECK(stats_of("defer/stuck.js").deferred);
+    CHECK(stats_of("defer/slow.js").deferred);
+    CHECK(!stats_of("defer/fast.js").deferred);
+
+    // Only the fast listener holds up the next menu; the others run after
+    // it with 10x the budget, where the slow one finishes
+    waited = js.show_menu("defer/", {100, true});
+    CHECK(waited < 100);
+    CHECK_EQ(js.log(), "fast,fast,slow");
+    CHECK_EQ(stats_of("defer/stuck.js").overruns, 2);
+    CHECK_EQ(stats_of("defer/slow.js").runs, 2);
+    CHECK_EQ(stats_of("defer/slow.js").overruns, 1);
+
+    // A reloaded plugin runs under the budget again
+    menu_listener_watchdog::reinstate("defer/slow.js");
+    waited = js.show_menu("defer/", {100, true});
+    CHECK(waited >= 100);
+    CHECK_EQ(stats_of("defer/slow.js").overruns, 2);
+}
+
+TEST_CASE(menu_listener_watchdog, without_deferral_listeners_stay_budgeted) {
+    js_thread js;
+    js.show_menu("budget/", {100, false});
+    auto waited = js.show_menu("budget/", {100, false});
+    CHECK(waited >= 200);
+    CHECK_EQ(js.log(), "fast,fast");
+    CHECK_EQ(stats_of("budget/stuck.js").overruns, 2);
+    CHECK(!stats_of("budget/stuck.js").deferred);
+}
+
+TEST_CASE(menu_listener_watchdog, no_budget_runs_to_completion) {
+    js_thread js;
+    js.call([&] {
+        js.ctx->eval("globalThis.stuck = () => log.push('stuck')");
+    });
+    auto waited = js.show_menu("unlimited/", {});
+    // Date.now() is in whole ms
+    CHECK(waited >= 299);
+    CHECK_EQ(js.log(), "fast,stuck,slow");
+    CHECK_EQ(stats_of("unlimited/slow.js").overruns, 0);
+    CHECK(stats_of("unlimited/slow.js").max_ms >= 299);
+}
+
+// A reload drops the listener job still queued behind a busy JS thread; the
+// menu thread waiting on it must be released
+TEST_CASE(menu_listener_watchdog, dropped_context_releases_the_menu) {
+    js_thread js;
+    std::promise<void> release;
+    js.ctx->enqueueJob([busy = release.get_future().share()] { busy.wait(); });
+
+    std::promise<void> menu_done;
+    std::thread menu([&, ctx = std::weak_ptr(js.ctx)] {
+        menu_listener_watchdog::run("dropped/plugin.js", ctx, {100, false},
+                                    [] {});
+        menu_done.set_value();
+    });
+    std::this_thread::sleep_for(100ms);
+    js.ctx->stopEventLoop();
+    js.ctx.reset();
+    release.set_value();
+
+    auto released =
+        menu_done.get_future().wait_for(5s) == std::future_status::ready;
+    menu.join();
+    CHECK(released);
+    for (auto &s : menu_listener_watchdog::statistics())
+        CHECK(s.plugin != "dropped/plugin.js");
+}
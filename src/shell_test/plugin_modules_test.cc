@@ -0,0 +1,203 @@
+#include "shell/script/plugin_modules.h"
+#include "shell/script/quickjspp.hpp"
+#include "test.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using mb_shell::plugin_modules;
+
+namespace {
+// A scripts folder with a live context loading from it, set up like
+// script_context::watch_folder does
+struct plugin_folder {
+    std::filesystem::path directory =
+        std::filesystem::temp_directory_path() /
+        std::format("shell_test_plugins_{}", std::random_device{}());
+    qjs::Runtime rt;
+    std::shared_ptr<qjs::Context> ctx;
+    // Tags of the registrations disposed so far
+    std::vector<std::string> disposed;
+
+    plugin_folder() {
+        // Host callbacks into the plugins run on the JS thread
+        is_thread_js_main = true;
+        std::filesystem::create_directories(directory);
+        restart();
+    }
+
+    // A fresh context with nothing loaded, like reload_all
+    void restart() {
+        ctx.reset();
+        plugin_modules::reset(directory);
+        ctx = std::make_shared<qjs::Context>(rt);
+        ctx->moduleNormalizer = plugin_modules::normalize;
+        ctx->moduleLoader = [](std::string_view module_name) {
+            std::ifstream file(plugin_modules::file_of(module_name));
+            std::string script((std::istreambuf_iterator<char>(file)),
+                               std::istreambuf_iterator<char>());
+            return qjs::Context::ModuleData{
+                std::string(plugin_modules::unversioned(module_name)),
+                script};
+        };
+        // Stands in for a host API that creates a resource, like setTimeout
+        ctx->global()["acquire"] = std::function([this](std::string tag) {
+            plugin_modules::on_unload(ctx->ctx, [this, tag] {
+                disposed.push_back(tag);
+            });
+        });
+        ctx->global()["caller"] = std::function([this] {
+            return plugin_modules::caller(ctx->ctx).filename().string();
+        });
+    }
+
+    ~plugin_folder() {
+        ctx.reset();
+        is_thread_js_main = false;
+        std::error_code ec;
+        std::filesystem::remove_all(directory, ec);
+    }
+
+    std::filesystem::path write(const std::string &name,
+                                const std::string &source) {
+        auto path = directory / name;
+        std::ofstream(path, std::ios::binary) << source;
+        return path;
+    }
+
+    // Evaluates a plugin under its full path, like load_plugin
+    void load(const std::filesystem::path &path) {
+        std::ifstream file(path);
+        std::string script((std::istreambuf_iterator<char>(file)),
+                           std::istreambuf_iterator<char>());
+        ctx->eval(script, path.generic_string().c_str(), JS_EVAL_TYPE_MODULE);
+    }
+
+    std::vector<std::string> invalidate(const std::filesystem::path &file) {
+        disposed.clear();
+        plugin_modules::invalidate({file});
+        std::ranges::sort(disposed);
+        return disposed;
+    }
+};
+
+using tags = std::vector<std::string>;
+} // namespace
+
+TEST_CASE(plugin_modules, resources_belong_to_the_outermost_plugin) {
+    plugin_folder folder;
+    folder.write("helper.js", "export function make(tag) { acquire(tag); }\n"
+                              "export function who() { return caller(); }\n");
+    auto a = folder.write("a.js", "import { make, who } from './helper';\n"
+                                  "make('a'); globalThis.a_caller = who();\n");
+    auto c = folder.write("c.js", "import { make } from './helper';\n"
+                                  "make('c');\n");
+    folder.load(a);
+    folder.load(c);
+    CHECK_EQ(folder.ctx->eval("a_caller").as<std::string>(), "a.js");
+
+    // Only a's own resource goes, even though helper.js created it
+    CHECK(folder.invalidate(a) == tags{"a"});
+    folder.load(a);
+    // helper.js changing unloads everything importing it
+    CHECK(folder.invalidate(folder.directory / "helper.js") ==
+          (tags{"a", "c"}));
+}
+
+TEST_CASE(plugin_modules, callbacks_belong_to_their_plugin) {
+    plugin_folder folder;
+    folder.write("helper.js", "export function later(fn) { "
+                              "globalThis.pending = fn; }\n");
+    auto a = folder.write("a.js", "import { later } from './helper';\n"
+                                  "later(() => acquire('a'));\n");
+    folder.load(a);
+    // Called by the host with no script frame below, like a timer firing
+    folder.ctx->global()["pending"].as<std::function<void()>>()();
+    CHECK(folder.invalidate(a) == tags{"a"});
+}
+
+TEST_CASE(plugin_modules, no_plugin_on_the_stack) {
+    plugin_folder folder;
+    folder.ctx->eval("acquire('none')", "breeze-script.js");
+    CHECK(folder.invalidate(folder.directory / "a.js").empty());
+    CHECK_EQ(folder.ctx->eval("caller()", "breeze-script.js")
+                 .as<std::string>(),
+             "");
+}
+
+// 30 plugins of about 11 KB each importing a shared helper, each holding 20
+// host resources. A full reload is what reload_all did for any change, minus
+// creating the runtime and running breeze-script.js; the others are what
+// reload_changed does.
+BENCHMARK(plugin_modules, reload_latency) {
+    constexpr int plugins = 30, resources = 20, handlers = 30, rounds = 10;
+    plugin_folder folder;
+    folder.write("helper.js", "export function make(tag) { acquire(tag); }\n"
+                              "export const join = (...s) => s.join('-');\n");
+    std::vector<std::filesystem::path> files;
+    for (int p = 0; p < plugins; p++) {
+        auto source = std::format(
+            "import {{ make, join }} from './helper';\n"
+            "for (let i = 0; i < {}; i++) make(join('p{}', i));\n",
+            resources, p);
+        for (int h = 0; h < handlers; h++)
+            source += std::format(
+                "export function on_menu_{0}(menu, ctx) {{\n"
+                "    const items = menu.items.filter(i => i.name?.includes("
+                "'{0}'));\n"
+                "    for (const [i, item] of items.entries()) {{\n"
+                "        if (item.disabled || i % 3 === 2) continue;\n"
+                "        ctx.push({{ id: {0}, name: join(item.name, i),\n"
+                "            action: () => ctx.run(item.name.split(' ')"
+                ".map(s => s.trim()).join('-')) }});\n"
+                "    }}\n"
+                "    return items.slice(0, {1});\n"
+                "}}\n",
+                h, h % 7 + 1);
+        files.push_back(folder.write(std::format("plugin{}.js", p), source));
+    }
+
+    auto time = [&](const char *label, auto reload) {
+        double total = 0;
+        for (int r = 0; r < rounds; r++) {
+            auto start = std::chrono::steady_clock::now();
+            reload();
+            total += std::chrono::duration<double, std::milli>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+        }
+        mb_shell::test::report(label, total / rounds, "ms");
+    };
+    auto load_all = [&] {
+        for (auto &file : files)
+            folder.load(file);
+    };
+
+    load_all();
+    time("full reload, 30 plugins", [&] {
+        folder.restart();
+        load_all();
+    });
+    time("1 plugin changed", [&] {
+        folder.disposed.clear();
+        auto reloaded = plugin_modules::invalidate({files[7]});
+        CHECK_EQ(reloaded.size(), 1u);
+        CHECK_EQ(folder.disposed.size(), size_t(resources));
+        folder.load(files[7]);
+    });
+    time("shared helper changed, 30 importers", [&] {
+        auto reloaded =
+            plugin_modules::invalidate({folder.directory / "helper.js"});
+        CHECK_EQ(reloaded.size(), size_t(plugins + 1));
+        for (auto &file : files)
+            folder.load(file);
+    });
+}
@@ -0,0 +1,130 @@
+#include "shell/script/quickjspp.hpp"
+#include "test.h"
+
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+// What breeze-qjsc embeds: the module compiled without its source text
+std::vector<uint8_t> compile(qjs::Context &ctx, const std::string &source,
+                             const char *module_name) {
+    auto func = JS_Eval(ctx.ctx, source.c_str(), source.size(), module_name,
+                        JS_EVAL_TYPE_MODULE | JS_EVAL_FLAG_COMPILE_ONLY);
+    if (JS_IsException(func))
+        throw qjs::exception{ctx.ctx};
+    size_t size = 0;
+    auto bytecode =
+        JS_WriteObject(ctx.ctx, &size, func,
+                       JS_WRITE_OBJ_BYTECODE | JS_WRITE_OBJ_STRIP_SOURCE);
+    JS_FreeValue(ctx.ctx, func);
+    std::vector<uint8_t> result(bytecode, bytecode + size);
+    js_free(ctx.ctx, bytecode);
+    return result;
+}
+
+void provide_lib(qjs::Context &ctx) {
+    ctx.moduleLoader = [](std::string_view) {
+        return qjs::Context::ModuleData{"export const base = 41;\n"};
+    };
+}
+
+// Compiling loads imported modules; like breeze-qjsc, stand in for mshell
+// with an empty one
+void stub_imports(qjs::Context &ctx) {
+    ctx.moduleLoader = [](std::string_view) {
+        return qjs::Context::ModuleData{""};
+    };
+}
+} // namespace
+
+TEST_CASE(script_bytecode, evaluates_like_source) {
+    qjs::Runtime rt;
+    std::string source = "import { base } from 'lib';\n"
+                         "globalThis.result = base + 1;\n"
+                         "globalThis.fail = () => { throw new Error('x'); };\n";
+    std::vector<uint8_t> bytecode;
+    {
+        auto ctx = std::make_shared<qjs::Context>(rt);
+        provide_lib(*ctx);
+        bytecode = compile(*ctx, source, "breeze-script.js");
+    }
+
+    auto ctx = std::make_shared<qjs::Context>(rt);
+    provide_lib(*ctx);
+    ctx->evalBinary(bytecode.data(), bytecode.size());
+    CHECK_EQ(ctx->eval("result").as<int>(), 42);
+    // Debug info stays for stack traces
+    CHECK(ctx->eval("try { fail() } catch (e) { e.stack }")
+              .as<std::string>()
+              .find("breeze-script.js:3") != std::string::npos);
+}
+
+TEST_CASE(script_bytecode, unresolved_import_throws) {
+    qjs::Runtime rt;
+    std::vector<uint8_t> bytecode;
+    {
+        auto ctx = std::make_shared<qjs::Context>(rt);
+        provide_lib(*ctx);
+        bytecode = compile(*ctx, "import { missing } from 'lib';\n", "a.js");
+    }
+    auto ctx = std::make_shared<qjs::Context>(rt);
+    provide_lib(*ctx);
+    bool threw = false;
+    try {
+        ctx->evalBinary(bytecode.data(), bytecode.size());
+    } catch (qjs::exception &) {
+        threw = true;
+    }
+    CHECK(threw);
+}
+
+// The embedded breeze-script.js, compiled from source in a new runtime as
+// reload_all used to do, and read from bytecode as it does now. Evaluating
+// it needs the native mshell module, which is the same work either way.
+BENCHMARK(script_bytecode, breeze_script) {
+    constexpr int rounds = 50;
+    std::ifstream file("src/shell/script/script.js", std::ios::binary);
+    CHECK(file.good());
+    std::string source((std::istreambuf_iterator<char>(file)),
+                       std::istreambuf_iterator<char>());
+    mb_shell::test::report("script.js", source.size() / 1024.0, "KB");
+
+    std::vector<uint8_t> bytecode;
+    {
+        qjs::Runtime rt;
+        auto ctx = std::make_shared<qjs::Context>(rt);
+        stub_imports(*ctx);
+        bytecode = compile(*ctx, source, "breeze-script.js");
+    }
+    mb_shell::test::report("bytecode", bytecode.size() / 1024.0, "KB");
+
+    auto run = [&](const char *label, auto load) {
+        double total = 0;
+        for (int r = 0; r < rounds; r++) {
+            auto start = std::chrono::steady_clock::now();
+            qjs::Runtime rt;
+            auto ctx = std::make_shared<qjs::Context>(rt);
+            stub_imports(*ctx);
+            auto func = load(*ctx);
+            total += std::chrono::duration<double, std::milli>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+            CHECK(!JS_IsException(func));
+            JS_FreeValue(ctx->ctx, func);
+        }
+        mb_shell::test::report(label, total / rounds, "ms");
+    };
+    run("new runtime, compile source", [&](qjs::Context &ctx) {
+        return JS_Eval(ctx.ctx, source.c_str(), source.size(),
+                       "breeze-script.js",
+                       JS_EVAL_TYPE_MODULE | JS_EVAL_FLAG_COMPILE_ONLY);
+    });
+    run("new runtime, read bytecode", [&](qjs::Context &ctx) {
+        return JS_ReadObject(ctx.ctx, bytecode.data(), bytecode.size(),
+                             JS_READ_OBJ_BYTECODE);
+    });
+}
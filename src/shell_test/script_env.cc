@@ -0,0 +1,3 @@
+// Defined by script.cc in the shell; quickjspp.hpp checks it to tell the JS
+// thread apart
+thread_local bool is_thread_js_main = false;
@@ -0,0 +1,95 @@
+#include "shell/task_queue.h"
+#include "test.h"
+
+#include <array>
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using mb_shell::task_queue;
+
+TEST_CASE(task_queue, returns_values_and_exceptions) {
+    task_queue queue;
+    CHECK_EQ(queue.add_task([](int a, int b) { return a + b; }, 2, 3).get(),
+             5);
+    // Too large to be stored inline in a ring cell
+    std::array<char, 512> large{};
+    large[511] = 7;
+    CHECK_EQ(queue.add_task([large] { return int(large[511]); }).get(), 7);
+    CHECK_THROWS(
+        queue.add_task([] { throw std::runtime_error("task failed"); }).get(),
+        std::runtime_error);
+}
+
+TEST_CASE(task_queue, worker_pushes_past_a_full_ring) {
+    task_queue queue;
+    // Used to spin forever once the ring was full, since only the worker
+    // itself can free a cell
+    auto futures = queue
+                       .add_task([&] {
+                           std::vector<std::future<int>> futures;
+                           for (int i = 0; i < 1000; i++)
+                               futures.push_back(
+                                   queue.add_task([i] { return i; }));
+                           return futures;
+                       })
+                       .get();
+    for (int i = 0; i < 1000; i++)
+        CHECK_EQ(futures[i].get(), i);
+}
+
+TEST_CASE(task_queue, producers_keep_their_order_behind_a_blocked_worker) {
+    constexpr int producers = 8, tasks = 2000;
+    task_queue queue;
+    std::promise<void> release;
+    queue.add_task([gate = release.get_future().share()] { gate.wait(); });
+
+    // Only the worker touches these
+    std::vector<int> last(producers, -1);
+    bool in_order = true;
+
+    std::vector<std::vector<std::future<void>>> futures(producers);
+    {
+        std::vector<std::jthread> threads;
+        for (int p = 0; p < producers; p++) {
+            threads.emplace_back([&, p] {
+                for (int i = 0; i < tasks; i++) {
+                    futures[p].push_back(queue.add_task([&, p, i] {
+                        in_order = in_order && last[p] == i - 1;
+                        last[p] = i;
+                    }));
+                }
+            });
+        }
+        // Let the ring fill up and spill before the worker drains it
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        release.set_value();
+    }
+
+    for (auto &producer : futures) {
+        for (auto &future : producer)
+            future.get();
+    }
+    CHECK(in_order);
+    for (int p = 0; p < producers; p++)
+        CHECK_EQ(last[p], tasks - 1);
+}
+
+TEST_CASE(task_queue, destruction_runs_or_breaks_pending_tasks) {
+    std::vector<std::future<int>> futures;
+    {
+        task_queue queue;
+        std::promise<void> release;
+        queue.add_task([gate = release.get_future().share()] { gate.wait(); });
+        for (int i = 0; i < 200; i++)
+            futures.push_back(queue.add_task([i] { return i; }));
+        release.set_value();
+    }
+    // Nothing may be left hanging
+    for (auto &future : futures) {
+        CHECK(future.wait_for(std::chrono::seconds(0)) ==
+              std::future_status::ready);
+    }
+}
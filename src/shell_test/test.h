@@ -0,0 +1,83 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <format>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+// Minimal test registry for shell_test. Test files register cases into
+// suites with TEST_CASE; `shell_test <suite>` runs one suite, which is how
+// xmake's add_tests invokes it, and no argument runs every suite.
+//
+// BENCHMARK cases are left out of test runs; `shell_test bench [suite]` runs
+// them instead. Build in release mode before reading their numbers.
+namespace mb_shell::test {
+struct failure : std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+struct registrar {
+    registrar(std::string_view suite, std::string_view name, void (*fn)(),
+              bool benchmark = false);
+};
+
+// Prints one benchmark result line
+void report(std::string_view label, double value, std::string_view unit);
+
+// Calls `fn` `iterations` times and reports the mean time per call in ns
+template <typename F>
+double measure(std::string_view label, size_t iterations, F &&fn) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; i++)
+        fn();
+    double ns = std::chrono::duration<double, std::nano>(
+                    std::chrono::steady_clock::now() - start)
+                    .count() /
+                iterations;
+    report(label, ns, "ns/op");
+    return ns;
+}
+} // namespace mb_shell::test
+
+#define TEST_CASE(suite, name)                                                 \
+    static void suite##_##name();                                              \
+    static mb_shell::test::registrar suite##_##name##_registrar(               \
+        #suite, #name, suite##_##name);                                        \
+    static void suite##_##name()
+
+#define BENCHMARK(suite, name)                                                 \
+    static void suite##_bench_##name();                                        \
+    static mb_shell::test::registrar suite##_bench_##name##_registrar(         \
+        #suite, #name, suite##_bench_##name, true);                            \
+    static void suite##_bench_##name()
+
+#define CHECK(expr)                                                            \
+    do {                                                                       \
+        if (!(expr))                                                           \
+            throw mb_shell::test::failure(                                     \
+                std::format("{}:{}: CHECK({}) failed", __FILE__, __LINE__,     \
+                            #expr));                                           \
+    } while (0)
+
+#define CHECK_EQ(a, b)                                                         \
+    do {                                                                       \
+        if (!((a) == (b)))                                                     \
+            throw mb_shell::test::failure(                                     \
+                std::format("{}:{}: CHECK_EQ({}, {}) failed", __FILE__,        \
+                            __LINE__, #a, #b));                                \
+    } while (0)
+
+#define CHECK_THROWS(expr, exception)                                          \
+    do {                                                                       \
+        bool thrown = false;                                                   \
+        try {                                                                  \
+            (void)(expr);                                                      \
+        } catch (const exception &) {                                          \
+            thrown = true;                                                     \
+        }                                                                      \
+        if (!thrown)                                                           \
+            throw mb_shell::test::failure(                                     \
+                std::format("{}:{}: {} did not throw {}", __FILE__, __LINE__,  \
+                            #expr, #exception));                               \
+    } while (0)
@@ -0,0 +1,136 @@
+#include "shell/script/timer_queue.h"
+#include "test.h"
+
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std::chrono_literals;
+using queue = mb_shell::timer_queue<std::string>;
+
+namespace {
+const queue::clock::time_point start{};
+
+// Names of the timers due at `now`, in the order they fire
+std::vector<std::string> fire(queue &timers, queue::clock::duration now) {
+    std::vector<std::string> fired;
+    timers.pop_due(start + now, [&](auto &t) {
+        fired.push_back(t.value);
+        return true;
+    });
+    return fired;
+}
+
+int add(queue &timers, std::string name, queue::clock::duration at,
+        queue::clock::duration delay, bool repeat = false) {
+    auto id = timers.reserve_id();
+    timers.add(id, std::move(name), start + at, delay, repeat);
+    return id;
+}
+} // namespace
+
+TEST_CASE(timer_queue, fires_by_deadline_then_id) {
+    queue timers;
+    add(timers, "c", 0ms, 30ms);
+    add(timers, "a", 0ms, 10ms);
+    add(timers, "b1", 0ms, 20ms);
+    add(timers, "b2", 5ms, 15ms);
+
+    CHECK(fire(timers, 9ms).empty());
+    CHECK(fire(timers, 10ms) == std::vector<std::string>{"a"});
+    // Same deadline: the one scheduled first fires first
+    CHECK((fire(timers, 25ms) == std::vector<std::string>{"b1", "b2"}));
+    CHECK(fire(timers, 100ms) == std::vector<std::string>{"c"});
+    CHECK_EQ(timers.size(), 0u);
+}
+
+TEST_CASE(timer_queue, reports_earliest_and_next_deadline) {
+    queue timers;
+    CHECK(timers.add(timers.reserve_id(), "late", start, 50ms, false));
+    CHECK(!timers.add(timers.reserve_id(), "later", start, 60ms, false));
+    CHECK(timers.add(timers.reserve_id(), "early", start, 10ms, false));
+
+    auto next = timers.pop_due(start, [](auto &) { return true; });
+    CHECK(next == start + 10ms);
+    CHECK(!queue{}.pop_due(start, [](auto &) { return true; }));
+}
+
+TEST_CASE(timer_queue, cancelled_timers_never_fire) {
+    queue timers;
+    auto a = add(timers, "a", 0ms, 10ms);
+    add(timers, "b", 0ms, 10ms);
+    auto c = add(timers, "c", 0ms, 20ms, true);
+
+    CHECK(timers.remove(a) == "a");
+    CHECK(!timers.remove(a));
+    CHECK(fire(timers, 10ms) == std::vector<std::string>{"b"});
+    CHECK(fire(timers, 20ms) == std::vector<std::string>{"c"});
+    CHECK(timers.remove(c) == "c");
+    CHECK(fire(timers, 1000ms).empty());
+
+    add(timers, "x1", 0ms, 10ms);
+    add(timers, "y", 0ms, 10ms);
+    add(timers, "x2", 0ms, 10ms);
+    timers.remove_if([](auto &name) { return name.starts_with("x"); });
+    CHECK(fire(timers, 2000ms) == std::vector<std::string>{"y"});
+}
+
+TEST_CASE(timer_queue, ids_are_not_reused) {
+    queue timers;
+    auto first = add(timers, "a", 0ms, 10ms);
+    timers.remove(first);
+    auto second = add(timers, "b", 0ms, 10ms);
+    CHECK(second != first);
+    CHECK(!timers.remove(first));
+    CHECK_EQ(timers.size(), 1u);
+}
+
+TEST_CASE(timer_queue, intervals_keep_their_cadence) {
+    queue timers;
+    add(timers, "tick", 0ms, 10ms, true);
+    CHECK(fire(timers, 10ms).size() == 1);
+    // Late by 3 ms: the next tick is still due at 20 ms
+    CHECK(fire(timers, 13ms).empty());
+    CHECK(fire(timers, 19ms).empty());
+    CHECK(fire(timers, 20ms).size() == 1);
+    // Far behind: one tick, then 10 ms from now instead of a burst
+    CHECK(fire(timers, 95ms).size() == 1);
+    CHECK(fire(timers, 104ms).empty());
+    CHECK(fire(timers, 105ms).size() == 1);
+
+    // Returning false stops a repeating timer
+    timers.pop_due(start + 1s, [](auto &) { return false; });
+    CHECK_EQ(timers.size(), 0u);
+}
+
+TEST_CASE(timer_queue, stays_ordered_under_random_cancels) {
+    queue timers;
+    std::mt19937 rng(3);
+    std::vector<int> ids;
+    std::vector<bool> cancelled;
+    for (int i = 0; i < 5000; i++) {
+        auto delay = std::chrono::milliseconds(rng() % 1000);
+        ids.push_back(add(timers, std::to_string(delay.count()), 0ms, delay));
+        cancelled.push_back(false);
+        if (rng() % 3 == 0) {
+            auto victim = rng() % ids.size();
+            if (timers.remove(ids[victim]))
+                cancelled[victim] = true;
+        }
+    }
+    // Stale heap entries of cancelled timers are compacted away
+    CHECK(timers.heap_size() <= std::max<size_t>(64, timers.size() * 2));
+
+    int last = -1;
+    size_t fired = 0;
+    timers.pop_due(start + 1s, [&](auto &t) {
+        auto deadline = std::stoi(t.value);
+        CHECK(deadline >= last);
+        last = deadline;
+        fired++;
+        return true;
+    });
+    CHECK_EQ(fired, size_t(std::count(cancelled.begin(), cancelled.end(),
+                                      false)));
+}
@@ -0,0 +1,143 @@
+#include "shell/trace.h"
+#include "test.h"
+
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using mb_shell::trace;
+
+namespace {
+// The exported events, one per line
+std::vector<std::string> export_events() {
+    std::stringstream out;
+    trace::write_json(out);
+    auto json = out.str();
+    CHECK(json.starts_with("{\"traceEvents\":[\n"));
+    CHECK(json.ends_with("\n]}\n"));
+
+    std::vector<std::string> events;
+    std::string line;
+    std::stringstream lines(json);
+    std::getline(lines, line);
+    while (std::getline(lines, line) && line != "]}") {
+        if (line.ends_with(","))
+            line.pop_back();
+        CHECK(line.starts_with("{") && line.ends_with("}"));
+        events.push_back(line);
+    }
+    return events;
+}
+
+std::vector<std::string> named(const std::vector<std::string> &events,
+                               const std::string &name) {
+    std::vector<std::string> res;
+    for (auto &event : events)
+        if (event.starts_with("{\"name\":\"" + name + "\""))
+            res.push_back(event);
+    return res;
+}
+
+double number(const std::string &event, const std::string &key) {
+    auto at = event.find("\"" + key + "\":");
+    CHECK(at != std::string::npos);
+    return std::stod(event.substr(at + key.size() + 3));
+}
+
+struct enabled_tracing {
+    enabled_tracing() { trace::set_enabled(true); }
+    ~enabled_tracing() { trace::set_enabled(false); }
+};
+} // namespace
+
+TEST_CASE(trace, exports_spans_and_counters) {
+    enabled_tracing tracing;
+    {
+        trace::span outer("test.outer");
+        trace::span inner("test.inner");
+        trace::counter("test.counter", 42.5);
+    }
+    {
+        trace::set_enabled(false);
+        trace::span skipped("test.disabled");
+        trace::set_enabled(true);
+    }
+
+    auto events = export_events();
+    auto outer = named(events, "test.outer");
+    auto inner = named(events, "test.inner");
+    auto counter = named(events, "test.counter");
+    CHECK_EQ(outer.size(), 1u);
+    CHECK_EQ(inner.size(), 1u);
+    CHECK_EQ(counter.size(), 1u);
+    CHECK(named(events, "test.disabled").empty());
+
+    CHECK(outer[0].contains("\"ph\":\"X\""));
+    CHECK(counter[0].contains("\"ph\":\"C\""));
+    CHECK(counter[0].contains("\"args\":{\"value\":42.5}"));
+    // Spans on one thread nest by time
+    CHECK(number(inner[0], "ts") >= number(outer[0], "ts"));
+    CHECK(number(inner[0], "ts") + number(inner[0], "dur") <=
+          number(outer[0], "ts") + number(outer[0], "dur"));
+    CHECK_EQ(number(inner[0], "tid"), number(outer[0], "tid"));
+}
+
+TEST_CASE(trace, names_threads) {
+    enabled_tracing tracing;
+    std::thread([] {
+        trace::set_thread_name("worker \"1\"\\\n");
+        trace::span span("test.worker");
+    }).join();
+
+    auto events = export_events();
+    auto span = named(events, "test.worker");
+    CHECK_EQ(span.size(), 1u);
+    auto tid = static_cast<uint64_t>(number(span[0], "tid"));
+    auto metadata = std::format("{{\"name\":\"thread_name\",\"ph\":\"M\","
+                                "\"pid\":{},\"tid\":{},\"args\":{{\"name\":"
+                                "\"worker \\\"1\\\"\\\\\\u000a\"}}}}",
+                                static_cast<uint64_t>(number(span[0], "pid")),
+                                tid);
+    bool found = false;
+    for (auto &event : named(events, "thread_name"))
+        found = found || event == metadata;
+    CHECK(found);
+
+    // The thread has exited, so its buffer went with that export
+    CHECK(named(export_events(), "test.worker").empty());
+}
+
+TEST_CASE(trace, keeps_the_latest_events_per_thread) {
+    enabled_tracing tracing;
+    std::thread([] {
+        for (int i = 0; i < 5000; i++)
+            trace::counter("test.ring", i);
+    }).join();
+
+    auto ring = named(export_events(), "test.ring");
+    CHECK_EQ(ring.size(), 4096u);
+    CHECK(ring.front().contains("\"value\":904}"));
+    CHECK(ring.back().contains("\"value\":4999}"));
+}
+
+TEST_CASE(trace, export_json_writes_a_file) {
+    enabled_tracing tracing;
+    { trace::span span("test.file"); }
+    auto directory =
+        std::filesystem::temp_directory_path() /
+        std::format("shell_test_trace_{}", std::random_device{}());
+    auto path = trace::export_json(directory / "traces");
+    std::ifstream file(path);
+    std::string json((std::istreambuf_iterator<char>(file)),
+                     std::istreambuf_iterator<char>());
+    file.close();
+    std::error_code ec;
+    std::filesystem::remove_all(directory, ec);
+
+    CHECK(path.filename().string().starts_with("trace-"));
+    CHECK(json.contains("{\"name\":\"test.file\",\"ph\":\"X\""));
+}
@@ -0,0 +1,177 @@
+#include "shell/translation_table.h"
+#include "test.h"
+
+#include <atomic>
+#include <chrono>
+#include <format>
+#include <map>
+#include <memory>
+#include <random>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using mb_shell::translation_table;
+
+namespace {
+using resolved_map = std::unordered_map<std::string_view, std::string_view>;
+
+std::string lookup(const translation_table &table, std::string_view key) {
+    if (auto entry = table.find(key))
+        return std::string(table.str(entry->value_offset, entry->value_size));
+    return std::string(key);
+}
+
+// The store i18n_manager::get read before the snapshot: a shared lock and
+// up to three nested map lookups
+struct locked_maps {
+    mutable std::shared_mutex mutex;
+    std::string current_lang = "zh-CN";
+    std::map<std::string, std::map<std::string, std::string>> translations;
+    std::map<std::string, std::map<std::string, std::string>>
+        plugin_translations;
+
+    std::string get(const std::string &key) const {
+        std::shared_lock lock(mutex);
+        if (auto lang = translations.find(current_lang);
+            lang != translations.end())
+            if (auto it = lang->second.find(key); it != lang->second.end())
+                return it->second;
+        if (auto lang = plugin_translations.find(current_lang);
+            lang != plugin_translations.end())
+            if (auto it = lang->second.find(key); it != lang->second.end())
+                return it->second;
+        if (current_lang != "en-US")
+            if (auto lang = translations.find("en-US");
+                lang != translations.end())
+                if (auto it = lang->second.find(key);
+                    it != lang->second.end())
+                    return it->second;
+        return key;
+    }
+};
+} // namespace
+
+TEST_CASE(translation_table, finds_every_key) {
+    std::vector<std::string> keys, values;
+    for (int i = 0; i < 1000; i++) {
+        keys.push_back(std::format("plugin{}.label.{}", i % 7, i));
+        values.push_back(std::format("Label {}", i));
+    }
+    resolved_map resolved;
+    for (size_t i = 0; i < keys.size(); i++)
+        resolved.emplace(keys[i], values[i]);
+
+    auto table = translation_table::build("en-US", false, resolved);
+    CHECK_EQ(table->lang, "en-US");
+    CHECK_EQ(table->slots.size(), 2048u);
+    for (size_t i = 0; i < keys.size(); i++)
+        CHECK_EQ(lookup(*table, keys[i]), values[i]);
+    CHECK(!table->find("plugin0.label.1000"));
+    CHECK(!table->find(""));
+}
+
+TEST_CASE(translation_table, empty_table_misses) {
+    translation_table empty;
+    CHECK(!empty.find("settings.title"));
+    CHECK(!translation_table::build("ar", true, {})->find("settings.title"));
+}
+
+TEST_CASE(translation_table, interns_identical_strings) {
+    resolved_map resolved{{"a.ok", "OK"}, {"b.ok", "OK"}, {"c.ok", "OK"}};
+    auto table = translation_table::build("en-US", false, resolved);
+    CHECK_EQ(table->pool.size(), 4u * 3 + 2);
+    auto a = table->find("a.ok"), c = table->find("c.ok");
+    CHECK(a && c && a->value_offset == c->value_offset);
+}
+
+TEST_CASE(translation_table, compiles_templates_once) {
+    resolved_map resolved{{"greet", "Hello, {name}!"},
+                          {"greet.again", "Hello, {name}!"},
+                          {"plain", "Hello"}};
+    auto table = translation_table::build("en-US", false, resolved);
+    auto greet = table->find("greet");
+    CHECK(greet && greet->segment_count == 3);
+    CHECK_EQ(table->segments.size(), 3u);
+    CHECK_EQ(table->find("plain")->segment_count, 0u);
+
+    std::pair<std::string_view, std::string_view> params[] = {{"name", "Ann"}};
+    CHECK_EQ(mb_shell::i18n_template::interpolate(
+                 table->str(greet->value_offset, greet->value_size),
+                 table->segments_of(*greet), params),
+             "Hello, Ann!");
+}
+
+// 50k keys: zh-CN has 30k of them, plugins 5k more, the rest fall back to
+// en-US; 1 in 10 lookups misses. 8 readers look up random keys at once.
+BENCHMARK(translation_table, concurrent_lookups) {
+    constexpr int keys = 50000, readers = 8, lookups = 200000;
+    locked_maps maps;
+    resolved_map resolved;
+    std::vector<std::string> names;
+    for (int i = 0; i < keys; i++) {
+        auto key = std::format("plugin{}.section.label_{}", i % 40, i);
+        names.push_back(key);
+        maps.translations["en-US"][key] = std::format("Label {}", i);
+        if (i < 30000)
+            maps.translations["zh-CN"][key] = std::format("标签 {}", i);
+        else if (i < 35000)
+            maps.plugin_translations["zh-CN"][key] = std::format("插件 {}", i);
+    }
+    for (int i = 0; i < keys; i++)
+        names.push_back(std::format("missing.label_{}", i));
+    for (auto &[key, value] : maps.translations["en-US"])
+        resolved.emplace(key, value);
+    for (auto &[key, value] : maps.plugin_translations["zh-CN"])
+        resolved.insert_or_assign(key, value);
+    for (auto &[key, value] : maps.translations["zh-CN"])
+        resolved.insert_or_assign(key, value);
+
+    std::atomic<std::shared_ptr<const translation_table>> snapshot;
+    auto build_start = std::chrono::steady_clock::now();
+    snapshot.store(translation_table::build("zh-CN", false, resolved));
+    mb_shell::test::report("build 50k-key table",
+                           std::chrono::duration<double, std::milli>(
+                               std::chrono::steady_clock::now() - build_start)
+                               .count(),
+                           "ms");
+
+    // Nine hits to one miss
+    auto key_at = [&](uint32_t r) -> const std::string & {
+        return names[r % 10 ? r % keys : keys + r % keys];
+    };
+    auto run = [&](const char *label, int threads, auto get) {
+        std::atomic<size_t> found = 0;
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> pool;
+        for (int t = 0; t < threads; t++)
+            pool.emplace_back([&, t] {
+                std::minstd_rand random(t + 1);
+                size_t local = 0;
+                for (int i = 0; i < lookups; i++)
+                    local += get(key_at(random())).size();
+                found += local;
+            });
+        for (auto &thread : pool)
+            thread.join();
+        mb_shell::test::report(
+            label,
+            std::chrono::duration<double, std::nano>(
+                std::chrono::steady_clock::now() - start)
+                    .count() /
+                (double(threads) * lookups),
+            "ns/lookup");
+        return found.load();
+    };
+
+    auto snapshot_get = [&](const std::string &key) {
+        return lookup(*snapshot.load(std::memory_order_acquire), key);
+    };
+    auto maps_get = [&](const std::string &key) { return maps.get(key); };
+    CHECK_EQ(run("nested maps, 1 reader", 1, maps_get),
+             run("snapshot, 1 reader", 1, snapshot_get));
+    CHECK_EQ(run("nested maps, 8 readers", readers, maps_get),
+             run("snapshot, 8 readers", readers, snapshot_get));
+}
@@ -0,0 +1,144 @@
+#include "shell/utf_convert.h"
+#include "test.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace mb_shell;
+
+namespace {
+std::u16string to_utf16(std::string_view in) {
+    std::u16string out(max_utf16_length(in.size()), u'\0');
+    out.resize(utf8_to_utf16(in, out));
+    return out;
+}
+
+std::string to_utf8(std::u16string_view in) {
+    std::string out(max_utf8_length(in.size()), '\0');
+    out.resize(utf16_to_utf8(in, out));
+    return out;
+}
+
+void append_utf8(std::string &out, char32_t c) {
+    if (c < 0x80) {
+        out += char(c);
+    } else if (c < 0x800) {
+        out += char(0xC0 | c >> 6);
+        out += char(0x80 | (c & 0x3F));
+    } else if (c < 0x10000) {
+        out += char(0xE0 | c >> 12);
+        out += char(0x80 | (c >> 6 & 0x3F));
+        out += char(0x80 | (c & 0x3F));
+    } else {
+        out += char(0xF0 | c >> 18);
+        out += char(0x80 | (c >> 12 & 0x3F));
+        out += char(0x80 | (c >> 6 & 0x3F));
+        out += char(0x80 | (c & 0x3F));
+    }
+}
+
+void append_utf16(std::u16string &out, char32_t c) {
+    if (c < 0x10000) {
+        out += char16_t(c);
+    } else {
+        out += char16_t(0xD800 + ((c - 0x10000) >> 10));
+        out += char16_t(0xDC00 + ((c - 0x10000) & 0x3FF));
+    }
+}
+} // namespace
+
+TEST_CASE(utf_convert, ascii) {
+    CHECK(to_utf16("").empty());
+    // Long enough for the vector path, with a tail for the scalar one
+    std::string ascii;
+    for (int i = 0; i < 100; i++)
+        ascii += char(i % 128);
+    auto wide = to_utf16(ascii);
+    CHECK_EQ(wide.size(), ascii.size());
+    for (size_t i = 0; i < ascii.size(); i++)
+        CHECK_EQ(wide[i], char16_t(ascii[i]));
+    CHECK_EQ(to_utf8(wide), ascii);
+}
+
+TEST_CASE(utf_convert, round_trips_random_text) {
+    std::mt19937 rng(1);
+    for (int i = 0; i < 20000; i++) {
+        std::string utf8;
+        std::u16string utf16;
+        auto length = rng() % 64;
+        for (size_t j = 0; j < length; j++) {
+            char32_t c;
+            switch (rng() % 4) {
+            case 0: // Runs of ASCII mixed with everything else
+                c = rng() % 0x80;
+                break;
+            case 1:
+                c = 0x80 + rng() % (0x800 - 0x80);
+                break;
+            case 2:
+                c = 0x800 + rng() % (0x10000 - 0x800);
+                if (c >= 0xD800 && c <= 0xDFFF)
+                    c = 0xFFFD;
+                break;
+            default:
+                c = 0x10000 + rng() % (0x110000 - 0x10000);
+                break;
+            }
+            append_utf8(utf8, c);
+            append_utf16(utf16, c);
+        }
+        CHECK(to_utf16(utf8) == utf16);
+        CHECK_EQ(to_utf8(utf16), utf8);
+    }
+}
+
+TEST_CASE(utf_convert, replaces_ill_formed_utf8) {
+    // Unicode 15, table 3-8: one U+FFFD per maximal ill-formed subpart
+    CHECK(to_utf16("\x61\xF1\x80\x80\xE1\x80\xC2\x62\x80\x63\x80\xBF\x64") ==
+          u"a\uFFFD\uFFFD\uFFFDb\uFFFDc\uFFFD\uFFFDd");
+    // Overlong encodings
+    CHECK(to_utf16("\xC0\xAF") == u"\uFFFD\uFFFD");
+    CHECK(to_utf16("\xE0\x80\xAF") == u"\uFFFD\uFFFD\uFFFD");
+    CHECK(to_utf16("\xF0\x80\x80\xAF") == u"\uFFFD\uFFFD\uFFFD\uFFFD");
+    // Encoded surrogates and code points past U+10FFFF
+    CHECK(to_utf16("\xED\xA0\x80") == u"\uFFFD\uFFFD\uFFFD");
+    CHECK(to_utf16("\xF4\x90\x80\x80") == u"\uFFFD\uFFFD\uFFFD\uFFFD");
+    CHECK(to_utf16("\xF5\x80") == u"\uFFFD\uFFFD");
+    // Truncated sequences, at the end and before more text
+    CHECK(to_utf16("\xE2\x82") == u"\uFFFD");
+    CHECK(to_utf16("\xF0\x9F\x98") == u"\uFFFD");
+    CHECK(to_utf16("\xE2\x82x") == u"\uFFFDx");
+    // An invalid byte right after a block of ASCII
+    CHECK(to_utf16("0123456789abcdef\xFF") == u"0123456789abcdef\uFFFD");
+}
+
+TEST_CASE(utf_convert, replaces_unpaired_surrogates) {
+    constexpr std::string_view replacement = "\xEF\xBF\xBD";
+    CHECK_EQ(to_utf8(u"\xD800"), replacement);
+    CHECK_EQ(to_utf8(u"\xDC00"), replacement);
+    CHECK_EQ(to_utf8(std::u16string{u'\xD800', u'a'}),
+             std::string(replacement) + "a");
+    CHECK_EQ(to_utf8(std::u16string{u'\xDC00', u'\xD800'}),
+             std::string(replacement) + std::string(replacement));
+    CHECK_EQ(to_utf8(u"\xD83D\xDE00"), "\xF0\x9F\x98\x80");
+}
+
+TEST_CASE(utf_convert, output_fits_the_maximum_length) {
+    std::mt19937 rng(2);
+    for (int i = 0; i < 20000; i++) {
+        std::string bytes(rng() % 40, '\0');
+        for (auto &b : bytes)
+            b = char(rng());
+        auto wide = to_utf16(bytes);
+        CHECK(wide.size() <= max_utf16_length(bytes.size()));
+
+        std::u16string units(rng() % 40, u'\0');
+        for (auto &u : units)
+            u = char16_t(rng() % 4 ? rng() % 0x10000 : 0xD800 + rng() % 0x800);
+        CHECK(to_utf8(units).size() <= max_utf8_length(units.size()));
+        // Whatever came in, what comes out is well-formed
+        CHECK(to_utf16(to_utf8(units)).size() <= units.size());
+        CHECK_EQ(to_utf8(to_utf16(to_utf8(units))), to_utf8(units));
+    }
+}
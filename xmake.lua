@@ -7,6 +7,12 @@ option("asan")
     set_description("Enable AddressSanitizer (ASan) support")
 option_end()
 
+option("dbgout")
+    set_default(true)
+    set_showmenu(true)
+    set_description("Compile in dbgout debug logging")
+option_end()
+
 set_exceptions("cxx")
 set_languages("c++2b")
 set_warnings("all") 
@@ -25,6 +31,10 @@ if has_config("asan") then
     add_defines("_DISABLE_VECTOR_ANNOTATION", "_DISABLE_STRING_ANNOTATION", "_ASAN_")
 end
 
+if not has_config("dbgout") then
+    add_defines("BREEZE_NO_DBGOUT")
+end
+
 add_requires("yalantinglibs b82a21925958b6c50deba3aa26a2737cdb814e27", {
     configs = {
         ssl = true
@@ -41,6 +51,71 @@ add_requireconfs("**.async_simple", {
     version = "18f3882be354d407af0f0674121dcddaeff36e26"
 })
 
+-- Defines BREEZE_QJS_BUILD_ID, a hash of the vendored QuickJS sources.
+-- Serialized bytecode is only readable by the build that wrote it, and
+-- JS_GetVersion() stays the same when those sources are patched.
+rule("qjs.build_id")
+    on_config(function (target)
+        local digests = {}
+        for _, file in ipairs(os.files(path.join(os.projectdir(), "src/shell/script/quickjs/*"))) do
+            table.insert(digests, path.filename(file) .. " " .. hash.sha256(file))
+        end
+        table.sort(digests)
+
+        local digestdir = path.join(target:autogendir(), "rules", "qjs")
+        if not os.isdir(digestdir) then
+            os.mkdir(digestdir)
+        end
+        local digestfile = path.join(digestdir, "sources.sha256")
+        io.writefile(digestfile, table.concat(digests, "\n"))
+        target:add("defines", "BREEZE_QJS_BUILD_ID=\"" .. hash.sha256(digestfile):sub(1, 16) .. "\"")
+    end)
+rule_end()
+
+-- Compiles .js modules to QuickJS bytecode with breeze-qjsc and exposes them
+-- as <file>.bytecode.h, the way utils.bin2c exposes raw files. The module
+-- name and C symbol come from the file config of add_files.
+rule("qjs.bytecode")
+    set_extensions(".js")
+    on_load(function (target)
+        local headerdir = path.join(target:autogendir(), "rules", "qjs", "bytecode")
+        if not os.isdir(headerdir) then
+            os.mkdir(headerdir)
+        end
+        target:add("includedirs", headerdir)
+    end)
+    before_buildcmd_file(function (target, batchcmds, sourcefile, opt)
+        local qjsc = target:dep("breeze-qjsc")
+        local headerdir = path.join(target:autogendir(), "rules", "qjs", "bytecode")
+        local headerfile = path.join(headerdir, path.filename(sourcefile) .. ".bytecode.h")
+
+        batchcmds:show_progress(opt.progress, "${color.build.object}compiling.qjs %s", sourcefile)
+        batchcmds:mkdir(headerdir)
+        local fileconfig = target:fileconfig(sourcefile) or {}
+        local module_name = fileconfig.module_name or path.filename(sourcefile)
+        local symbol = fileconfig.symbol or (path.basename(sourcefile) .. "_bytecode")
+        batchcmds:vrunv(qjsc:targetfile(), {path(sourcefile), path(headerfile), module_name, symbol})
+
+        -- Rebuild when either the script or the compiler (and so the QuickJS
+        -- version) changes
+        batchcmds:add_depfiles(sourcefile, qjsc:targetfile())
+        batchcmds:set_depmtime(os.mtime(headerfile))
+        batchcmds:set_depcache(target:dependfile(headerfile))
+    end)
+rule_end()
+
+-- Host-side compiler for the embedded script runtime, built from the same
+-- QuickJS sources as the shell
+target("breeze-qjsc")
+    set_kind("binary")
+    set_default(false)
+    set_plat(os.host())
+    set_arch(os.arch())
+    add_rules("qjs.build_id")
+    add_includedirs("src/", "src/shell/script/quickjs")
+    add_files("src/qjsc/*.cc", "src/shell/script/quickjs/*.c")
+    set_encodings("utf-8")
+
 target("ui_test")
     set_default(false)
     set_kind("binary")
@@ -49,6 +124,85 @@ target("ui_test")
     set_encodings("utf-8")
     add_tests("defualt")
 
+-- Unit tests for the parts of the shell that don't need Windows or a live
+-- explorer; `xmake test shell_test/*` runs each suite as its own test
+target("shell_test")
+    set_default(false)
+    set_kind("binary")
+    add_includedirs("src/")
+    add_files("src/shell_test/main.cc", "src/shell_test/logger_env.cc")
+    set_encodings("utf-8")
+    -- Benchmarks read inputs from the source tree, e.g. script.js
+    set_rundir("$(projectdir)")
+
+    add_files("src/shell_test/i18n_template_test.cc", "src/shell/i18n_template.cc")
+    add_tests("i18n_template", {runargs = "i18n_template"})
+
+    add_files("src/shell_test/translation_table_test.cc", "src/shell/translation_table.cc")
+    add_tests("translation_table", {runargs = "translation_table"})
+
+    add_packages("reflect-cpp")
+    add_files("src/shell_test/locale_cache_test.cc", "src/shell/locale_cache.cc")
+    add_tests("locale_cache", {runargs = "locale_cache"})
+
+    add_files("src/shell_test/color_parser_test.cc")
+    add_tests("color_parser", {runargs = "color_parser"})
+
+    add_files("src/shell_test/enum_names_test.cc")
+    add_tests("enum_names", {runargs = "enum_names"})
+
+    add_files("src/shell_test/task_queue_test.cc", "src/shell/task_queue.cc")
+    add_tests("task_queue", {runargs = "task_queue"})
+
+    add_files("src/shell_test/utf_convert_test.cc", "src/shell/utf_convert.cc")
+    add_tests("utf_convert", {runargs = "utf_convert"})
+
+    add_files("src/shell_test/timer_queue_test.cc")
+    add_tests("timer_queue", {runargs = "timer_queue"})
+
+    add_files("src/shell_test/file_reloader_test.cc", "src/shell/file_reloader.cc")
+    add_tests("file_reloader", {runargs = "file_reloader"})
+
+    add_files("src/shell_test/versioned_snapshot_test.cc")
+    add_tests("versioned_snapshot", {runargs = "versioned_snapshot"})
+
+    add_files("src/shell_test/trace_test.cc", "src/shell/trace.cc")
+    add_tests("trace", {runargs = "trace"})
+
+    add_files("src/shell_test/log_sink_test.cc", "src/shell/log_sink.cc")
+    add_tests("log_sink", {runargs = "log_sink"})
+
+    add_files("src/shell_test/async_pool_test.cc", "src/shell/script/async_pool.cc")
+    add_tests("async_pool", {runargs = "async_pool"})
+
+    -- QuickJS and its C++ wrapper, for the script runtime suites
+    add_defines("NOMINMAX", "WIN32_LEAN_AND_MEAN")
+    add_includedirs("src/shell/script/quickjs")
+    add_files("src/shell/script/quickjs/*.c", "src/shell/script/quickjspp.cc",
+              "src/shell_test/script_env.cc")
+
+    add_files("src/shell_test/js_context_test.cc", "src/shell/script/js_arena.cc")
+    add_tests("js_context", {runargs = "js_context"})
+
+    add_files("src/shell_test/event_loop_test.cc")
+    add_tests("event_loop", {runargs = "event_loop"})
+
+    add_files("src/shell_test/menu_listener_watchdog_test.cc", "src/shell/script/menu_listener_watchdog.cc")
+    add_tests("menu_listener_watchdog", {runargs = "menu_listener_watchdog"})
+
+    add_files("src/shell_test/plugin_modules_test.cc", "src/shell/script/plugin_modules.cc")
+    add_tests("plugin_modules", {runargs = "plugin_modules"})
+
+    add_files("src/shell_test/js_profiler_test.cc", "src/shell/script/js_profiler.cc")
+    add_tests("js_profiler", {runargs = "js_profiler"})
+
+    add_rules("qjs.build_id")
+    add_files("src/shell_test/bytecode_cache_test.cc", "src/shell/script/bytecode_cache.cc")
+    add_tests("bytecode_cache", {runargs = "bytecode_cache"})
+
+    add_files("src/shell_test/script_bytecode_test.cc")
+    add_tests("script_bytecode", {runargs = "script_bytecode"})
+
 target("shell")
     set_kind("shared")
     add_headerfiles("src/shell/**.h")
@@ -61,9 +215,11 @@ target("shell")
     add_defines("NOMINMAX", "WIN32_LEAN_AND_MEAN")
     add_packages("blook", "reflect-cpp", "wintoast", "cpptrace", "yalantinglibs", "breeze-ui")
     add_syslinks("oleacc", "ole32", "oleaut32", "uuid", "comctl32", "comdlg32", "gdi32", "user32", "shell32", "kernel32", "advapi32", "psapi", "Winhttp", "dbghelp")
+    add_deps("breeze-qjsc")
     add_rules("utils.bin2c", {
-        extensions = {".js", ".json"}
+        extensions = {".json"}
     })
+    add_rules("qjs.build_id", "qjs.bytecode")
     add_files("resources/locales/en-US.json", "resources/locales/zh-CN.json")
     set_version(version)
     set_configdir("src/shell")
@@ -82,7 +238,10 @@ target("shell")
             os.exec(cmd)
         end
     end)
-    add_files("src/shell/script/script.js")
+    add_files("src/shell/script/script.js", {
+        module_name = "breeze-script.js",
+        symbol = "breeze_script_bytecode"
+    })
     add_files("src/shell/**.cc", "src/shell/**.c")
     set_encodings("utf-8")
 